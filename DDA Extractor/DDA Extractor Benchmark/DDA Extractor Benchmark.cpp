@@ -0,0 +1,516 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <sstream>
+#include <filesystem>
+#include <chrono>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "DDA Extractor/dda_file_parser.h"
+#include "DDA Extractor/dda_manager.h"
+#include "DDA Extractor/glb_exporter.h"
+#include "DDA Extractor/texture_dumper.h"
+#include "DDA Extractor/mesh_generator.h"
+#include "DDA Extractor/mapped_file.h"
+#include "DDA Extractor/fixture_generator.h"
+#include "DDA Extractor/clut_expander.h"
+#include "DDA Extractor/png_writer.h"
+#include "DDA Extractor/bc_encoder.h"
+
+// Work done by one iteration of a benchmark, used to compute the rates
+struct BenchmarkWork
+{
+	double bytes = 0;
+	double textures = 0;
+	double triangles = 0;
+};
+
+struct BenchmarkResult
+{
+	std::string name;
+	size_t iterations = 0;
+	double bestSeconds = 0;
+	double meanSeconds = 0;
+	BenchmarkWork work;
+};
+
+void ShowUsage()
+{
+	std::cout << "" << std::endl;
+
+	std::cout << "Usage: DDA_Extractor_Benchmark.exe [options]" << std::endl;
+	std::cout << "Measure the speed of the extractor hot paths on generated game files and print the results as JSON." << std::endl;
+	std::cout << "" << std::endl;
+	std::cout << "Options:" << std::endl;
+	std::cout << "  --iterations <count>  Number of timed runs of each benchmark, the best run is used for the rates (default: 10)" << std::endl;
+	std::cout << "  --scale <scale>       Size of the generated files, 1 is about the size of the game files (default: 1)" << std::endl;
+	std::cout << "  --fixtures <path>     Folder where the generated files are written (default: temporary folder)" << std::endl;
+	std::cout << "  --output <file>       Write the JSON in this file instead of the console" << std::endl;
+}
+
+/**
+* @brief Run the function once to warm up the caches, then time each run
+*/
+template<typename Function>
+BenchmarkResult RunBenchmark(const std::string& name, size_t iterations, const BenchmarkWork& work, Function&& function)
+{
+	BenchmarkResult result;
+	result.name = name;
+	result.iterations = iterations;
+	result.work = work;
+
+	function();
+
+	double totalSeconds = 0;
+	for (size_t i = 0; i < iterations; i++)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		function();
+		const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		totalSeconds += seconds;
+		if (i == 0 || seconds < result.bestSeconds)
+		{
+			result.bestSeconds = seconds;
+		}
+	}
+	result.meanSeconds = iterations == 0 ? 0 : totalSeconds / iterations;
+
+	return result;
+}
+
+std::string ToJson(const std::vector<BenchmarkResult>& results, size_t iterations, float scale)
+{
+	std::ostringstream json;
+	json << "{\n";
+	json << "\t\"instruction_set\": \"" << ClutExpander::GetInstructionSetName() << "\",\n";
+	json << "\t\"fixture_scale\": " << scale << ",\n";
+	json << "\t\"iterations\": " << iterations << ",\n";
+	json << "\t\"benchmarks\": [\n";
+	for (size_t i = 0; i < results.size(); i++)
+	{
+		const BenchmarkResult& result = results[i];
+		const double seconds = result.bestSeconds > 0 ? result.bestSeconds : 1e-9;
+
+		json << "\t\t{\n";
+		json << "\t\t\t\"name\": \"" << result.name << "\",\n";
+		json << "\t\t\t\"best_seconds\": " << result.bestSeconds << ",\n";
+		json << "\t\t\t\"mean_seconds\": " << result.meanSeconds << ",\n";
+		json << "\t\t\t\"mb_per_second\": " << result.work.bytes / 1000000.0 / seconds;
+		if (result.work.textures > 0)
+		{
+			json << ",\n\t\t\t\"textures_per_second\": " << result.work.textures / seconds;
+		}
+		if (result.work.triangles > 0)
+		{
+			json << ",\n\t\t\t\"triangles_per_second\": " << result.work.triangles / seconds;
+		}
+		json << "\n\t\t}" << (i + 1 < results.size() ? "," : "") << "\n";
+	}
+	json << "\t]\n";
+	json << "}\n";
+
+	return json.str();
+}
+
+/**
+* @brief Unswizzle the same random palettes with every palette and fix type
+*/
+void BenchmarkFixedPalettes(std::vector<BenchmarkResult>& results, size_t iterations)
+{
+	// Car skins have two palettes of 256 colors
+	const size_t paletteCount = 4096;
+	const size_t paletteSize = 512 * sizeof(uint32_t);
+	std::vector<uint8_t> palettes(paletteCount * paletteSize);
+	std::mt19937 random(0);
+	for (uint8_t& value : palettes)
+	{
+		value = static_cast<uint8_t>(random());
+	}
+
+	struct PaletteBenchmark
+	{
+		std::string name;
+		DDAClutType clutType;
+		DDAClutFixType fixType;
+	};
+	const PaletteBenchmark paletteBenchmarks[] =
+	{
+		{ "get_fixed_palette/clut_16", DDAClutType::CLUT_16, DDAClutFixType::CLUT_NORMAL },
+		{ "get_fixed_palette/clut_256", DDAClutType::CLUT_256, DDAClutFixType::CLUT_NORMAL },
+		{ "get_fixed_palette/car_skin", DDAClutType::CLUT_256, DDAClutFixType::CLUT_CAR_SKIN },
+		{ "get_fixed_palette/broken_car_skin", DDAClutType::CLUT_256, DDAClutFixType::CLUT_BROKEN_CAR_SKIN },
+	};
+
+	DDAFileParser fileParser;
+	for (const PaletteBenchmark& paletteBenchmark : paletteBenchmarks)
+	{
+		const size_t colorCount = paletteBenchmark.clutType == DDAClutType::CLUT_16 ? 16 : 256;
+
+		BenchmarkWork work;
+		work.bytes = static_cast<double>(paletteCount * colorCount * sizeof(uint32_t));
+		work.textures = static_cast<double>(paletteCount);
+
+		// Keep the compiler from removing the work
+		volatile uint8_t lastColorByte = 0;
+		results.push_back(RunBenchmark(paletteBenchmark.name, iterations, work, [&]()
+			{
+				for (size_t i = 0; i < paletteCount; i++)
+				{
+					const std::unique_ptr<uint8_t[]> fixedPalette = fileParser.GetFixedPalette(palettes.data() + i * paletteSize, paletteBenchmark.clutType, paletteBenchmark.fixType);
+					lastColorByte = fixedPalette[colorCount * sizeof(uint32_t) - 1];
+				}
+			}));
+	}
+}
+
+/**
+* @brief Decode all textures of a file
+*/
+void BenchmarkTextureCopy(std::vector<BenchmarkResult>& results, size_t iterations, const DDAExtractedData& data)
+{
+	BenchmarkWork work;
+	for (const DDATextureCopyParams& params : data.textureCopyParamsList)
+	{
+		if (params.clutType != DDAClutType::CLUT_NONE)
+		{
+			work.bytes += static_cast<double>(params.exportWidth * params.exportHeight * sizeof(uint32_t));
+			work.textures++;
+		}
+	}
+
+	TextureDumper textureDumper;
+	results.push_back(RunBenchmark("copy_texture_data", iterations, work, [&]()
+		{
+			for (const DDATextureCopyParams& params : data.textureCopyParamsList)
+			{
+				textureDumper.CopyTextureData(params);
+			}
+		}));
+}
+
+/**
+* @brief Convert all textures of a file to RGBA pixels, kept for the encoding benchmarks (the extraction converts them one by one when they are dumped)
+*/
+std::vector<std::vector<uint8_t>> DecodeTextures(const DDAExtractedData& data)
+{
+	TextureDumper textureDumper;
+	std::vector<std::vector<uint8_t>> decodedTextures;
+	decodedTextures.reserve(data.textureCopyParamsList.size());
+	for (const DDATextureCopyParams& params : data.textureCopyParamsList)
+	{
+		const uint8_t* pixels = textureDumper.CopyTextureData(params);
+		decodedTextures.emplace_back(pixels, pixels + params.exportWidth * params.exportHeight * sizeof(uint32_t));
+	}
+	return decodedTextures;
+}
+
+/**
+* @brief Encode all textures of a file with each png compression
+* @param decodedTextures Pixels of the textures, see DecodeTextures
+*/
+void BenchmarkPngEncoding(std::vector<BenchmarkResult>& results, size_t iterations, const DDAExtractedData& data, const std::vector<std::vector<uint8_t>>& decodedTextures, const std::string& exportFolder)
+{
+	BenchmarkWork work;
+	for (const DDATextureCopyParams& params : data.textureCopyParamsList)
+	{
+		work.bytes += static_cast<double>(params.exportWidth * params.exportHeight * sizeof(uint32_t));
+		work.textures++;
+	}
+
+	struct PngBenchmark
+	{
+		const char* name;
+		DDAPngCompression compression;
+		size_t jobCount;
+	};
+	const PngBenchmark pngBenchmarks[] =
+	{
+		{ "png_encode_default", DDAPngCompression::DEFAULT, 1 },
+		{ "png_encode_stored", DDAPngCompression::STORED, 1 },
+		{ "png_encode_fast", DDAPngCompression::FAST, 1 },
+		{ "png_encode_max", DDAPngCompression::MAX, 1 },
+		{ "png_encode_max_parallel", DDAPngCompression::MAX, 0 },
+	};
+
+	// All textures are written in the same file, only the encoding speed is measured
+	const std::string filePath = exportFolder + "png_benchmark.png";
+	for (const PngBenchmark& pngBenchmark : pngBenchmarks)
+	{
+		PngWriter pngWriter(pngBenchmark.compression, pngBenchmark.jobCount);
+		const size_t pngIterations = pngBenchmark.compression == DDAPngCompression::MAX ? std::min<size_t>(iterations, 3) : iterations;
+		results.push_back(RunBenchmark(pngBenchmark.name, pngIterations, work, [&]()
+			{
+				for (size_t textureIndex = 0; textureIndex < data.textureCopyParamsList.size(); textureIndex++)
+				{
+					const DDATextureCopyParams& params = data.textureCopyParamsList[textureIndex];
+					pngWriter.WriteRgba(filePath, decodedTextures[textureIndex].data(), params.exportWidth, params.exportHeight);
+				}
+			}));
+	}
+}
+
+/**
+* @brief Write all textures of a file in the formats made for quick iterations
+* @param decodedTextures Pixels of the textures, see DecodeTextures
+*/
+void BenchmarkIterationFormats(std::vector<BenchmarkResult>& results, size_t iterations, const DDAExtractedData& data, const std::vector<std::vector<uint8_t>>& decodedTextures, const std::string& exportFolder)
+{
+	BenchmarkWork work;
+	for (const DDATextureCopyParams& params : data.textureCopyParamsList)
+	{
+		work.bytes += static_cast<double>(params.exportWidth * params.exportHeight * sizeof(uint32_t));
+		work.textures++;
+	}
+
+	QoiWriter qoiWriter;
+	const std::string qoiFilePath = exportFolder + "qoi_benchmark.qoi";
+	results.push_back(RunBenchmark("qoi_encode", iterations, work, [&]()
+		{
+			for (size_t textureIndex = 0; textureIndex < data.textureCopyParamsList.size(); textureIndex++)
+			{
+				const DDATextureCopyParams& params = data.textureCopyParamsList[textureIndex];
+				qoiWriter.WriteRgba(qoiFilePath, decodedTextures[textureIndex].data(), params.exportWidth, params.exportHeight);
+			}
+		}));
+
+	// Indices are written without decoding them, like during an extraction
+	DDATextureExportOptions rawOptions;
+	rawOptions.textureFormat = DDATextureFormat::RAW;
+	TextureDumper rawTextureDumper(rawOptions);
+	const std::string rawFilePath = exportFolder + "raw_benchmark.ddat";
+	results.push_back(RunBenchmark("texture_dump_raw", iterations, work, [&]()
+		{
+			for (const DDATextureCopyParams& params : data.textureCopyParamsList)
+			{
+				rawTextureDumper.DumpTexture(params, rawFilePath);
+			}
+		}));
+}
+
+/**
+* @brief Compress all textures of a file to the block formats
+* @param decodedTextures Pixels of the textures, see DecodeTextures
+*/
+void BenchmarkBlockCompression(std::vector<BenchmarkResult>& results, size_t iterations, const DDAExtractedData& data, const std::vector<std::vector<uint8_t>>& decodedTextures)
+{
+	BenchmarkWork work;
+	size_t biggestSize = 0;
+	for (const DDATextureCopyParams& params : data.textureCopyParamsList)
+	{
+		work.bytes += static_cast<double>(params.exportWidth * params.exportHeight * sizeof(uint32_t));
+		work.textures++;
+		biggestSize = std::max(biggestSize, BcEncoder::GetLevelSize(params.exportWidth, params.exportHeight, DDAPixelFormat::BC7));
+	}
+
+	struct BlockBenchmark
+	{
+		const char* name;
+		DDAPixelFormat format;
+		size_t jobCount;
+	};
+	const BlockBenchmark blockBenchmarks[] =
+	{
+		{ "bc1_encode", DDAPixelFormat::BC1, 1 },
+		{ "bc3_encode", DDAPixelFormat::BC3, 1 },
+		{ "bc7_encode", DDAPixelFormat::BC7, 1 },
+		{ "bc7_encode_parallel", DDAPixelFormat::BC7, 0 },
+	};
+
+	std::vector<uint8_t> blocks(biggestSize);
+	for (const BlockBenchmark& blockBenchmark : blockBenchmarks)
+	{
+		results.push_back(RunBenchmark(blockBenchmark.name, iterations, work, [&]()
+			{
+				for (size_t textureIndex = 0; textureIndex < data.textureCopyParamsList.size(); textureIndex++)
+				{
+					const DDATextureCopyParams& params = data.textureCopyParamsList[textureIndex];
+					BcEncoder::Compress(decodedTextures[textureIndex].data(), params.exportWidth, params.exportHeight, blockBenchmark.format, blockBenchmark.jobCount, blocks.data());
+				}
+			}));
+	}
+}
+
+/**
+* @brief Find the mesh packets of a file, build the meshes and export them
+*/
+void BenchmarkMeshes(std::vector<BenchmarkResult>& results, size_t iterations, const std::string& filePath, const DDAExtractedData& data, const std::string& exportFolder)
+{
+	MappedFile mappedFile;
+	if (!mappedFile.Open(filePath))
+	{
+		std::cout << "[ERROR] File not opened: " + filePath << std::endl;
+		return;
+	}
+
+	const uint8_t* fileData = mappedFile.GetData();
+	const DDAGameFileType fileType = *(DDAGameFileType*)fileData;
+	MeshGenerator meshGenerator;
+
+	// The packet search walks through the VIF packet lists
+	BenchmarkWork scanWork;
+	for (const DDAPacketAndTextureEntry& entry : data.packetAndTextureEntryList)
+	{
+		scanWork.bytes += *(uint16_t*)(fileData + entry.vifPacketListAddr + GetHeaderOffset(fileType)) * 16.0;
+	}
+
+	const std::vector<DDAFileMeshDataInfo> meshDataInfos = meshGenerator.GetMeshDataInfos(fileType, fileData, data.packetAndTextureEntryList, false);
+	results.push_back(RunBenchmark("get_mesh_data_infos", iterations, scanWork, [&]()
+		{
+			meshGenerator.GetMeshDataInfos(fileType, fileData, data.packetAndTextureEntryList, false);
+		}));
+
+	// Positions, uvs and colors or normals are read for each vertex
+	BenchmarkWork meshWork;
+	for (const DDAMesh& mesh : data.meshes)
+	{
+		meshWork.triangles += static_cast<double>(mesh.subMeshes[0].verticesPositions.size() / 3);
+	}
+	for (const DDAFileMeshDataInfo& meshDataInfo : meshDataInfos)
+	{
+		meshWork.bytes += static_cast<double>(meshDataInfo.vertexCount * (3 * sizeof(uint16_t) + 2 * sizeof(uint16_t) + 3 * sizeof(uint8_t)));
+	}
+
+	results.push_back(RunBenchmark("generate_mesh_from_vif_packet", iterations, meshWork, [&]()
+		{
+			for (const DDAFileMeshDataInfo& meshDataInfo : meshDataInfos)
+			{
+				meshGenerator.GenerateMeshFromVifPacket(meshDataInfo, data.packetAndTextureEntryList, fileData, fileType);
+			}
+		}));
+
+	// The FBX export is slow, a few runs are enough
+	DDAManager ddaManager = DDAManager("");
+	BenchmarkWork exportWork;
+	exportWork.triangles = meshWork.triangles;
+	ddaManager.CreateFXBMesh(data.meshes, data.materials, exportFolder);
+	std::error_code error;
+	const uintmax_t fbxFileSize = std::filesystem::file_size(exportFolder + "output.fbx", error);
+	exportWork.bytes = error ? 0 : static_cast<double>(fbxFileSize);
+
+	results.push_back(RunBenchmark("create_fbx_mesh", std::min<size_t>(iterations, 3), exportWork, [&]()
+		{
+			ddaManager.CreateFXBMesh(data.meshes, data.materials, exportFolder);
+		}));
+
+	BenchmarkWork glbExportWork;
+	glbExportWork.triangles = meshWork.triangles;
+	GlbExporter::Export(data.meshes, data.materials, exportFolder + "output.glb");
+	const uintmax_t glbFileSize = std::filesystem::file_size(exportFolder + "output.glb", error);
+	glbExportWork.bytes = error ? 0 : static_cast<double>(glbFileSize);
+
+	results.push_back(RunBenchmark("create_glb_mesh", iterations, glbExportWork, [&]()
+		{
+			GlbExporter::Export(data.meshes, data.materials, exportFolder + "output.glb");
+		}));
+}
+
+int main(int argc, char* argv[])
+{
+	size_t iterations = 10;
+	float scale = 1;
+	std::string fixturesPath = (std::filesystem::temp_directory_path() / "DDA Extractor Benchmark").string();
+	std::string outputPath;
+
+	for (int i = 1; i < argc; i++)
+	{
+		const std::string argument = argv[i];
+		if (i + 1 >= argc)
+		{
+			std::cout << "[ERROR] Missing value for " << argument << "\n";
+			ShowUsage();
+			return 1;
+		}
+
+		const std::string value = argv[++i];
+		try
+		{
+			if (argument == "--iterations")
+			{
+				iterations = std::stoul(value);
+			}
+			else if (argument == "--scale")
+			{
+				scale = std::stof(value);
+			}
+			else if (argument == "--fixtures")
+			{
+				fixturesPath = value;
+			}
+			else if (argument == "--output")
+			{
+				outputPath = value;
+			}
+			else
+			{
+				std::cout << "Unknown argument: " << argument << "\n";
+				ShowUsage();
+				return 1;
+			}
+		}
+		catch (const std::exception&)
+		{
+			std::cout << "[ERROR] Invalid value for " << argument << ": " << value << "\n";
+			ShowUsage();
+			return 1;
+		}
+	}
+
+	if (iterations == 0 || scale <= 0)
+	{
+		ShowUsage();
+		return 1;
+	}
+
+	if (fixturesPath.back() != '\\' && fixturesPath.back() != '/')
+	{
+		fixturesPath += "\\";
+	}
+
+	// The biggest track, it has the most mesh packets
+	const DDAGameFile gameFile = DDAGameFile::DAM;
+	DDAFixtureGenerator fixtureGenerator;
+	DDAFixtureExpectations expectations;
+	if (!fixtureGenerator.GenerateFile(fixturesPath, gameFile, scale, expectations))
+	{
+		return 1;
+	}
+
+	const std::string filePath = fixturesPath + filesNames[(int)gameFile];
+	DDAFileParser fileParser;
+	const DDAExtractedData data = fileParser.LoadFile(filePath, gameFile, "");
+	if (data.meshes.size() != expectations.meshPacketCount)
+	{
+		std::cout << "[ERROR] Wrong mesh packet count in " + filePath << std::endl;
+		return 1;
+	}
+
+	std::vector<BenchmarkResult> results;
+	BenchmarkFixedPalettes(results, iterations);
+	BenchmarkTextureCopy(results, iterations, data);
+	const std::vector<std::vector<uint8_t>> decodedTextures = DecodeTextures(data);
+	BenchmarkPngEncoding(results, iterations, data, decodedTextures, fixturesPath);
+	BenchmarkIterationFormats(results, iterations, data, decodedTextures, fixturesPath);
+	BenchmarkBlockCompression(results, iterations, data, decodedTextures);
+	BenchmarkMeshes(results, iterations, filePath, data, fixturesPath);
+
+	const std::string json = ToJson(results, iterations, scale);
+	if (outputPath.empty())
+	{
+		std::cout << json;
+	}
+	else
+	{
+		std::ofstream outputFile(outputPath, std::ios::out | std::ios::trunc);
+		if (!outputFile.is_open())
+		{
+			std::cout << "[ERROR] File not created: " + outputPath << std::endl;
+			return 1;
+		}
+		outputFile << json;
+	}
+
+	return 0;
+}
\ No newline at end of file
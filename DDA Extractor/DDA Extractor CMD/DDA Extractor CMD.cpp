@@ -1,55 +1,347 @@
 #include <iostream>
+#include <fstream>
 #include <filesystem>
+#include <algorithm>
+#include <vector>
+#include <thread>
 
 #include "DDA Extractor/dda_manager.h"
+#include "DDA Extractor/worker_pool.h"
+#include "DDA Extractor/dda_file_parser.h"
+#include "DDA Extractor/fixture_generator.h"
+#include "DDA Extractor/extraction_stats.h"
+#include "DDA Extractor/trace_recorder.h"
 
 void ShowUsage()
 {
 	std::cout << "" << std::endl;
 
-	std::cout << "Usage: DDA_Extractor.exe <input_path> <output_path>" << std::endl;
-	std::cout << "Example: DDA_Extractor.exe \"C:\\path\\to\\dda_folder\" \"C:\\path\\to\\output\"" << std::endl;
+	std::cout << "Usage: DDA_Extractor.exe <input_path> <output_path> [options]" << std::endl;
+	std::cout << "Example: DDA_Extractor.exe \"C:\\path\\to\\dda_folder\" \"C:\\path\\to\\output\" --jobs 8" << std::endl;
 	std::cout << "The input_path should contains the content of the game (TRACKS, FLASH folders, INGAME.UBR, SPRITES.UBR files...) " << std::endl;
 	std::cout << "Do not include the \\ at the end of the input_path and output_path." << std::endl;
+	std::cout << "" << std::endl;
+	std::cout << "Options:" << std::endl;
+	std::cout << "  --jobs <count>          Number of files extracted at the same time (0 = one per CPU thread, default: 1)" << std::endl;
+	std::cout << "  --texture-jobs <count>  Number of threads used to dump the textures of a file (0 = one per CPU thread, default: CPU threads / jobs)" << std::endl;
+	std::cout << "  --stats <file>          Write the time spent in each extraction step and counters (packets, triangles, bytes written...) as JSON" << std::endl;
+	std::cout << "  --trace <file>          Write a timeline of the extraction, open it in ui.perfetto.dev or chrome://tracing" << std::endl;
+	std::cout << "  --mesh-format <format>  Format of the meshes file: fbx (default) or glb (faster, written without Assimp)" << std::endl;
+	std::cout << "  --indexed-png           Write the textures with their palette (4 or 8 bits png) instead of RGBA, files are smaller" << std::endl;
+	std::cout << "  --png-compression <mode> default, stored (no compression), fast (quick iterations) or max (smallest files)" << std::endl;
+	std::cout << "  --texture-format <format> png (default), qoi (quick iterations), raw (indices and palettes as in the game files)," << std::endl;
+	std::cout << "                          dds or ktx2 (with the mipmaps of the textures)," << std::endl;
+	std::cout << "                          the meshes only use png textures (and dds textures with the fbx format)" << std::endl;
+	std::cout << "  --block-compression <mode> none (default), bc1-bc3 (BC1 for opaque textures, BC3 for the others) or bc7," << std::endl;
+	std::cout << "                          for the dds and ktx2 formats" << std::endl;
+	std::cout << "  --force                 Extract all files again, even the ones whose manifest.json says they did not change" << std::endl;
+	std::cout << "  --no-texture-dedup      Write every texture, by default a texture already written for another file is hardlinked" << std::endl;
+	std::cout << "  --texture-atlas         Also pack the textures of the meshes in atlases (atlases folder), the meshes use them" << std::endl;
+	std::cout << "                          instead of one material per texture, except where their UVs repeat the texture" << std::endl;
+	std::cout << "  --used-textures-only    Only write the textures used by the meshes of the maps and cars (see texture_usage.json)," << std::endl;
+	std::cout << "                          the skybox textures are not used by the extracted meshes" << std::endl;
+	std::cout << "" << std::endl;
+	std::cout << "Fixtures (fake game files to test the extractor without the game):" << std::endl;
+	std::cout << "Usage: DDA_Extractor.exe --generate-fixtures <output_path> [--fixture-scale <scale>] [--fixture-file <name>]" << std::endl;
+	std::cout << "  --generate-fixtures <path>  Generate the files in this folder and check them with the parser" << std::endl;
+	std::cout << "  --fixture-scale <scale>     Multiply the texture and mesh count of the files (default: 1, about the size of the game files)" << std::endl;
+	std::cout << "  --fixture-file <name>       Only generate this file (DAM, CLOWN, SPRITES, DD4FRONT...)" << std::endl;
 }
 
-void LaunchExtraction(const std::string& inputPath, const std::string& outputPath);
+void LaunchExtraction(const std::string& inputPath, const std::string& outputPath, size_t jobCount, size_t textureJobCount, bool forceExtraction, bool textureDeduplication, bool textureAtlas, bool usedTexturesOnly, DDAMeshFormat meshFormat, const DDATextureExportOptions& textureExportOptions);
+bool GenerateFixtures(const std::string& outputPath, float scale, const std::string& fileName);
 
-int main(int argc, char* argv[])
+/**
+* @brief Read the value of a count option, like "--jobs 8"
+* @return False if the value is missing or invalid
+*/
+bool ReadCountArgument(int argc, char* argv[], int& argumentIndex, size_t& value)
 {
-	if (argc > 3)
+	const std::string argument = argv[argumentIndex];
+	if (argumentIndex + 1 >= argc)
 	{
-		ShowUsage();
-		return 1;
+		std::cout << "[ERROR] Missing value for " << argument << "\n";
+		return false;
+	}
+
+	try
+	{
+		value = std::stoul(argv[++argumentIndex]);
+	}
+	catch (const std::exception&)
+	{
+		std::cout << "[ERROR] Invalid value for " << argument << ": " << argv[argumentIndex] << "\n";
+		return false;
 	}
 
+	return true;
+}
+
+/**
+* @brief Read the value of a text option, like "--fixture-file DAM"
+* @return False if the value is missing
+*/
+bool ReadStringArgument(int argc, char* argv[], int& argumentIndex, std::string& value)
+{
+	if (argumentIndex + 1 >= argc)
+	{
+		std::cout << "[ERROR] Missing value for " << argv[argumentIndex] << "\n";
+		return false;
+	}
+
+	value = argv[++argumentIndex];
+	return true;
+}
+
+int main(int argc, char* argv[])
+{
 	std::string inputPath;
 	std::string outputPath;
+	size_t jobCount = 1;
+	size_t textureJobCount = 0;
+	bool textureJobCountSet = false;
+	std::string fixturesPath;
+	std::string fixtureScale = "1";
+	std::string fixtureFile;
+	std::string statsPath;
+	std::string tracePath;
+	bool forceExtraction = false;
+	bool textureDeduplication = true;
+	bool textureAtlas = false;
+	bool usedTexturesOnly = false;
+	DDAMeshFormat meshFormat = DDAMeshFormat::FBX;
+	DDATextureExportOptions textureExportOptions;
 
-	for (size_t i = 0; i < argc; i++)
+	size_t positionalArgumentIndex = 0;
+	for (int i = 1; i < argc; i++)
 	{
-		std::string argument = argv[i];
-		if (argument.size() >= 4)
+		const std::string argument = argv[i];
+		if (argument == "--jobs" || argument == "-j")
+		{
+			if (!ReadCountArgument(argc, argv, i, jobCount))
+			{
+				ShowUsage();
+				return 1;
+			}
+			continue;
+		}
+		else if (argument == "--texture-jobs")
+		{
+			if (!ReadCountArgument(argc, argv, i, textureJobCount))
+			{
+				ShowUsage();
+				return 1;
+			}
+			textureJobCountSet = true;
+			continue;
+		}
+		else if (argument == "--generate-fixtures" || argument == "--fixture-scale" || argument == "--fixture-file")
+		{
+			std::string& value = argument == "--generate-fixtures" ? fixturesPath : (argument == "--fixture-scale" ? fixtureScale : fixtureFile);
+			if (!ReadStringArgument(argc, argv, i, value))
+			{
+				ShowUsage();
+				return 1;
+			}
+			continue;
+		}
+		else if (argument == "--stats" || argument == "--trace")
+		{
+			if (!ReadStringArgument(argc, argv, i, argument == "--stats" ? statsPath : tracePath))
+			{
+				ShowUsage();
+				return 1;
+			}
+			continue;
+		}
+		else if (argument == "--mesh-format")
+		{
+			std::string meshFormatName;
+			if (!ReadStringArgument(argc, argv, i, meshFormatName))
+			{
+				ShowUsage();
+				return 1;
+			}
+			if (meshFormatName == "fbx")
+			{
+				meshFormat = DDAMeshFormat::FBX;
+			}
+			else if (meshFormatName == "glb")
+			{
+				meshFormat = DDAMeshFormat::GLB;
+			}
+			else
+			{
+				std::cout << "[ERROR] Invalid value for " << argument << ": " << meshFormatName << "\n";
+				ShowUsage();
+				return 1;
+			}
+			continue;
+		}
+		else if (argument == "--indexed-png")
+		{
+			textureExportOptions.indexedColors = true;
+			continue;
+		}
+		else if (argument == "--png-compression")
+		{
+			std::string compressionName;
+			if (!ReadStringArgument(argc, argv, i, compressionName))
+			{
+				ShowUsage();
+				return 1;
+			}
+			if (compressionName == "default")
+			{
+				textureExportOptions.pngCompression = DDAPngCompression::DEFAULT;
+			}
+			else if (compressionName == "stored")
+			{
+				textureExportOptions.pngCompression = DDAPngCompression::STORED;
+			}
+			else if (compressionName == "fast")
+			{
+				textureExportOptions.pngCompression = DDAPngCompression::FAST;
+			}
+			else if (compressionName == "max")
+			{
+				textureExportOptions.pngCompression = DDAPngCompression::MAX;
+			}
+			else
+			{
+				std::cout << "[ERROR] Invalid value for " << argument << ": " << compressionName << "\n";
+				ShowUsage();
+				return 1;
+			}
+			continue;
+		}
+		else if (argument == "--texture-format")
+		{
+			std::string formatName;
+			if (!ReadStringArgument(argc, argv, i, formatName))
+			{
+				ShowUsage();
+				return 1;
+			}
+			if (formatName == "png")
+			{
+				textureExportOptions.textureFormat = DDATextureFormat::PNG;
+			}
+			else if (formatName == "qoi")
+			{
+				textureExportOptions.textureFormat = DDATextureFormat::QOI;
+			}
+			else if (formatName == "raw")
+			{
+				textureExportOptions.textureFormat = DDATextureFormat::RAW;
+			}
+			else if (formatName == "dds")
+			{
+				textureExportOptions.textureFormat = DDATextureFormat::DDS;
+			}
+			else if (formatName == "ktx2")
+			{
+				textureExportOptions.textureFormat = DDATextureFormat::KTX2;
+			}
+			else
+			{
+				std::cout << "[ERROR] Invalid value for " << argument << ": " << formatName << "\n";
+				ShowUsage();
+				return 1;
+			}
+			continue;
+		}
+		else if (argument == "--block-compression")
 		{
-			if (argument.substr(argument.size() - 4) == ".exe")
+			std::string compressionName;
+			if (!ReadStringArgument(argc, argv, i, compressionName))
 			{
-				continue;
+				ShowUsage();
+				return 1;
 			}
+			if (compressionName == "none")
+			{
+				textureExportOptions.blockCompression = DDABlockCompression::NONE;
+			}
+			else if (compressionName == "bc1-bc3")
+			{
+				textureExportOptions.blockCompression = DDABlockCompression::BC1_BC3;
+			}
+			else if (compressionName == "bc7")
+			{
+				textureExportOptions.blockCompression = DDABlockCompression::BC7;
+			}
+			else
+			{
+				std::cout << "[ERROR] Invalid value for " << argument << ": " << compressionName << "\n";
+				ShowUsage();
+				return 1;
+			}
+			continue;
+		}
+		else if (argument == "--force")
+		{
+			forceExtraction = true;
+			continue;
+		}
+		else if (argument == "--no-texture-dedup")
+		{
+			textureDeduplication = false;
+			continue;
+		}
+		else if (argument == "--texture-atlas")
+		{
+			textureAtlas = true;
+			continue;
+		}
+		else if (argument == "--used-textures-only")
+		{
+			usedTexturesOnly = true;
+			continue;
 		}
 
-		if(i == 1)
+		if (positionalArgumentIndex == 0)
 		{
 			inputPath = argument;
 		}
-		else if (i == 2)
+		else if (positionalArgumentIndex == 1)
 		{
 			outputPath = argument;
 		}
 		else
 		{
 			std::cout << "Unknown argument: " << argument << "\n";
+			ShowUsage();
 			return 1;
 		}
+		positionalArgumentIndex++;
+	}
+
+	if (!fixturesPath.empty())
+	{
+		float scale = 0;
+		try
+		{
+			scale = std::stof(fixtureScale);
+		}
+		catch (const std::exception&)
+		{
+			scale = 0;
+		}
+
+		if (scale <= 0)
+		{
+			std::cout << "[ERROR] Invalid value for --fixture-scale: " << fixtureScale << "\n";
+			ShowUsage();
+			return 1;
+		}
+
+		if (fixturesPath.back() != '\\' && fixturesPath.back() != '/')
+		{
+			fixturesPath += "\\";
+		}
+
+		return GenerateFixtures(fixturesPath, scale, fixtureFile) ? 0 : 1;
 	}
 
 	// Check if input and output paths are valid
@@ -66,6 +358,17 @@ int main(int argc, char* argv[])
 		stopProgram = true;
 	}
 
+	if (textureExportOptions.blockCompression != DDABlockCompression::NONE && textureExportOptions.textureFormat != DDATextureFormat::DDS && textureExportOptions.textureFormat != DDATextureFormat::KTX2)
+	{
+		std::cout << "[ERROR] --block-compression needs --texture-format dds or ktx2." << std::endl;
+		stopProgram = true;
+	}
+
+	if (!DDAManager::CanMeshesLoadTextures(meshFormat, textureExportOptions.textureFormat))
+	{
+		std::cout << "[WARNING] The meshes cannot load the " << (TextureDumper::GetFileExtension(textureExportOptions.textureFormat) + 1) << " textures, they are exported without textures." << std::endl;
+	}
+
 	if (!stopProgram && !std::filesystem::exists(inputPath))
 	{
 		std::cout << "[ERROR] Input path does not exists." << std::endl;
@@ -89,40 +392,140 @@ int main(int argc, char* argv[])
 		outputPath += "\\";
 	}
 
-	LaunchExtraction(inputPath, outputPath);
+	// Share the CPU threads between the files extracted at the same time
+	if (!textureJobCountSet)
+	{
+		const size_t threadCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+		const size_t fileJobCount = jobCount == 0 ? threadCount : jobCount;
+		textureJobCount = std::max<size_t>(threadCount / fileJobCount, 1);
+	}
+
+	ExtractionStats::SetEnabled(!statsPath.empty());
+	TraceRecorder::SetEnabled(!tracePath.empty());
+
+	LaunchExtraction(inputPath, outputPath, jobCount, textureJobCount, forceExtraction, textureDeduplication, textureAtlas, usedTexturesOnly, meshFormat, textureExportOptions);
+
+	if (!statsPath.empty())
+	{
+		std::ofstream statsFile(statsPath, std::ios::out | std::ios::trunc);
+		if (!statsFile.is_open())
+		{
+			std::cout << "[ERROR] File not created: " + statsPath << std::endl;
+		}
+		else
+		{
+			statsFile << ExtractionStats::ToJson();
+		}
+	}
+
+	if (!tracePath.empty())
+	{
+		TraceRecorder::WriteJson(tracePath);
+	}
 
     std::cout << "Done!\n";
 }
 
-void LaunchExtraction(const std::string& inputPath, const std::string& outputPath)
+void LaunchExtraction(const std::string& inputPath, const std::string& outputPath, size_t jobCount, size_t textureJobCount, bool forceExtraction, bool textureDeduplication, bool textureAtlas, bool usedTexturesOnly, DDAMeshFormat meshFormat, const DDATextureExportOptions& textureExportOptions)
 {
-	//TODO: Multithread extraction, one thread per file
+	std::vector<DDAGameFile> gameFiles =
+	{
+		DDAGameFile::AIRPORT,
+		DDAGameFile::BMOVIE,
+		DDAGameFile::BRON_2ND,
+		DDAGameFile::BRONX,
+		DDAGameFile::CHIN_2ND,
+		DDAGameFile::CHINATWN,
+		DDAGameFile::CONSTR,
+		DDAGameFile::DAM,
+		DDAGameFile::ENGINE,
+		DDAGameFile::GLADIATO,
+		DDAGameFile::GODS,
+		DDAGameFile::JUSTICE,
+		DDAGameFile::REFINERY,
+		DDAGameFile::SHIPYARD,
+		DDAGameFile::STEELWRK,
+		DDAGameFile::SUBWAY,
+		DDAGameFile::VEGA_2ND,
+		DDAGameFile::VEGAS,
+		DDAGameFile::WINBOWL,
+
+		DDAGameFile::SPRITES,
+		DDAGameFile::INGAME,
+
+		DDAGameFile::DD4FRONT,
+		DDAGameFile::DD4GAME,
+		DDAGameFile::DD4START,
+	};
+
+	// Biggest files first, so a big track (DAM, BRONX...) does not start last and finish long after the others
+	std::vector<uintmax_t> fileSizes(std::size(filesNames), 0);
+	for (const DDAGameFile gameFile : gameFiles)
+	{
+		std::error_code error;
+		const uintmax_t fileSize = std::filesystem::file_size(inputPath + filesNames[(int)gameFile], error);
+		fileSizes[(int)gameFile] = error ? 0 : fileSize;
+	}
+	std::stable_sort(gameFiles.begin(), gameFiles.end(), [&fileSizes](DDAGameFile a, DDAGameFile b)
+		{
+			return fileSizes[(int)a] > fileSizes[(int)b];
+		});
+
+	// ExtractData keeps its parser and texture dumper on the stack, so each worker uses its own
 	DDAManager ddaManager = DDAManager(inputPath);
+	ddaManager.SetTextureJobCount(textureJobCount);
+	ddaManager.SetForceExtraction(forceExtraction);
+	ddaManager.SetTextureDeduplication(textureDeduplication);
+	ddaManager.SetTextureAtlas(textureAtlas);
+	ddaManager.SetUsedTexturesOnly(usedTexturesOnly);
+	ddaManager.SetMeshFormat(meshFormat);
+	ddaManager.SetTextureExportOptions(textureExportOptions);
+	WorkerPool::ParallelFor(gameFiles.size(), jobCount, [&](size_t fileIndex, size_t /*workerIndex*/)
+		{
+			ddaManager.ExtractData(gameFiles[fileIndex], outputPath);
+		});
+}
+
+/**
+* @brief Generate fake game files and check that the parser finds what was generated
+* @param fileName Only generate this file if not empty
+* @return False if a file was not generated or if a test failed
+*/
+bool GenerateFixtures(const std::string& outputPath, float scale, const std::string& fileName)
+{
+	bool success = true;
+	bool fileFound = false;
+	for (const DDAGameFile gameFile : DDAFixtureGenerator::GetSupportedFiles())
+	{
+		const std::string& filePath = filesNames[(int)gameFile];
+		const size_t nameStart = filePath.find_last_of('\\') + 1;
+		if (!fileName.empty() && filePath.substr(nameStart, filePath.find_last_of('.') - nameStart) != fileName)
+		{
+			continue;
+		}
+		fileFound = true;
+
+		std::cout << ("Generating: " + filePath + "\n") << std::flush;
+		DDAFixtureGenerator fixtureGenerator;
+		DDAFixtureExpectations expectations;
+		if (!fixtureGenerator.GenerateFile(outputPath, gameFile, scale, expectations))
+		{
+			success = false;
+			continue;
+		}
+
+		DDAFileParser fileParser;
+		if (!fileParser.LaunchUnitTest(outputPath, gameFile, expectations))
+		{
+			success = false;
+		}
+	}
+
+	if (!fileFound)
+	{
+		std::cout << "[ERROR] Unknown fixture file: " << fileName << "\n";
+		return false;
+	}
 
-	ddaManager.ExtractData(DDAGameFile::AIRPORT, outputPath);
-	ddaManager.ExtractData(DDAGameFile::BMOVIE, outputPath);
-	ddaManager.ExtractData(DDAGameFile::BRON_2ND, outputPath);
-	ddaManager.ExtractData(DDAGameFile::BRONX, outputPath);
-	ddaManager.ExtractData(DDAGameFile::CHIN_2ND, outputPath);
-	ddaManager.ExtractData(DDAGameFile::CHINATWN, outputPath);
-	ddaManager.ExtractData(DDAGameFile::CONSTR, outputPath);
-	ddaManager.ExtractData(DDAGameFile::DAM, outputPath);
-	ddaManager.ExtractData(DDAGameFile::ENGINE, outputPath);
-	ddaManager.ExtractData(DDAGameFile::GLADIATO, outputPath);
-	ddaManager.ExtractData(DDAGameFile::GODS, outputPath);
-	ddaManager.ExtractData(DDAGameFile::JUSTICE, outputPath);
-	ddaManager.ExtractData(DDAGameFile::REFINERY, outputPath);
-	ddaManager.ExtractData(DDAGameFile::SHIPYARD, outputPath);
-	ddaManager.ExtractData(DDAGameFile::STEELWRK, outputPath);
-	ddaManager.ExtractData(DDAGameFile::SUBWAY, outputPath);
-	ddaManager.ExtractData(DDAGameFile::VEGA_2ND, outputPath);
-	ddaManager.ExtractData(DDAGameFile::VEGAS, outputPath);
-	ddaManager.ExtractData(DDAGameFile::WINBOWL, outputPath);
-
-	ddaManager.ExtractData(DDAGameFile::SPRITES, outputPath);
-	ddaManager.ExtractData(DDAGameFile::INGAME, outputPath);
-
-	ddaManager.ExtractData(DDAGameFile::DD4FRONT, outputPath);
-	ddaManager.ExtractData(DDAGameFile::DD4GAME, outputPath);
-	ddaManager.ExtractData(DDAGameFile::DD4START, outputPath);
+	return success;
 }
\ No newline at end of file
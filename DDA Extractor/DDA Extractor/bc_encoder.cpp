@@ -0,0 +1,642 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "bc_encoder.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "worker_pool.h"
+
+namespace
+{
+	constexpr size_t BLOCK_PIXEL_COUNT = 16;
+
+	// Blocks compressed by a job, enough to hide the cost of starting a thread
+	constexpr size_t BLOCKS_PER_JOB = 1024;
+
+	// Interpolation weights of the 4 bits indices of BC7, out of 64
+	constexpr int BC7_WEIGHTS[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	using BlockPixels = uint8_t[BLOCK_PIXEL_COUNT][4];
+
+	void LoadBlock(const uint8_t* pixels, size_t width, size_t height, size_t blockX, size_t blockY, BlockPixels& block)
+	{
+		for (size_t y = 0; y < 4; y++)
+		{
+			const size_t pixelY = std::min(blockY * 4 + y, height - 1);
+			for (size_t x = 0; x < 4; x++)
+			{
+				const size_t pixelX = std::min(blockX * 4 + x, width - 1);
+				memcpy(block[y * 4 + x], pixels + (pixelY * width + pixelX) * 4, 4);
+			}
+		}
+	}
+
+	/**
+	* @brief Find the line that fits the colors of the block best (principal axis), the endpoints are the two ends of the colors on it
+	* @param weights Pixels with a negative weight are ignored
+	*/
+	void FitEndpoints(const BlockPixels& block, const float weights[BLOCK_PIXEL_COUNT], size_t channelCount, float endpoints[2][4])
+	{
+		float mean[4] = {};
+		size_t pixelCount = 0;
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			if (weights[i] < 0)
+			{
+				continue;
+			}
+			for (size_t channel = 0; channel < channelCount; channel++)
+			{
+				mean[channel] += block[i][channel];
+			}
+			pixelCount++;
+		}
+
+		for (size_t channel = 0; channel < 4; channel++)
+		{
+			mean[channel] = pixelCount == 0 ? 0 : mean[channel] / pixelCount;
+			endpoints[0][channel] = mean[channel];
+			endpoints[1][channel] = mean[channel];
+		}
+
+		float covariance[4][4] = {};
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			if (weights[i] < 0)
+			{
+				continue;
+			}
+			for (size_t a = 0; a < channelCount; a++)
+			{
+				for (size_t b = 0; b < channelCount; b++)
+				{
+					covariance[a][b] += (block[i][a] - mean[a]) * (block[i][b] - mean[b]);
+				}
+			}
+		}
+
+		// Power iteration, started from the channel that changes the most
+		size_t biggestChannel = 0;
+		for (size_t channel = 1; channel < channelCount; channel++)
+		{
+			if (covariance[channel][channel] > covariance[biggestChannel][biggestChannel])
+			{
+				biggestChannel = channel;
+			}
+		}
+		if (covariance[biggestChannel][biggestChannel] < 1)
+		{
+			return;
+		}
+
+		float axis[4] = {};
+		memcpy(axis, covariance[biggestChannel], sizeof(axis));
+		for (size_t iteration = 0; iteration < 8; iteration++)
+		{
+			float nextAxis[4] = {};
+			float biggestValue = 0;
+			for (size_t a = 0; a < channelCount; a++)
+			{
+				for (size_t b = 0; b < channelCount; b++)
+				{
+					nextAxis[a] += covariance[a][b] * axis[b];
+				}
+				biggestValue = std::max(biggestValue, std::fabs(nextAxis[a]));
+			}
+			if (biggestValue == 0)
+			{
+				return;
+			}
+			for (size_t channel = 0; channel < channelCount; channel++)
+			{
+				axis[channel] = nextAxis[channel] / biggestValue;
+			}
+		}
+
+		float axisLength = 0;
+		for (size_t channel = 0; channel < channelCount; channel++)
+		{
+			axisLength += axis[channel] * axis[channel];
+		}
+		axisLength = std::sqrt(axisLength);
+
+		float minPosition = 0;
+		float maxPosition = 0;
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			if (weights[i] < 0)
+			{
+				continue;
+			}
+			float position = 0;
+			for (size_t channel = 0; channel < channelCount; channel++)
+			{
+				position += (block[i][channel] - mean[channel]) * axis[channel] / axisLength;
+			}
+			minPosition = std::min(minPosition, position);
+			maxPosition = std::max(maxPosition, position);
+		}
+
+		for (size_t channel = 0; channel < channelCount; channel++)
+		{
+			endpoints[0][channel] = std::clamp(mean[channel] + axis[channel] / axisLength * minPosition, 0.0f, 255.0f);
+			endpoints[1][channel] = std::clamp(mean[channel] + axis[channel] / axisLength * maxPosition, 0.0f, 255.0f);
+		}
+	}
+
+	/**
+	* @brief Find the endpoints that give the smallest error with the chosen indices (least squares)
+	* @param weights Position of each pixel between the endpoints (0 to 1), pixels with a negative weight are ignored
+	*/
+	void RefineEndpoints(const BlockPixels& block, const float weights[BLOCK_PIXEL_COUNT], size_t channelCount, float endpoints[2][4])
+	{
+		float sum00 = 0;
+		float sum01 = 0;
+		float sum11 = 0;
+		float sumColor0[4] = {};
+		float sumColor1[4] = {};
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			const float weight = weights[i];
+			if (weight < 0)
+			{
+				continue;
+			}
+			sum00 += (1 - weight) * (1 - weight);
+			sum01 += (1 - weight) * weight;
+			sum11 += weight * weight;
+			for (size_t channel = 0; channel < channelCount; channel++)
+			{
+				sumColor0[channel] += (1 - weight) * block[i][channel];
+				sumColor1[channel] += weight * block[i][channel];
+			}
+		}
+
+		// All pixels on the same index
+		const float determinant = sum00 * sum11 - sum01 * sum01;
+		if (std::fabs(determinant) < 1e-4f)
+		{
+			return;
+		}
+
+		for (size_t channel = 0; channel < channelCount; channel++)
+		{
+			endpoints[0][channel] = std::clamp((sumColor0[channel] * sum11 - sumColor1[channel] * sum01) / determinant, 0.0f, 255.0f);
+			endpoints[1][channel] = std::clamp((sumColor1[channel] * sum00 - sumColor0[channel] * sum01) / determinant, 0.0f, 255.0f);
+		}
+	}
+
+	uint16_t ToRgb565(const float color[4])
+	{
+		const int r = std::clamp(static_cast<int>(color[0] * 31 / 255 + 0.5f), 0, 31);
+		const int g = std::clamp(static_cast<int>(color[1] * 63 / 255 + 0.5f), 0, 63);
+		const int b = std::clamp(static_cast<int>(color[2] * 31 / 255 + 0.5f), 0, 31);
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+
+	void FromRgb565(uint16_t color, int output[3])
+	{
+		const int r = color >> 11;
+		const int g = (color >> 5) & 0x3F;
+		const int b = color & 0x1F;
+		output[0] = (r << 3) | (r >> 2);
+		output[1] = (g << 2) | (g >> 4);
+		output[2] = (b << 3) | (b >> 2);
+	}
+
+	/**
+	* @brief Choose the nearest color of the palette for each pixel, transparent pixels get the index 3
+	* @param colorCount 4, or 3 if the fourth color is the transparent one
+	* @return Sum of the squared errors
+	*/
+	int GetColorIndices(const BlockPixels& block, const bool isTransparent[BLOCK_PIXEL_COUNT], uint16_t color0, uint16_t color1, size_t colorCount, uint8_t indices[BLOCK_PIXEL_COUNT])
+	{
+		int palette[4][3];
+		FromRgb565(color0, palette[0]);
+		FromRgb565(color1, palette[1]);
+		for (size_t channel = 0; channel < 3; channel++)
+		{
+			if (colorCount == 4)
+			{
+				palette[2][channel] = (2 * palette[0][channel] + palette[1][channel]) / 3;
+				palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel]) / 3;
+			}
+			else
+			{
+				palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+			}
+		}
+
+		int totalError = 0;
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			if (isTransparent[i])
+			{
+				indices[i] = 3;
+				continue;
+			}
+
+			int bestError = INT32_MAX;
+			for (size_t colorIndex = 0; colorIndex < colorCount; colorIndex++)
+			{
+				int error = 0;
+				for (size_t channel = 0; channel < 3; channel++)
+				{
+					const int difference = block[i][channel] - palette[colorIndex][channel];
+					error += difference * difference;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					indices[i] = static_cast<uint8_t>(colorIndex);
+				}
+			}
+			totalError += bestError;
+		}
+		return totalError;
+	}
+
+	/**
+	* @brief Write the 8 bytes of a BC1 color block
+	* @param allowTransparency Pixels with an alpha under 128 are written transparent, false for BC3 where the color block always has 4 colors
+	*/
+	void EncodeColorBlock(const BlockPixels& block, bool allowTransparency, uint8_t* output)
+	{
+		bool isTransparent[BLOCK_PIXEL_COUNT];
+		float weights[BLOCK_PIXEL_COUNT];
+		bool hasTransparency = false;
+		bool hasColor = false;
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			isTransparent[i] = allowTransparency && block[i][3] < 128;
+			weights[i] = isTransparent[i] ? -1.0f : 0.0f;
+			hasTransparency |= isTransparent[i];
+			hasColor |= !isTransparent[i];
+		}
+
+		// In the 3 colors mode (color0 <= color1), the fourth color is transparent
+		if (!hasColor)
+		{
+			memset(output, 0, 4);
+			memset(output + 4, 0xFF, 4);
+			return;
+		}
+		const size_t colorCount = hasTransparency ? 3 : 4;
+
+		float endpoints[2][4];
+		FitEndpoints(block, weights, 3, endpoints);
+
+		// The fitted endpoints are refined once with the indices they give
+		uint16_t colors[2] = {};
+		uint8_t indices[BLOCK_PIXEL_COUNT] = {};
+		int bestError = INT32_MAX;
+		for (size_t iteration = 0; iteration < 2; iteration++)
+		{
+			const uint16_t color0 = ToRgb565(endpoints[0]);
+			const uint16_t color1 = ToRgb565(endpoints[1]);
+			uint8_t newIndices[BLOCK_PIXEL_COUNT];
+			const int error = GetColorIndices(block, isTransparent, color0, color1, colorCount, newIndices);
+			if (error < bestError)
+			{
+				bestError = error;
+				colors[0] = color0;
+				colors[1] = color1;
+				memcpy(indices, newIndices, sizeof(indices));
+			}
+
+			if (bestError == 0)
+			{
+				break;
+			}
+
+			const float indexWeights[4] = { 0.0f, 1.0f, colorCount == 4 ? 1.0f / 3 : 0.5f, 2.0f / 3 };
+			for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+			{
+				weights[i] = isTransparent[i] ? -1.0f : indexWeights[indices[i]];
+			}
+			RefineEndpoints(block, weights, 3, endpoints);
+		}
+
+		// The order of the colors tells the mode, the indices follow the swap
+		if (colorCount == 3 && colors[0] > colors[1])
+		{
+			std::swap(colors[0], colors[1]);
+			for (uint8_t& index : indices)
+			{
+				index = index < 2 ? index ^ 1 : index;
+			}
+		}
+		else if (colorCount == 4 && colors[0] < colors[1])
+		{
+			std::swap(colors[0], colors[1]);
+			for (uint8_t& index : indices)
+			{
+				index ^= 1;
+			}
+		}
+		else if (colorCount == 4 && colors[0] == colors[1])
+		{
+			// Equal colors are read in the 3 colors mode, the index 3 would be transparent
+			memset(indices, 0, sizeof(indices));
+		}
+
+		uint32_t indexBits = 0;
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			indexBits |= static_cast<uint32_t>(indices[i]) << (i * 2);
+		}
+		const uint8_t bytes[8] = { static_cast<uint8_t>(colors[0]), static_cast<uint8_t>(colors[0] >> 8), static_cast<uint8_t>(colors[1]), static_cast<uint8_t>(colors[1] >> 8),
+			static_cast<uint8_t>(indexBits), static_cast<uint8_t>(indexBits >> 8), static_cast<uint8_t>(indexBits >> 16), static_cast<uint8_t>(indexBits >> 24) };
+		memcpy(output, bytes, sizeof(bytes));
+	}
+
+	/**
+	* @brief Choose the nearest alpha of a BC3 alpha block for each pixel
+	* @return Sum of the squared errors
+	*/
+	int GetAlphaIndices(const BlockPixels& block, int alpha0, int alpha1, uint8_t indices[BLOCK_PIXEL_COUNT])
+	{
+		// 8 interpolated values if alpha0 > alpha1, else 6 interpolated values then 0 and 255
+		int palette[8] = { alpha0, alpha1 };
+		if (alpha0 > alpha1)
+		{
+			for (int i = 1; i < 7; i++)
+			{
+				palette[i + 1] = ((7 - i) * alpha0 + i * alpha1) / 7;
+			}
+		}
+		else
+		{
+			for (int i = 1; i < 5; i++)
+			{
+				palette[i + 1] = ((5 - i) * alpha0 + i * alpha1) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+
+		int totalError = 0;
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			int bestError = INT32_MAX;
+			for (uint8_t alphaIndex = 0; alphaIndex < 8; alphaIndex++)
+			{
+				const int difference = block[i][3] - palette[alphaIndex];
+				if (difference * difference < bestError)
+				{
+					bestError = difference * difference;
+					indices[i] = alphaIndex;
+				}
+			}
+			totalError += bestError;
+		}
+		return totalError;
+	}
+
+	/**
+	* @brief Write the 8 bytes of a BC3 alpha block
+	*/
+	void EncodeAlphaBlock(const BlockPixels& block, uint8_t* output)
+	{
+		int minAlpha = 255;
+		int maxAlpha = 0;
+		// Without 0 and 255, that the 6 values mode has for free
+		int minMiddleAlpha = 255;
+		int maxMiddleAlpha = 0;
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			const int alpha = block[i][3];
+			minAlpha = std::min(minAlpha, alpha);
+			maxAlpha = std::max(maxAlpha, alpha);
+			if (alpha != 0 && alpha != 255)
+			{
+				minMiddleAlpha = std::min(minMiddleAlpha, alpha);
+				maxMiddleAlpha = std::max(maxMiddleAlpha, alpha);
+			}
+		}
+		if (minMiddleAlpha > maxMiddleAlpha)
+		{
+			minMiddleAlpha = maxMiddleAlpha = 0;
+		}
+
+		uint8_t alphas[2] = { static_cast<uint8_t>(maxAlpha), static_cast<uint8_t>(minAlpha) };
+		uint8_t indices[BLOCK_PIXEL_COUNT];
+		const int error = GetAlphaIndices(block, maxAlpha, minAlpha, indices);
+		if (error != 0)
+		{
+			uint8_t middleIndices[BLOCK_PIXEL_COUNT];
+			if (GetAlphaIndices(block, minMiddleAlpha, maxMiddleAlpha, middleIndices) < error)
+			{
+				alphas[0] = static_cast<uint8_t>(minMiddleAlpha);
+				alphas[1] = static_cast<uint8_t>(maxMiddleAlpha);
+				memcpy(indices, middleIndices, sizeof(indices));
+			}
+		}
+
+		uint64_t indexBits = 0;
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			indexBits |= static_cast<uint64_t>(indices[i]) << (i * 3);
+		}
+		output[0] = alphas[0];
+		output[1] = alphas[1];
+		for (size_t i = 0; i < 6; i++)
+		{
+			output[2 + i] = static_cast<uint8_t>(indexBits >> (i * 8));
+		}
+	}
+
+	/**
+	* @brief Choose the nearest color of a BC7 mode 6 block for each pixel
+	* @param endpoints 8 bits endpoints (7 bits value and p-bit)
+	* @return Sum of the squared errors
+	*/
+	int GetBc7Indices(const BlockPixels& block, const int endpoints[2][4], uint8_t indices[BLOCK_PIXEL_COUNT])
+	{
+		int palette[16][4];
+		for (size_t colorIndex = 0; colorIndex < 16; colorIndex++)
+		{
+			for (size_t channel = 0; channel < 4; channel++)
+			{
+				palette[colorIndex][channel] = ((64 - BC7_WEIGHTS[colorIndex]) * endpoints[0][channel] + BC7_WEIGHTS[colorIndex] * endpoints[1][channel] + 32) >> 6;
+			}
+		}
+
+		int totalError = 0;
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			int bestError = INT32_MAX;
+			for (uint8_t colorIndex = 0; colorIndex < 16; colorIndex++)
+			{
+				int error = 0;
+				for (size_t channel = 0; channel < 4; channel++)
+				{
+					const int difference = block[i][channel] - palette[colorIndex][channel];
+					error += difference * difference;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					indices[i] = colorIndex;
+				}
+			}
+			totalError += bestError;
+		}
+		return totalError;
+	}
+
+	/**
+	* @brief Write the 16 bytes of a BC7 block in mode 6 (one subset, 7 bits RGBA endpoints with a p-bit, 4 bits indices)
+	*/
+	void EncodeBc7Block(const BlockPixels& block, uint8_t* output)
+	{
+		float weights[BLOCK_PIXEL_COUNT] = {};
+		float endpoints[2][4];
+		FitEndpoints(block, weights, 4, endpoints);
+
+		// Each endpoint has a p-bit shared by its channels, the 4 combinations are tried
+		int bestEndpoints[2][4] = {};
+		uint8_t indices[BLOCK_PIXEL_COUNT] = {};
+		int bestError = INT32_MAX;
+		for (size_t iteration = 0; iteration < 2; iteration++)
+		{
+			for (int pBits = 0; pBits < 4; pBits++)
+			{
+				int quantizedEndpoints[2][4];
+				for (size_t endpoint = 0; endpoint < 2; endpoint++)
+				{
+					const int pBit = (pBits >> endpoint) & 1;
+					for (size_t channel = 0; channel < 4; channel++)
+					{
+						const int value = std::clamp(static_cast<int>((endpoints[endpoint][channel] - pBit) / 2 + 0.5f), 0, 127);
+						quantizedEndpoints[endpoint][channel] = (value << 1) | pBit;
+					}
+				}
+
+				uint8_t newIndices[BLOCK_PIXEL_COUNT];
+				const int error = GetBc7Indices(block, quantizedEndpoints, newIndices);
+				if (error < bestError)
+				{
+					bestError = error;
+					memcpy(bestEndpoints, quantizedEndpoints, sizeof(bestEndpoints));
+					memcpy(indices, newIndices, sizeof(indices));
+				}
+			}
+
+			if (bestError == 0)
+			{
+				break;
+			}
+
+			for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+			{
+				weights[i] = BC7_WEIGHTS[indices[i]] / 64.0f;
+			}
+			RefineEndpoints(block, weights, 4, endpoints);
+		}
+
+		// The highest bit of the first index is not stored, it must be 0
+		if (indices[0] >= 8)
+		{
+			std::swap(bestEndpoints[0], bestEndpoints[1]);
+			for (uint8_t& index : indices)
+			{
+				index = 15 - index;
+			}
+		}
+
+		memset(output, 0, 16);
+		size_t bitPosition = 0;
+		const auto writeBits = [&](uint32_t value, size_t bitCount)
+			{
+				for (size_t i = 0; i < bitCount; i++, bitPosition++)
+				{
+					output[bitPosition / 8] |= static_cast<uint8_t>(((value >> i) & 1) << (bitPosition % 8));
+				}
+			};
+
+		writeBits(1 << 6, 7); // Mode 6
+		for (size_t channel = 0; channel < 4; channel++)
+		{
+			writeBits(bestEndpoints[0][channel] >> 1, 7);
+			writeBits(bestEndpoints[1][channel] >> 1, 7);
+		}
+		writeBits(bestEndpoints[0][0] & 1, 1);
+		writeBits(bestEndpoints[1][0] & 1, 1);
+		for (size_t i = 0; i < BLOCK_PIXEL_COUNT; i++)
+		{
+			writeBits(indices[i], i == 0 ? 3 : 4);
+		}
+	}
+}
+
+void BcEncoder::Compress(const uint8_t* pixels, size_t width, size_t height, DDAPixelFormat format, size_t jobCount, uint8_t* output)
+{
+	if (width == 0 || height == 0 || format == DDAPixelFormat::RGBA8)
+	{
+		return;
+	}
+
+	const size_t blockSize = GetBlockSize(format);
+	const size_t blockCountX = (width + 3) / 4;
+	const size_t blockCountY = (height + 3) / 4;
+
+	// Each job compresses whole rows of blocks
+	const size_t rowsPerJob = std::max<size_t>(BLOCKS_PER_JOB / blockCountX, 1);
+	const size_t jobsNeeded = (blockCountY + rowsPerJob - 1) / rowsPerJob;
+	WorkerPool::ParallelFor(jobsNeeded, jobCount, [&](size_t jobIndex, size_t)
+		{
+			BlockPixels block;
+			const size_t lastBlockY = std::min((jobIndex + 1) * rowsPerJob, blockCountY);
+			for (size_t blockY = jobIndex * rowsPerJob; blockY < lastBlockY; blockY++)
+			{
+				for (size_t blockX = 0; blockX < blockCountX; blockX++)
+				{
+					LoadBlock(pixels, width, height, blockX, blockY, block);
+					uint8_t* blockOutput = output + (blockY * blockCountX + blockX) * blockSize;
+					if (format == DDAPixelFormat::BC1)
+					{
+						EncodeColorBlock(block, true, blockOutput);
+					}
+					else if (format == DDAPixelFormat::BC3)
+					{
+						EncodeAlphaBlock(block, blockOutput);
+						EncodeColorBlock(block, false, blockOutput + 8);
+					}
+					else
+					{
+						EncodeBc7Block(block, blockOutput);
+					}
+				}
+			}
+		});
+}
+
+size_t BcEncoder::GetLevelSize(size_t width, size_t height, DDAPixelFormat format)
+{
+	if (format == DDAPixelFormat::RGBA8)
+	{
+		return width * height * GetBlockSize(format);
+	}
+	return std::max<size_t>((width + 3) / 4, 1) * std::max<size_t>((height + 3) / 4, 1) * GetBlockSize(format);
+}
+
+size_t BcEncoder::GetBlockSize(DDAPixelFormat format)
+{
+	switch (format)
+	{
+	case DDAPixelFormat::BC1:
+		return 8;
+	case DDAPixelFormat::BC3:
+	case DDAPixelFormat::BC7:
+		return 16;
+	default:
+		return 4;
+	}
+}
@@ -0,0 +1,44 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Pixel format of the texture files that can be uploaded to the GPU as they are (dds, ktx2)
+enum class DDAPixelFormat
+{
+	RGBA8,
+	BC1, // 4x4 pixels in 8 bytes, RGB with an optional 1 bit alpha
+	BC3, // 4x4 pixels in 16 bytes, RGB like BC1 with an interpolated alpha
+	BC7, // 4x4 pixels in 16 bytes, best quality
+};
+
+/**
+* @brief Compress RGBA pixels to the block formats read by the GPUs
+*/
+class BcEncoder
+{
+public:
+	/**
+	* @brief Compress an image, the blocks on the right and bottom edges repeat the last pixels when the size is not a multiple of 4
+	* @param format BC1, BC3 or BC7
+	* @param jobCount Threads used for large images (0 = one per CPU thread), blocks are compressed by groups
+	* @param output Buffer of GetLevelSize bytes, the blocks are written row by row
+	*/
+	static void Compress(const uint8_t* pixels, size_t width, size_t height, DDAPixelFormat format, size_t jobCount, uint8_t* output);
+
+	/**
+	* @brief Get the size of an image in a format, compressed images always have whole blocks
+	*/
+	static size_t GetLevelSize(size_t width, size_t height, DDAPixelFormat format);
+
+	/**
+	* @brief Get the size of a block of 4x4 pixels, or of a pixel for RGBA8
+	*/
+	static size_t GetBlockSize(DDAPixelFormat format);
+};
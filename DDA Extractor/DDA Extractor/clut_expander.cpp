@@ -0,0 +1,343 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "clut_expander.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DDA_CLUT_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+// MSVC allows any intrinsic in any function, GCC and Clang need to know which instruction set a function uses
+#if defined(DDA_CLUT_X86) && !defined(_MSC_VER)
+#define DDA_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define DDA_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define DDA_TARGET_SSSE3
+#define DDA_TARGET_AVX2
+#endif
+
+namespace
+{
+	using ExpandRowFunction = void(*)(const uint8_t* indices, size_t count, const uint32_t* palette, uint32_t* output);
+
+	void ExpandRow16Scalar(const uint8_t* indices, size_t byteCount, const uint32_t* palette, uint32_t* output)
+	{
+		for (size_t i = 0; i < byteCount; i++)
+		{
+			const uint8_t colorIds = indices[i];
+			output[i * 2 + 0] = palette[colorIds & 0x0F];
+			output[i * 2 + 1] = palette[colorIds >> 4];
+		}
+	}
+
+	void ExpandRow256Scalar(const uint8_t* indices, size_t pixelCount, const uint32_t* palette, uint32_t* output)
+	{
+		for (size_t i = 0; i < pixelCount; i++)
+		{
+			output[i] = palette[indices[i]];
+		}
+	}
+
+#if defined(DDA_CLUT_X86)
+	/**
+	* @brief Split the 16 colors palette in 4 vectors (one per channel) to do the lookup with a byte shuffle
+	*/
+	void GetPalettePlanes(const uint32_t* palette, uint8_t planes[4][16])
+	{
+		for (size_t colorIndex = 0; colorIndex < 16; colorIndex++)
+		{
+			uint8_t color[4];
+			memcpy(color, &palette[colorIndex], sizeof(uint32_t));
+			for (size_t channel = 0; channel < 4; channel++)
+			{
+				planes[channel][colorIndex] = color[channel];
+			}
+		}
+	}
+
+	DDA_TARGET_SSSE3 void StorePixels16SSSE3(__m128i colorIds, const __m128i planes[4], uint32_t* output)
+	{
+		const __m128i r = _mm_shuffle_epi8(planes[0], colorIds);
+		const __m128i g = _mm_shuffle_epi8(planes[1], colorIds);
+		const __m128i b = _mm_shuffle_epi8(planes[2], colorIds);
+		const __m128i a = _mm_shuffle_epi8(planes[3], colorIds);
+
+		// Interleave the channels back to RGBA
+		const __m128i rgLow = _mm_unpacklo_epi8(r, g);
+		const __m128i rgHigh = _mm_unpackhi_epi8(r, g);
+		const __m128i baLow = _mm_unpacklo_epi8(b, a);
+		const __m128i baHigh = _mm_unpackhi_epi8(b, a);
+
+		__m128i* outputVector = reinterpret_cast<__m128i*>(output);
+		_mm_storeu_si128(outputVector + 0, _mm_unpacklo_epi16(rgLow, baLow));
+		_mm_storeu_si128(outputVector + 1, _mm_unpackhi_epi16(rgLow, baLow));
+		_mm_storeu_si128(outputVector + 2, _mm_unpacklo_epi16(rgHigh, baHigh));
+		_mm_storeu_si128(outputVector + 3, _mm_unpackhi_epi16(rgHigh, baHigh));
+	}
+
+	DDA_TARGET_SSSE3 void ExpandRow16SSSE3(const uint8_t* indices, size_t byteCount, const uint32_t* palette, uint32_t* output)
+	{
+		alignas(16) uint8_t planesData[4][16];
+		GetPalettePlanes(palette, planesData);
+		__m128i planes[4];
+		for (size_t channel = 0; channel < 4; channel++)
+		{
+			planes[channel] = _mm_load_si128(reinterpret_cast<const __m128i*>(planesData[channel]));
+		}
+
+		const __m128i lowMask = _mm_set1_epi8(0x0F);
+		size_t i = 0;
+		for (; i + 16 <= byteCount; i += 16)
+		{
+			const __m128i colorIds = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+			const __m128i lowIds = _mm_and_si128(colorIds, lowMask);
+			const __m128i highIds = _mm_and_si128(_mm_srli_epi16(colorIds, 4), lowMask);
+
+			// The low 4 bits are the first pixel
+			StorePixels16SSSE3(_mm_unpacklo_epi8(lowIds, highIds), planes, output + i * 2);
+			StorePixels16SSSE3(_mm_unpackhi_epi8(lowIds, highIds), planes, output + i * 2 + 16);
+		}
+
+		ExpandRow16Scalar(indices + i, byteCount - i, palette, output + i * 2);
+	}
+
+	DDA_TARGET_AVX2 void StorePixels16AVX2(__m256i firstColorIds, __m256i secondColorIds, const __m256i planes[4], uint32_t* output)
+	{
+		// Byte shuffles and unpacks work on each 128 bits lane, so the first vector has the pixels 0-15 and 32-47, the second one 16-31 and 48-63
+		const __m256i colorIdsList[2] = { firstColorIds, secondColorIds };
+		for (size_t half = 0; half < 2; half++)
+		{
+			const __m256i colorIds = colorIdsList[half];
+			const __m256i r = _mm256_shuffle_epi8(planes[0], colorIds);
+			const __m256i g = _mm256_shuffle_epi8(planes[1], colorIds);
+			const __m256i b = _mm256_shuffle_epi8(planes[2], colorIds);
+			const __m256i a = _mm256_shuffle_epi8(planes[3], colorIds);
+
+			const __m256i rgLow = _mm256_unpacklo_epi8(r, g);
+			const __m256i rgHigh = _mm256_unpackhi_epi8(r, g);
+			const __m256i baLow = _mm256_unpacklo_epi8(b, a);
+			const __m256i baHigh = _mm256_unpackhi_epi8(b, a);
+
+			const __m256i pixels0 = _mm256_unpacklo_epi16(rgLow, baLow);
+			const __m256i pixels1 = _mm256_unpackhi_epi16(rgLow, baLow);
+			const __m256i pixels2 = _mm256_unpacklo_epi16(rgHigh, baHigh);
+			const __m256i pixels3 = _mm256_unpackhi_epi16(rgHigh, baHigh);
+
+			__m256i* firstLaneOutput = reinterpret_cast<__m256i*>(output + half * 16);
+			__m256i* secondLaneOutput = reinterpret_cast<__m256i*>(output + 32 + half * 16);
+			_mm256_storeu_si256(firstLaneOutput + 0, _mm256_permute2x128_si256(pixels0, pixels1, 0x20));
+			_mm256_storeu_si256(firstLaneOutput + 1, _mm256_permute2x128_si256(pixels2, pixels3, 0x20));
+			_mm256_storeu_si256(secondLaneOutput + 0, _mm256_permute2x128_si256(pixels0, pixels1, 0x31));
+			_mm256_storeu_si256(secondLaneOutput + 1, _mm256_permute2x128_si256(pixels2, pixels3, 0x31));
+		}
+	}
+
+	DDA_TARGET_AVX2 void ExpandRow16AVX2(const uint8_t* indices, size_t byteCount, const uint32_t* palette, uint32_t* output)
+	{
+		alignas(16) uint8_t planesData[4][16];
+		GetPalettePlanes(palette, planesData);
+		__m256i planes[4];
+		for (size_t channel = 0; channel < 4; channel++)
+		{
+			planes[channel] = _mm256_broadcastsi128_si256(_mm_load_si128(reinterpret_cast<const __m128i*>(planesData[channel])));
+		}
+
+		const __m256i lowMask = _mm256_set1_epi8(0x0F);
+		size_t i = 0;
+		for (; i + 32 <= byteCount; i += 32)
+		{
+			const __m256i colorIds = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(indices + i));
+			const __m256i lowIds = _mm256_and_si256(colorIds, lowMask);
+			const __m256i highIds = _mm256_and_si256(_mm256_srli_epi16(colorIds, 4), lowMask);
+
+			StorePixels16AVX2(_mm256_unpacklo_epi8(lowIds, highIds), _mm256_unpackhi_epi8(lowIds, highIds), planes, output + i * 2);
+		}
+
+		ExpandRow16Scalar(indices + i, byteCount - i, palette, output + i * 2);
+	}
+
+	DDA_TARGET_AVX2 void ExpandRow256AVX2(const uint8_t* indices, size_t pixelCount, const uint32_t* palette, uint32_t* output)
+	{
+		const int* paletteInts = reinterpret_cast<const int*>(palette);
+		size_t i = 0;
+		for (; i + 16 <= pixelCount; i += 16)
+		{
+			const __m128i colorIds = _mm_loadu_si128(reinterpret_cast<const __m128i*>(indices + i));
+			const __m256i firstIds = _mm256_cvtepu8_epi32(colorIds);
+			const __m256i secondIds = _mm256_cvtepu8_epi32(_mm_srli_si128(colorIds, 8));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i), _mm256_i32gather_epi32(paletteInts, firstIds, 4));
+			_mm256_storeu_si256(reinterpret_cast<__m256i*>(output + i + 8), _mm256_i32gather_epi32(paletteInts, secondIds, 4));
+		}
+
+		ExpandRow256Scalar(indices + i, pixelCount - i, palette, output + i);
+	}
+
+	bool IsAVX2Supported()
+	{
+#if defined(_MSC_VER)
+		int cpuInfo[4];
+		__cpuid(cpuInfo, 0);
+		if (cpuInfo[0] < 7)
+		{
+			return false;
+		}
+
+		// The OS has to save the AVX registers
+		__cpuid(cpuInfo, 1);
+		const bool osxsave = (cpuInfo[2] & (1 << 27)) != 0;
+		const bool avx = (cpuInfo[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6)
+		{
+			return false;
+		}
+
+		__cpuidex(cpuInfo, 7, 0);
+		return (cpuInfo[1] & (1 << 5)) != 0;
+#else
+		return __builtin_cpu_supports("avx2");
+#endif
+	}
+
+	bool IsSSSE3Supported()
+	{
+#if defined(_MSC_VER)
+		int cpuInfo[4];
+		__cpuid(cpuInfo, 1);
+		return (cpuInfo[2] & (1 << 9)) != 0;
+#else
+		return __builtin_cpu_supports("ssse3");
+#endif
+	}
+#endif
+
+	struct ExpandFunctions
+	{
+		ExpandRowFunction expandRow16 = ExpandRow16Scalar;
+		ExpandRowFunction expandRow256 = ExpandRow256Scalar;
+		const char* instructionSetName = "Scalar";
+	};
+
+	ExpandFunctions GetBestExpandFunctions()
+	{
+		ExpandFunctions functions;
+#if defined(DDA_CLUT_X86)
+		if (IsAVX2Supported())
+		{
+			functions.expandRow16 = ExpandRow16AVX2;
+			functions.expandRow256 = ExpandRow256AVX2;
+			functions.instructionSetName = "AVX2";
+		}
+		else if (IsSSSE3Supported())
+		{
+			// There is no gather before AVX2, the scalar version is used for 256 colors
+			functions.expandRow16 = ExpandRow16SSSE3;
+			functions.instructionSetName = "SSSE3";
+		}
+#endif
+		return functions;
+	}
+
+	const ExpandFunctions& GetExpandFunctions()
+	{
+		static const ExpandFunctions functions = GetBestExpandFunctions();
+		return functions;
+	}
+}
+
+void ClutExpander::PreparePalette(const uint8_t* palette, size_t colorCount, uint32_t* preparedPalette)
+{
+	for (size_t colorIndex = 0; colorIndex < colorCount; colorIndex++)
+	{
+		uint8_t color[4];
+		memcpy(color, palette + colorIndex * 4, sizeof(color));
+		// On PS2 the alpha is between 0 and 128, so we multiply by 2
+		color[3] = static_cast<uint8_t>(std::min(color[3] * 2, 0xff));
+		memcpy(&preparedPalette[colorIndex], color, sizeof(color));
+	}
+}
+
+void ClutExpander::ExpandRow16(const uint8_t* indices, size_t byteCount, const uint32_t* palette, uint32_t* output)
+{
+	GetExpandFunctions().expandRow16(indices, byteCount, palette, output);
+}
+
+void ClutExpander::ExpandRow256(const uint8_t* indices, size_t pixelCount, const uint32_t* palette, uint32_t* output)
+{
+	GetExpandFunctions().expandRow256(indices, pixelCount, palette, output);
+}
+
+DDAAlphaType ClutExpander::GetAlphaType(const uint32_t* colors, size_t colorCount)
+{
+	DDAAlphaType alphaType = DDAAlphaType::ALPHA_OPAQUE;
+	for (size_t colorIndex = 0; colorIndex < colorCount; colorIndex++)
+	{
+		uint8_t color[4];
+		memcpy(color, &colors[colorIndex], sizeof(color));
+		if (color[3] == 0)
+		{
+			alphaType = DDAAlphaType::ALPHA_CUTOUT;
+		}
+		else if (color[3] != 0xff)
+		{
+			return DDAAlphaType::ALPHA_BLEND;
+		}
+	}
+	return alphaType;
+}
+
+DDAAlphaType ClutExpander::GetUsedAlphaType(const uint8_t* indices, size_t byteCount, size_t height, size_t rowStride, bool isClut16, const uint32_t* palette)
+{
+	const size_t colorCount = isClut16 ? 16 : 256;
+	if (GetAlphaType(palette, colorCount) == DDAAlphaType::ALPHA_OPAQUE)
+	{
+		return DDAAlphaType::ALPHA_OPAQUE;
+	}
+
+	// Count the pixels of each index, then only the used colors are checked
+	uint32_t histogram[256] = {};
+	for (size_t y = 0; y < height; y++)
+	{
+		const uint8_t* row = indices + y * rowStride;
+		if (isClut16)
+		{
+			for (size_t x = 0; x < byteCount; x++)
+			{
+				histogram[row[x] & 0x0f]++;
+				histogram[row[x] >> 4]++;
+			}
+		}
+		else
+		{
+			for (size_t x = 0; x < byteCount; x++)
+			{
+				histogram[row[x]]++;
+			}
+		}
+	}
+
+	uint32_t usedColors[256];
+	size_t usedColorCount = 0;
+	for (size_t colorIndex = 0; colorIndex < colorCount; colorIndex++)
+	{
+		if (histogram[colorIndex] != 0)
+		{
+			usedColors[usedColorCount++] = palette[colorIndex];
+		}
+	}
+	return GetAlphaType(usedColors, usedColorCount);
+}
+
+const char* ClutExpander::GetInstructionSetName()
+{
+	return GetExpandFunctions().instructionSetName;
+}
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "dda_structures.h"
+
+/**
+* @brief Convert palette indices to RGBA pixels
+* @brief The best instruction set of the CPU (AVX2, SSSE3 or plain C++) is chosen at runtime
+*/
+class ClutExpander
+{
+public:
+	/**
+	* @brief Create the color table used by the Expand functions from a fixed palette (see DDAFileParser::GetFixedPalette)
+	* @brief On PS2 the alpha is between 0 and 128, it's multiplied by 2 here once for all pixels
+	* @param preparedPalette Array of colorCount colors
+	*/
+	static void PreparePalette(const uint8_t* palette, size_t colorCount, uint32_t* preparedPalette);
+
+	/**
+	* @brief Expand a row of 16 colors indices, there are two pixels per byte (low 4 bits first)
+	* @param byteCount Number of input bytes, 2 * byteCount pixels are written
+	*/
+	static void ExpandRow16(const uint8_t* indices, size_t byteCount, const uint32_t* palette, uint32_t* output);
+
+	/**
+	* @brief Expand a row of 256 colors indices
+	*/
+	static void ExpandRow256(const uint8_t* indices, size_t pixelCount, const uint32_t* palette, uint32_t* output);
+
+	/**
+	* @brief Find how a palette prepared with PreparePalette, or RGBA pixels, use the alpha
+	*/
+	static DDAAlphaType GetAlphaType(const uint32_t* colors, size_t colorCount);
+
+	/**
+	* @brief Find how the colors used by the palette indices of a texture use the alpha, the other colors of the palette are ignored
+	* @param indices First row of indices, rows are rowStride bytes apart
+	* @param byteCount Number of bytes of each row (two pixels per byte with 16 colors)
+	* @param palette 16 or 256 colors prepared with PreparePalette
+	*/
+	static DDAAlphaType GetUsedAlphaType(const uint8_t* indices, size_t byteCount, size_t height, size_t rowStride, bool isClut16, const uint32_t* palette);
+
+	/**
+	* @brief Name of the instruction set used by the Expand functions
+	*/
+	static const char* GetInstructionSetName();
+};
@@ -0,0 +1,156 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "content_hash.h"
+
+#include <cstring>
+
+namespace
+{
+	constexpr uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+	constexpr uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+	constexpr uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+	constexpr uint64_t PRIME_4 = 0x85EBCA77C2B2AE63ULL;
+	constexpr uint64_t PRIME_5 = 0x27D4EB2F165667C5ULL;
+
+	uint64_t RotateLeft(uint64_t value, int bits)
+	{
+		return (value << bits) | (value >> (64 - bits));
+	}
+
+	uint64_t Read64(const uint8_t* data)
+	{
+		uint64_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	uint32_t Read32(const uint8_t* data)
+	{
+		uint32_t value;
+		memcpy(&value, data, sizeof(value));
+		return value;
+	}
+
+	uint64_t Round(uint64_t accumulator, uint64_t input)
+	{
+		accumulator += input * PRIME_2;
+		accumulator = RotateLeft(accumulator, 31);
+		return accumulator * PRIME_1;
+	}
+
+	uint64_t MergeRound(uint64_t accumulator, uint64_t value)
+	{
+		accumulator ^= Round(0, value);
+		return accumulator * PRIME_1 + PRIME_4;
+	}
+}
+
+uint64_t ContentHash::Hash(const uint8_t* data, size_t size, uint64_t seed)
+{
+	const uint8_t* current = data;
+	const uint8_t* end = data + size;
+	uint64_t hash = 0;
+
+	// Four independent lanes of 8 bytes, so the CPU can process them at the same time
+	if (size >= 32)
+	{
+		uint64_t lane1 = seed + PRIME_1 + PRIME_2;
+		uint64_t lane2 = seed + PRIME_2;
+		uint64_t lane3 = seed;
+		uint64_t lane4 = seed - PRIME_1;
+		const uint8_t* limit = end - 32;
+		do
+		{
+			lane1 = Round(lane1, Read64(current));
+			lane2 = Round(lane2, Read64(current + 8));
+			lane3 = Round(lane3, Read64(current + 16));
+			lane4 = Round(lane4, Read64(current + 24));
+			current += 32;
+		} while (current <= limit);
+
+		hash = RotateLeft(lane1, 1) + RotateLeft(lane2, 7) + RotateLeft(lane3, 12) + RotateLeft(lane4, 18);
+		hash = MergeRound(hash, lane1);
+		hash = MergeRound(hash, lane2);
+		hash = MergeRound(hash, lane3);
+		hash = MergeRound(hash, lane4);
+	}
+	else
+	{
+		hash = seed + PRIME_5;
+	}
+
+	hash += static_cast<uint64_t>(size);
+
+	// Remaining bytes
+	while (current + 8 <= end)
+	{
+		hash ^= Round(0, Read64(current));
+		hash = RotateLeft(hash, 27) * PRIME_1 + PRIME_4;
+		current += 8;
+	}
+	if (current + 4 <= end)
+	{
+		hash ^= static_cast<uint64_t>(Read32(current)) * PRIME_1;
+		hash = RotateLeft(hash, 23) * PRIME_2 + PRIME_3;
+		current += 4;
+	}
+	while (current < end)
+	{
+		hash ^= (*current) * PRIME_5;
+		hash = RotateLeft(hash, 11) * PRIME_1;
+		current++;
+	}
+
+	// Mix the bits
+	hash ^= hash >> 33;
+	hash *= PRIME_2;
+	hash ^= hash >> 29;
+	hash *= PRIME_3;
+	hash ^= hash >> 32;
+
+	return hash;
+}
+
+std::string ContentHash::ToString(uint64_t hash)
+{
+	const char digits[] = "0123456789abcdef";
+	std::string text(16, '0');
+	for (int i = 15; i >= 0; i--)
+	{
+		text[i] = digits[hash & 0xF];
+		hash >>= 4;
+	}
+	return text;
+}
+
+bool ContentHash::FromString(const std::string& text, uint64_t& hash)
+{
+	if (text.size() != 16)
+	{
+		return false;
+	}
+
+	hash = 0;
+	for (const char c : text)
+	{
+		uint64_t digit;
+		if (c >= '0' && c <= '9')
+		{
+			digit = c - '0';
+		}
+		else if (c >= 'a' && c <= 'f')
+		{
+			digit = c - 'a' + 10;
+		}
+		else
+		{
+			return false;
+		}
+		hash = (hash << 4) | digit;
+	}
+	return true;
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+/**
+* @brief Fast non-cryptographic 64 bits hash (XXH64 algorithm), used to know if a file or a texture changed
+*/
+class ContentHash
+{
+public:
+	static uint64_t Hash(const uint8_t* data, size_t size, uint64_t seed = 0);
+
+	/**
+	* @brief Get the hash as a 16 characters hexadecimal string
+	*/
+	static std::string ToString(uint64_t hash);
+
+	/**
+	* @brief Read a hash written by ToString
+	* @return False if the text is not a 16 characters hexadecimal string
+	*/
+	static bool FromString(const std::string& text, uint64_t& hash);
+};
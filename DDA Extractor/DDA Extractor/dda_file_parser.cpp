@@ -6,11 +6,73 @@
 
 #include "dda_file_parser.h"
 
-#include <fstream>
+#include <algorithm>
 #include <filesystem>
 #include <iostream>
 
 #include "mesh_generator.h"
+#include "extraction_stats.h"
+#include "content_hash.h"
+#include "fixture_generator.h"
+
+namespace
+{
+	// Palettes are unswizzled by blocks of 8 colors
+	constexpr size_t PALETTE_BLOCK_COLOR_COUNT = 8;
+	constexpr size_t PALETTE_BLOCK_SIZE = PALETTE_BLOCK_COLOR_COUNT * sizeof(uint32_t);
+
+	// Block of the game palette to use for each block of the fixed palette
+	struct DDAPalettePermutation
+	{
+		uint8_t sourceBlocks[32] = {};
+		size_t blockCount = 0;
+	};
+
+	constexpr DDAPalettePermutation MakeClut256Permutation(DDAClutFixType fixType)
+	{
+		DDAPalettePermutation permutation;
+		permutation.blockCount = 256 / PALETTE_BLOCK_COLOR_COUNT;
+		for (size_t block = 0; block < permutation.blockCount; block++)
+		{
+			// In every group of 32 colors, the colors 8-15 and 16-23 are swapped
+			size_t sourceBlock = (block & ~size_t(3)) | ((block & 1) << 1) | ((block & 2) >> 1);
+
+			// Car skin palettes have 512 colors: groups of 16 colors of the normal skin and of the broken skin one after the other
+			if (fixType == DDAClutFixType::CLUT_CAR_SKIN || fixType == DDAClutFixType::CLUT_BROKEN_CAR_SKIN)
+			{
+				sourceBlock = (sourceBlock / 2) * 4 + sourceBlock % 2;
+				if (fixType == DDAClutFixType::CLUT_BROKEN_CAR_SKIN)
+				{
+					sourceBlock += 2;
+				}
+			}
+			permutation.sourceBlocks[block] = static_cast<uint8_t>(sourceBlock);
+		}
+		return permutation;
+	}
+
+	constexpr DDAPalettePermutation MakeClut16Permutation()
+	{
+		// The 8 last colors are after 8 unused colors
+		DDAPalettePermutation permutation;
+		permutation.blockCount = 2;
+		permutation.sourceBlocks[0] = 0;
+		permutation.sourceBlocks[1] = 2;
+		return permutation;
+	}
+
+	constexpr DDAPalettePermutation CLUT_16_PERMUTATION = MakeClut16Permutation();
+	// Indexed by DDAClutFixType
+	constexpr DDAPalettePermutation CLUT_256_PERMUTATIONS[3] =
+	{
+		MakeClut256Permutation(DDAClutFixType::CLUT_NORMAL),
+		MakeClut256Permutation(DDAClutFixType::CLUT_CAR_SKIN),
+		MakeClut256Permutation(DDAClutFixType::CLUT_BROKEN_CAR_SKIN),
+	};
+
+	// UVs a bit outside of the texture still sample the first frame of an animated texture
+	constexpr float UV_TOLERANCE = 0.001f;
+}
 
 /**
 * @brief Get the address of the skybox texture table header
@@ -20,15 +82,15 @@ uint32_t DDAFileParser::GetSkyboxTextureTableHeader(uint32_t baseHeaderAddress)
 {
 	// The skybox header has the same name as the base header
 	// The "Dams" is the skybox header name of the Dam track, for some reason it's not the same name as the base header
-	const DDATextureTableHeader baseHeader = *(DDATextureTableHeader*)(m_fileData.get() + baseHeaderAddress);
+	const DDATextureTableHeader baseHeader = *(DDATextureTableHeader*)(m_fileData + baseHeaderAddress);
 	uint32_t currentHeaderAddressOffset = baseHeader.blockDataSize + DATA_BLOCK_HEADER_SIZE;
 	
 	// Find the skybox header by comparing the name of all other headers
-	DDATextureTableHeader currentHeader = *(DDATextureTableHeader*)(m_fileData.get() + baseHeaderAddress + currentHeaderAddressOffset);
+	DDATextureTableHeader currentHeader = *(DDATextureTableHeader*)(m_fileData + baseHeaderAddress + currentHeaderAddressOffset);
 	while (strncmp(baseHeader.name, currentHeader.name, DATA_BLOCK_HEADER_NAME_SIZE) != 0 && strncmp(currentHeader.name, "Dams", DATA_BLOCK_HEADER_NAME_SIZE) != 0)
 	{
 		currentHeaderAddressOffset += currentHeader.blockDataSize + DATA_BLOCK_HEADER_SIZE;
-		currentHeader = *(DDATextureTableHeader*)(m_fileData.get() + baseHeaderAddress + currentHeaderAddressOffset);
+		currentHeader = *(DDATextureTableHeader*)(m_fileData + baseHeaderAddress + currentHeaderAddressOffset);
 	}
 
 	return baseHeaderAddress + currentHeaderAddressOffset;
@@ -43,17 +105,17 @@ std::vector<uint32_t> DDAFileParser::GetInGameDataBlockHeaders()
 	std::vector<uint32_t> headers;
 	headers.push_back(0);
 
-	const DDATextureTableHeader baseHeader = *(DDATextureTableHeader*)(m_fileData.get());
+	const DDATextureTableHeader baseHeader = *(DDATextureTableHeader*)(m_fileData);
 	uint32_t currentHeaderAddressOffset = baseHeader.blockDataSize + DATA_BLOCK_HEADER_SIZE;
 	headers.push_back(currentHeaderAddressOffset + 0x70);
 
 	// Get all headers until the end of the file
-	DDATextureTableHeader currentHeader = *(DDATextureTableHeader*)(m_fileData.get() + currentHeaderAddressOffset);
+	DDATextureTableHeader currentHeader = *(DDATextureTableHeader*)(m_fileData + currentHeaderAddressOffset);
 	while (strncmp(baseHeader.name, currentHeader.name, DATA_BLOCK_HEADER_NAME_SIZE) != 0)
 	{
 		currentHeaderAddressOffset += currentHeader.bytesCountBeforeEndFile;
 		headers.push_back(currentHeaderAddressOffset + 0x70);
-		currentHeader = *(DDATextureTableHeader*)(m_fileData.get() + currentHeaderAddressOffset);
+		currentHeader = *(DDATextureTableHeader*)(m_fileData + currentHeaderAddressOffset);
 	}
 	headers.erase(headers.end() - 1);
 
@@ -66,12 +128,12 @@ std::vector<uint32_t> DDAFileParser::GetInGameDataBlockHeaders()
 */
 std::vector<DDATextureHeader> DDAFileParser::GetMenuTextureHeaders(uint32_t tableAddress)
 {
-	const size_t textureCount = *(uint32_t*)(m_fileData.get() + tableAddress + sizeof(uint32_t) * 1);
+	const size_t textureCount = *(uint32_t*)(m_fileData + tableAddress + sizeof(uint32_t) * 1);
 	std::vector<DDATextureHeader> textureHeaders;
 	size_t offset = 0;
 	for (size_t i = 0; i < textureCount; i++)
 	{
-		const DDATextureHeader header = *(DDATextureHeader*)(m_fileData.get() + tableAddress + 0x28 + offset);
+		const DDATextureHeader header = *(DDATextureHeader*)(m_fileData + tableAddress + 0x28 + offset);
 		textureHeaders.push_back(header);
 		offset += 0x90;
 	}
@@ -104,8 +166,8 @@ std::vector<DDATextureHeader> DDAFileParser::GetMenuTextures(uint32_t textureHea
 	if(!exportFolder.empty())
 	{
 		const uint32_t textureTableAddressBefore = textureHeaderListAddress - DATA_BLOCK_HEADER_SIZE;
-		const uint32_t texturesDataSize = *(uint32_t*)(m_fileData.get() + textureTableAddressBefore + sizeof(uint32_t) * 2);
-		const uint32_t textureHeaderListSize = *(uint32_t*)(m_fileData.get() + textureHeaderListAddress + sizeof(uint32_t) * 2);
+		const uint32_t texturesDataSize = *(uint32_t*)(m_fileData + textureTableAddressBefore + sizeof(uint32_t) * 2);
+		const uint32_t textureHeaderListSize = *(uint32_t*)(m_fileData + textureHeaderListAddress + sizeof(uint32_t) * 2);
 		const uint32_t paletteAddress = textureHeaderListSize + texturesDataSize + textureTableAddressBefore;
 
 		for (const DDATextureHeader& header : headers)
@@ -117,18 +179,16 @@ std::vector<DDATextureHeader> DDAFileParser::GetMenuTextures(uint32_t textureHea
 			textureCopyParams.exportWidth = header.width;
 			textureCopyParams.exportHeight = header.height;
 			textureCopyParams.textureName = reducedFileName;
-			std::unique_ptr<uint8_t[]> textureData = std::make_unique<uint8_t[]>(header.width * header.height * sizeof(uint32_t));
 			if (!usePalette)
 			{
-				memcpy(textureData.get(), m_fileData.get() + textureHeaderListAddress + textureHeaderListSize + header.unkown0 - 0x10, header.width * header.height * sizeof(uint8_t) * 4);
+				// The pixels are already RGBA, they are written from the game file without copy
+				textureCopyParams.inputTextureData = m_fileData + textureHeaderListAddress + textureHeaderListSize + header.unkown0 - 0x10;
 				textureCopyParams.clutType = DDAClutType::CLUT_NONE;
 			}
 			else
 			{
-				uint8_t* texturePos = m_fileData.get() + textureHeaderListAddress + textureHeaderListSize + header.unkown0 - DATA_BLOCK_HEADER_SIZE;
-				const uint8_t* palette = m_fileData.get() + paletteAddress + 0x200 * header.indexInDataChunk * 2;
-				std::unique_ptr<uint8_t[]> fixedPalette = GetFixedPalette(palette, DDAClutType::CLUT_256, DDAClutFixType::CLUT_NORMAL);
-				textureCopyParams.palette = std::move(fixedPalette);
+				const uint8_t* texturePos = m_fileData + textureHeaderListAddress + textureHeaderListSize + header.unkown0 - DATA_BLOCK_HEADER_SIZE;
+				textureCopyParams.palette = GetCachedFixedPalette(paletteAddress + 0x200 * header.indexInDataChunk * 2, DDAClutType::CLUT_256, DDAClutFixType::CLUT_NORMAL);
 				textureCopyParams.inputWidth = header.width;
 				textureCopyParams.inputHeight = header.height;
 				textureCopyParams.outputWidth = header.width;
@@ -136,7 +196,7 @@ std::vector<DDATextureHeader> DDAFileParser::GetMenuTextures(uint32_t textureHea
 				textureCopyParams.clutType = DDAClutType::CLUT_256;
 				textureCopyParams.inputTextureData = texturePos;
 			}
-			textureCopyParams.outputTextureData = std::move(textureData);
+			textureCopyParams.contentHash = GetTextureContentHash(textureCopyParams);
 		}
 	}
 
@@ -152,21 +212,22 @@ DDAExtractedData DDAFileParser::LoadFile(const std::string& filePath, DDAGameFil
 {
 	DDAExtractedData extractedData;
 
-	m_fileData = ReadFile(filePath);
-	if (!m_fileData)
+	if (!ReadFile(filePath))
 	{
 		return extractedData;
 	}
+	m_fixedPaletteCache.clear();
 
 	extractedData.fileSize = m_fileSize;
 
+	ExtractionStats::ScopedPhaseTimer tableParseTimer(DDAStatsPhase::TABLE_PARSE);
 	m_fileType = GetFileType();
 	m_gameFile = gameFile;
 	if (m_fileType == DDAGameFileType::MAP || m_fileType == DDAGameFileType::CAR)
 	{
-		const DDATextureTable textureTable = GetTextureTable(*(uint32_t*)(m_fileData.get() + sizeof(uint32_t) * 2), 0x80, true);
+		const DDATextureTable textureTable = GetTextureTable(*(uint32_t*)(m_fileData + sizeof(uint32_t) * 2), 0x80, true);
 		const std::vector<DDAPacketAndTextureEntry> packetAndTextureEntryList = GetPacketAndTextureEntries();
-		const uint32_t baseHeaderAddress = *(uint32_t*)(m_fileData.get() + sizeof(uint32_t) * 2);
+		const uint32_t baseHeaderAddress = *(uint32_t*)(m_fileData + sizeof(uint32_t) * 2);
 
 		extractedData.packetAndTextureEntryList = packetAndTextureEntryList;
 		extractedData.textureTables.push_back(textureTable);
@@ -175,7 +236,7 @@ DDAExtractedData DDAFileParser::LoadFile(const std::string& filePath, DDAGameFil
 		// WINBOWL does not have a skybox
 		if (gameFile != DDAGameFile::WINBOWL && m_fileType != DDAGameFileType::CAR)
 		{
-			const uint32_t baseSkyboxDataHeaderAddress = *(uint32_t*)(m_fileData.get() + sizeof(uint32_t) * 1);
+			const uint32_t baseSkyboxDataHeaderAddress = *(uint32_t*)(m_fileData + sizeof(uint32_t) * 1);
 			const uint32_t skyboxHeaderAddress = GetSkyboxTextureTableHeader(baseHeaderAddress);
 			const DDATextureTable skyboxTextureTable = GetTextureTable(skyboxHeaderAddress, baseSkyboxDataHeaderAddress + 0x80 + 0x80, true);
 			extractedData.textureTables.push_back(skyboxTextureTable);
@@ -190,60 +251,148 @@ DDAExtractedData DDAFileParser::LoadFile(const std::string& filePath, DDAGameFil
 	else if (m_fileType == DDAGameFileType::IN_GAME)
 	{
 		const std::vector<uint32_t> headers = GetInGameDataBlockHeaders();
-		const uint32_t tableAddress = *(uint32_t*)(m_fileData.get() + sizeof(uint32_t) * 2);
+		const uint32_t tableAddress = *(uint32_t*)(m_fileData + sizeof(uint32_t) * 2);
 		uint32_t offset = 0;
 		size_t currentTextureTable = 0;
 		do
 		{
 			const DDATextureTable mapTextureTable = GetTextureTable(tableAddress + offset, headers[currentTextureTable] + DATA_BLOCK_HEADER_SIZE, true);
 			currentTextureTable++;
-			offset += *(uint32_t*)(m_fileData.get() + tableAddress + sizeof(uint32_t) + offset) + DATA_BLOCK_HEADER_SIZE;
+			offset += *(uint32_t*)(m_fileData + tableAddress + sizeof(uint32_t) + offset) + DATA_BLOCK_HEADER_SIZE;
 
 			extractedData.textureTables.push_back(mapTextureTable);
 		} while (m_fileType == DDAGameFileType::IN_GAME && tableAddress + offset < m_fileSize - DATA_BLOCK_HEADER_SIZE);
 	}
 	else if (m_fileType == DDAGameFileType::MENU)
 	{
-		const std::string reducedFileName = GetReducedName(filePath);
-		if (reducedFileName == "DD4FRONT")
+		DDAMenuTextureListAddresses listAddresses;
+		if (GetMenuTextureListAddresses(gameFile, listAddresses))
 		{
-			extractedData.textureHeaders.push_back(GetMenuTextures(0x003BCFD0, false, extractedData.textureCopyParamsList, exportFolder));
-			extractedData.textureHeaders.push_back(GetMenuTextures(0x0055D7C0, true, extractedData.textureCopyParamsList, exportFolder));
-		}
-		else if (reducedFileName == "DD4GAME")
-		{
-			extractedData.textureHeaders.push_back(GetMenuTextures(0x0008D9F0, false, extractedData.textureCopyParamsList, exportFolder));
-			extractedData.textureHeaders.push_back(GetMenuTextures(0x0017D3C0, true, extractedData.textureCopyParamsList, exportFolder));
-		}
-		else if (reducedFileName == "DD4START")
-		{
-			extractedData.textureHeaders.push_back(GetMenuTextures(0x0009F890, false, extractedData.textureCopyParamsList, exportFolder));
-			extractedData.textureHeaders.push_back(GetMenuTextures(0x002222E0, true, extractedData.textureCopyParamsList, exportFolder));
+			extractedData.textureHeaders.push_back(GetMenuTextures(listAddresses.directColorList, false, extractedData.textureCopyParamsList, exportFolder));
+			extractedData.textureHeaders.push_back(GetMenuTextures(listAddresses.paletteList, true, extractedData.textureCopyParamsList, exportFolder));
 		}
 	}
 
 	for(const DDATextureTable& textureTable : extractedData.textureTables)
 	{
-		for (const DDATextureTableEntry& entry: textureTable.entries)
+		for (size_t entryIndex = 0; entryIndex < textureTable.entries.size(); entryIndex++)
 		{
-			CreateTextureCopyParams(extractedData.textureCopyParamsList, entry, m_fileType);
+			// The material uses the first texture of the entry (not the broken car skin)
+			DDAMaterial& material = extractedData.materials.emplace_back();
+			material.name = textureTable.textureNames[entryIndex];
+			material.textureIndex = extractedData.textureCopyParamsList.size();
+
+			CreateTextureCopyParams(extractedData.textureCopyParamsList, textureTable.entries[entryIndex], m_fileType);
 		}
 	}
+	tableParseTimer.Stop();
 
 	extractedData.meshes = GenerateMeshes(extractedData.packetAndTextureEntryList);
+	ScaleAnimatedTextureUVs(extractedData);
 
 	return extractedData;
 }
 
+/**
+* @brief Animated textures are exported as a sheet of stacked frames (see GetFrameCount), the UVs of their sub meshes are scaled to the first frame
+* @brief Sub meshes repeating the texture vertically would sample the other frames, they keep their UVs and use a texture of the first frame only
+*/
+void DDAFileParser::ScaleAnimatedTextureUVs(DDAExtractedData& extractedData)
+{
+	// Material of the first frame texture of each animated texture material, added for the first sub mesh repeating the texture
+	std::unordered_map<uint32_t, uint32_t> firstFrameMaterials;
+	for (DDAMesh& mesh : extractedData.meshes)
+	{
+		for (DDASubMesh& subMesh : mesh.subMeshes)
+		{
+			if (subMesh.materialIndex >= extractedData.materials.size())
+			{
+				continue;
+			}
+
+			const size_t textureIndex = extractedData.materials[subMesh.materialIndex].textureIndex;
+			if (textureIndex >= extractedData.textureCopyParamsList.size() || extractedData.textureCopyParamsList[textureIndex].frameCount <= 1)
+			{
+				continue;
+			}
+
+			bool isTextureRepeated = false;
+			for (const DDAVector2& uv : subMesh.verticesUVs)
+			{
+				if (uv.y < -UV_TOLERANCE || uv.y > 1 + UV_TOLERANCE)
+				{
+					isTextureRepeated = true;
+					break;
+				}
+			}
+
+			if (isTextureRepeated)
+			{
+				auto firstFrameMaterial = firstFrameMaterials.find(subMesh.materialIndex);
+				if (firstFrameMaterial == firstFrameMaterials.end())
+				{
+					firstFrameMaterial = firstFrameMaterials.emplace(subMesh.materialIndex, AddFirstFrameMaterial(extractedData, subMesh.materialIndex)).first;
+				}
+				subMesh.materialIndex = firstFrameMaterial->second;
+				continue;
+			}
+
+			const float frameScale = 1.0f / extractedData.textureCopyParamsList[textureIndex].frameCount;
+			for (DDAVector2& uv : subMesh.verticesUVs)
+			{
+				uv.y *= frameScale;
+			}
+		}
+	}
+}
+
+/**
+* @brief Add a texture with the first frame of the animated texture of a material, and a material using it
+* @brief The texture and the material are added after the ones of the texture tables, the sheet of the frames is still exported
+* @return Index of the added material
+*/
+uint32_t DDAFileParser::AddFirstFrameMaterial(DDAExtractedData& extractedData, uint32_t animatedMaterialIndex)
+{
+	// The frames are read from the game file, the first frame is the top of the sheet
+	const DDATextureCopyParams& animatedCopyParams = extractedData.textureCopyParamsList[extractedData.materials[animatedMaterialIndex].textureIndex];
+	DDATextureCopyParams firstFrameCopyParams;
+	firstFrameCopyParams.inputWidth = animatedCopyParams.inputWidth;
+	firstFrameCopyParams.inputHeight = animatedCopyParams.inputHeight;
+	firstFrameCopyParams.outputWidth = animatedCopyParams.outputWidth;
+	firstFrameCopyParams.outputHeight = animatedCopyParams.outputHeight / animatedCopyParams.frameCount;
+	firstFrameCopyParams.exportWidth = animatedCopyParams.exportWidth;
+	firstFrameCopyParams.exportHeight = animatedCopyParams.exportHeight / animatedCopyParams.frameCount;
+	firstFrameCopyParams.xOffset = animatedCopyParams.xOffset;
+	firstFrameCopyParams.yOffset = animatedCopyParams.yOffset;
+	firstFrameCopyParams.clutType = animatedCopyParams.clutType;
+	firstFrameCopyParams.inputTextureData = animatedCopyParams.inputTextureData;
+	firstFrameCopyParams.palette = animatedCopyParams.palette;
+	firstFrameCopyParams.alternatePalettes = animatedCopyParams.alternatePalettes;
+	firstFrameCopyParams.textureName = animatedCopyParams.textureName + "_Frame0";
+	firstFrameCopyParams.contentHash = GetTextureContentHash(firstFrameCopyParams);
+
+	DDAMaterial firstFrameMaterial;
+	firstFrameMaterial.name = extractedData.materials[animatedMaterialIndex].name + "_Frame0";
+	firstFrameMaterial.textureIndex = extractedData.textureCopyParamsList.size();
+
+	extractedData.textureCopyParamsList.push_back(std::move(firstFrameCopyParams));
+	extractedData.materials.push_back(firstFrameMaterial);
+	return static_cast<uint32_t>(extractedData.materials.size() - 1);
+}
+
 std::vector<DDAMesh> DDAFileParser::GenerateMeshes(const std::vector<DDAPacketAndTextureEntry>& packetAndTextureEntryList)
 {
 	MeshGenerator meshGenerator;
+	ExtractionStats::ScopedPhaseTimer packetScanTimer(DDAStatsPhase::PACKET_SCAN);
 	const std::vector<DDAFileMeshDataInfo> fileMeshDataInfos = meshGenerator.GetMeshDataInfos(m_fileType, m_fileData, packetAndTextureEntryList, false);
+	packetScanTimer.Stop();
 	std::vector<DDAMesh> meshes;
 
+	ExtractionStats::ScopedPhaseTimer meshGenerationTimer(DDAStatsPhase::MESH_GENERATION);
 	for (const DDAFileMeshDataInfo& vifPacket : fileMeshDataInfos)
 	{
 		const DDAMesh ddaMesh = meshGenerator.GenerateMeshFromVifPacket(vifPacket, packetAndTextureEntryList, m_fileData, m_fileType);
+		ExtractionStats::AddCounter(DDAStatsCounter::TRIANGLES, ddaMesh.subMeshes[0].verticesPositions.size() / 3);
 		meshes.push_back(ddaMesh);
 	}
 
@@ -252,12 +401,11 @@ std::vector<DDAMesh> DDAFileParser::GenerateMeshes(const std::vector<DDAPacketAn
 
 void DDAFileParser::CreateTextureCopyParams(std::vector<DDATextureCopyParams>& textureCopyParamsList, const DDATextureTableEntry& textureEntry, DDAGameFileType gameFileType)
 {
-	const size_t realWidth = *((uint32_t*)(m_fileData.get() + textureEntry.textureInfosPosition) + 1);
-	const size_t realHeight = *((uint32_t*)(m_fileData.get() + textureEntry.textureInfosPosition) + 2);
+	const size_t realWidth = *((uint32_t*)(m_fileData + textureEntry.textureInfosPosition) + 1);
+	const size_t realHeight = *((uint32_t*)(m_fileData + textureEntry.textureInfosPosition) + 2);
 
-	const std::string textureFileName = std::string((char*)m_fileData.get() + textureEntry.textureInfosPosition + 16);
+	const std::string textureFileName = std::string((char*)m_fileData + textureEntry.textureInfosPosition + 16);
 
-	const uint8_t* palette = m_fileData.get() + textureEntry.palettePosition;
 	// Cars have two textures with only one texture entry in the table
 	size_t subTexturesCount = 1;
 	if (gameFileType == DDAGameFileType::CAR && textureEntry.width == 512)
@@ -273,8 +421,6 @@ void DDAFileParser::CreateTextureCopyParams(std::vector<DDATextureCopyParams>& t
 			isBrokenCarSkin = true;
 		}
 
-		std::unique_ptr<uint8_t[]> textureData = std::make_unique<uint8_t[]>(textureEntry.width * textureEntry.height * sizeof(uint32_t));
-
 		DDAClutFixType paletteFixType = DDAClutFixType::CLUT_NORMAL;
 		if (gameFileType == DDAGameFileType::CAR && textureEntry.width == 512)
 		{
@@ -289,9 +435,24 @@ void DDAFileParser::CreateTextureCopyParams(std::vector<DDATextureCopyParams>& t
 			}
 		}
 
-		std::unique_ptr<uint8_t[]> fixedPalette = GetFixedPalette(palette, textureEntry.clutType, paletteFixType);
 		DDATextureCopyParams& textureCopyParams = textureCopyParamsList.emplace_back();
-		textureCopyParams.palette = std::move(fixedPalette);
+		textureCopyParams.palette = GetCachedFixedPalette(textureEntry.palettePosition, textureEntry.clutType, paletteFixType);
+
+		// The other palettes of the entry are after the first one (car skins use their two palettes for the normal and broken skins)
+		if (paletteFixType == DDAClutFixType::CLUT_NORMAL && textureEntry.clutCount > 1)
+		{
+			const size_t paletteSize = textureEntry.clutType == DDAClutType::CLUT_16 ? 32 * sizeof(uint32_t) : 256 * sizeof(uint32_t);
+			for (size_t paletteIndex = 1; paletteIndex < textureEntry.clutCount; paletteIndex++)
+			{
+				const size_t palettePosition = textureEntry.palettePosition + paletteIndex * paletteSize;
+				if (palettePosition + paletteSize > m_fileSize)
+				{
+					std::cout << ("[ERROR] Palette " + std::to_string(paletteIndex) + " of " + textureFileName + " is outside of the file\n") << std::flush;
+					break;
+				}
+				textureCopyParams.alternatePalettes.push_back(GetCachedFixedPalette(palettePosition, textureEntry.clutType, paletteFixType));
+			}
+		}
 		textureCopyParams.inputWidth = textureEntry.width;
 		textureCopyParams.inputHeight = textureEntry.height;
 		textureCopyParams.outputWidth = realWidth;
@@ -299,8 +460,8 @@ void DDAFileParser::CreateTextureCopyParams(std::vector<DDATextureCopyParams>& t
 		textureCopyParams.exportWidth = realWidth;
 		textureCopyParams.exportHeight = realHeight;
 		textureCopyParams.clutType = textureEntry.clutType;
-		textureCopyParams.inputTextureData = m_fileData.get() + textureEntry.texturePosition;
-		textureCopyParams.outputTextureData = std::move(textureData);
+		// The pixels are converted from the game file when the texture is dumped, so the textures of a file are not all in memory
+		textureCopyParams.inputTextureData = m_fileData + textureEntry.texturePosition;
 		// With 16 colors palette, it's two pixels per byte
 		if (textureEntry.clutType == DDAClutType::CLUT_16)
 		{
@@ -314,114 +475,240 @@ void DDAFileParser::CreateTextureCopyParams(std::vector<DDATextureCopyParams>& t
 			textureCopyParams.xOffset = 256;
 		}
 
+		if (subTexturesCount == 1)
+		{
+			// The frames of an animated texture are stacked in the entry, they are all exported in one sheet
+			textureCopyParams.frameCount = GetFrameCount(textureEntry, realWidth, realHeight);
+			if (textureCopyParams.frameCount > 1)
+			{
+				textureCopyParams.outputHeight = realHeight * textureCopyParams.frameCount;
+				textureCopyParams.exportHeight = textureCopyParams.outputHeight;
+			}
+			else
+			{
+				textureCopyParams.mipmapCount = GetMipmapCount(textureEntry, realWidth, realHeight);
+			}
+		}
+
 		std::string reducedFileName = GetReducedName(textureFileName);
 		if (isBrokenCarSkin)
 		{
 			reducedFileName += "_Broken";
 		}
 		textureCopyParams.textureName = reducedFileName;
+		textureCopyParams.contentHash = GetTextureContentHash(textureCopyParams);
 	}
 }
 
 /**
-* @brief Palette data is "swizzled" and is "unswizzled" with this function
-* @param palette The palette data to fix
-* @param clutType The type of the CLUT (16 or 256 colors)
-* @param fixType The type of the fix to apply (car skin, broken car skin, etc.)
+* @brief Get the number of levels of a texture, the first level included
+* @brief The mipmap count of the entry is not used alone because it has weird values for animated textures, levels must also fit in the entry size
 */
-std::unique_ptr<uint8_t[]> DDAFileParser::GetFixedPalette(const uint8_t* palette, DDAClutType clutType, DDAClutFixType fixType)
+size_t DDAFileParser::GetMipmapCount(const DDATextureTableEntry& textureEntry, size_t realWidth, size_t realHeight)
 {
-	size_t colorCount = 0;
-	if (clutType == DDAClutType::CLUT_16)
+	if (textureEntry.mipmapCount <= 1 || textureEntry.height < realHeight + realHeight / 2)
 	{
-		colorCount = 16;
+		return 1;
 	}
-	else if (clutType == DDAClutType::CLUT_256)
+
+	// With 16 colors, the width of a level must be even so the next level starts on a byte
+	const size_t minWidth = textureEntry.clutType == DDAClutType::CLUT_16 ? 2 : 1;
+	size_t mipmapCount = 1;
+	size_t mipmapX = 0;
+	for (size_t mipmapLevel = 1; mipmapLevel < textureEntry.mipmapCount; mipmapLevel++)
+	{
+		const size_t mipmapWidth = realWidth >> mipmapLevel;
+		const size_t mipmapHeight = realHeight >> mipmapLevel;
+		if (mipmapWidth < minWidth || mipmapWidth % minWidth != 0 || mipmapHeight == 0 || mipmapX + mipmapWidth > textureEntry.width)
+		{
+			break;
+		}
+		mipmapX += mipmapWidth;
+		mipmapCount++;
+	}
+	return mipmapCount;
+}
+
+/**
+* @brief Get the number of frames of a texture, 1 if it's not animated
+* @brief The frames of an animated entry are one after the other in the data, so the entry is as wide as a frame and a multiple of its height
+* @brief The mipmap count of an animated entry is its frame count (that's the weird value), static textures with a padded entry are not taken as frames
+* @brief Mipmapped entries can also be padded to twice the height, they are frames only if no mipmap fits in the entry
+* @brief With 2 levels padded to twice the height, the mipmap count is also the frame count, the entry has mipmaps if the area beside the second level is empty
+*/
+size_t DDAFileParser::GetFrameCount(const DDATextureTableEntry& textureEntry, size_t realWidth, size_t realHeight)
+{
+	if (textureEntry.mipmapCount <= 1 || realWidth == 0 || realHeight == 0 || textureEntry.width != realWidth || textureEntry.height % realHeight != 0)
 	{
-		colorCount = 256;
+		return 1;
 	}
 
-	std::unique_ptr<uint8_t[]> fixedPalette = std::make_unique<uint8_t[]>(colorCount * sizeof(uint32_t));
-	if (clutType == DDAClutType::CLUT_16)
+	const size_t frameCount = textureEntry.height / realHeight;
+	const size_t mipmapCount = GetMipmapCount(textureEntry, realWidth, realHeight);
+	if (mipmapCount > 1 && (textureEntry.mipmapCount != frameCount || IsMipmapPadding(textureEntry, realWidth, realHeight, mipmapCount)))
 	{
-		memcpy(fixedPalette.get(), palette, 8 * sizeof(uint32_t));
-		memcpy(fixedPalette.get() + 8 * sizeof(uint32_t), palette + 16 * sizeof(uint32_t), 8 * sizeof(uint32_t));
+		return 1;
 	}
-	else if (clutType == DDAClutType::CLUT_256)
+	return frameCount;
+}
+
+/**
+* @brief Check if the entry is empty under the first level, around the other levels
+* @brief The next frames of an animated texture are under the first one, they are not empty
+*/
+bool DDAFileParser::IsMipmapPadding(const DDATextureTableEntry& textureEntry, size_t realWidth, size_t realHeight, size_t mipmapCount)
+{
+	// With 16 colors, it's two pixels per byte
+	size_t bytesPerPixel = 4;
+	size_t pixelsPerByte = 1;
+	if (textureEntry.clutType == DDAClutType::CLUT_16)
 	{
-		const uint8_t* paletteToUse = palette;
-		std::unique_ptr<uint8_t[]> fixedPalette2;
-		if (fixType == DDAClutFixType::CLUT_CAR_SKIN || fixType == DDAClutFixType::CLUT_BROKEN_CAR_SKIN)
-		{
-			fixedPalette2 = std::make_unique<uint8_t[]>(colorCount * sizeof(uint32_t));
+		bytesPerPixel = 1;
+		pixelsPerByte = 2;
+	}
+	else if (textureEntry.clutType == DDAClutType::CLUT_256)
+	{
+		bytesPerPixel = 1;
+	}
+
+	const size_t rowSize = textureEntry.width * bytesPerPixel / pixelsPerByte;
+	if (textureEntry.texturePosition + rowSize * textureEntry.height > m_fileSize)
+	{
+		return false;
+	}
 
-			size_t offsetTotal = 0;
-			for (uint32_t fixStep = 0; fixStep < 16; fixStep++)
+	const uint8_t* entryData = m_fileData + textureEntry.texturePosition;
+	for (size_t y = realHeight; y < textureEntry.height; y++)
+	{
+		// The levels are from left to right, the level is on this row if it's higher than the row
+		size_t mipmapsWidth = 0;
+		for (size_t mipmapLevel = 1; mipmapLevel < mipmapCount; mipmapLevel++)
+		{
+			if (y - realHeight < (realHeight >> mipmapLevel))
 			{
-				const uint32_t colorOffset = 16 * fixStep * sizeof(uint32_t);
-				if (fixType == DDAClutFixType::CLUT_CAR_SKIN)
-				{
-					memcpy(fixedPalette2.get() + colorOffset, paletteToUse + colorOffset + offsetTotal, 16 * sizeof(uint32_t)); // For normal texture
-				}
-				else
-				{
-					memcpy(fixedPalette2.get() + colorOffset, paletteToUse + colorOffset + offsetTotal + 16 * sizeof(uint32_t), 16 * sizeof(uint32_t)); // For crashed texture
-				}
-				offsetTotal += 16 * sizeof(uint32_t);
+				mipmapsWidth += realWidth >> mipmapLevel;
 			}
-			paletteToUse = fixedPalette2.get();
 		}
 
-		// - 8 first colors are correct
-		// --- (For every next 32 colors 8 times)
-		// --- The 16 next colors are in the wrong order (need to swap 8 colors first color with the 8 next one)
-		// --- Then 16 next colors are correct (only the next 7 times)
-		// - 8 last colors are correct
-		memcpy(fixedPalette.get(), paletteToUse, 8 * sizeof(uint32_t));
-		const uint32_t fixStepCount = 8;
-		for (uint32_t fixStep = 0; fixStep < fixStepCount; fixStep++)
+		const uint8_t* row = entryData + y * rowSize;
+		for (size_t x = mipmapsWidth * bytesPerPixel / pixelsPerByte; x < rowSize; x++)
 		{
-			const uint32_t colorOffset = 32 * fixStep * sizeof(uint32_t);
-			memcpy(fixedPalette.get() + 16 * sizeof(uint32_t) + colorOffset, paletteToUse + 8 * sizeof(uint32_t) + colorOffset, 8 * sizeof(uint32_t));
-			memcpy(fixedPalette.get() + 8 * sizeof(uint32_t) + colorOffset, paletteToUse + 16 * sizeof(uint32_t) + colorOffset, 8 * sizeof(uint32_t));
-			if (fixStep != fixStepCount - 1)
+			if (row[x] != 0)
 			{
-				memcpy(fixedPalette.get() + 24 * sizeof(uint32_t) + colorOffset, paletteToUse + 24 * sizeof(uint32_t) + colorOffset, 16 * sizeof(uint32_t));
+				return false;
 			}
 		}
-		memcpy(fixedPalette.get() + 248 * sizeof(uint32_t), paletteToUse + 248 * sizeof(uint32_t), 8 * sizeof(uint32_t));
+	}
+	return true;
+}
+
+/**
+* @brief Hash what is written in the texture files: the size, the indices and the fixed palettes (or the pixels of textures without palette)
+*/
+uint64_t DDAFileParser::GetTextureContentHash(const DDATextureCopyParams& params)
+{
+	const uint64_t textureInfos[4] = { params.exportWidth, params.exportHeight, static_cast<uint64_t>(params.clutType), params.mipmapCount };
+	uint64_t hash = ContentHash::Hash(reinterpret_cast<const uint8_t*>(textureInfos), sizeof(textureInfos));
+
+	if (params.clutType == DDAClutType::CLUT_NONE)
+	{
+		return ContentHash::Hash(params.inputTextureData, params.exportWidth * params.exportHeight * sizeof(uint32_t), hash);
+	}
+
+	// Rows are next to each other if the texture has no mipmap on the right, so most textures are hashed in one call
+	// With mipmaps, the whole entry is hashed since the levels are exported in dds and ktx2 files
+	const uint8_t* indices = params.inputTextureData + params.xOffset;
+	if (params.mipmapCount > 1)
+	{
+		hash = ContentHash::Hash(params.inputTextureData, params.inputWidth * params.inputHeight, hash);
+	}
+	else if (params.inputWidth == params.outputWidth)
+	{
+		hash = ContentHash::Hash(indices, params.outputWidth * params.outputHeight, hash);
+	}
+	else
+	{
+		for (size_t y = 0; y < params.outputHeight; y++)
+		{
+			hash = ContentHash::Hash(indices + y * params.inputWidth, params.outputWidth, hash);
+		}
+	}
+
+	const size_t colorCount = params.clutType == DDAClutType::CLUT_16 ? 16 : 256;
+	hash = ContentHash::Hash(params.palette.get(), colorCount * sizeof(uint32_t), hash);
+	for (const std::shared_ptr<uint8_t[]>& alternatePalette : params.alternatePalettes)
+	{
+		hash = ContentHash::Hash(alternatePalette.get(), colorCount * sizeof(uint32_t), hash);
+	}
+	return hash;
+}
+
+/**
+* @brief Palette data is "swizzled" and is "unswizzled" with this function
+* @param palette The palette data to fix
+* @param clutType The type of the CLUT (16 or 256 colors)
+* @param fixType The type of the fix to apply (car skin, broken car skin, etc.)
+*/
+std::unique_ptr<uint8_t[]> DDAFileParser::GetFixedPalette(const uint8_t* palette, DDAClutType clutType, DDAClutFixType fixType)
+{
+	ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::PALETTE_FIX);
+
+	const DDAPalettePermutation* permutation = nullptr;
+	if (clutType == DDAClutType::CLUT_16)
+	{
+		permutation = &CLUT_16_PERMUTATION;
+	}
+	else if (clutType == DDAClutType::CLUT_256)
+	{
+		permutation = &CLUT_256_PERMUTATIONS[(int)fixType];
+	}
+
+	const size_t blockCount = permutation ? permutation->blockCount : 0;
+	std::unique_ptr<uint8_t[]> fixedPalette = std::make_unique<uint8_t[]>(blockCount * PALETTE_BLOCK_SIZE);
+	// Fixed size copies, each one is done with one or two vector registers
+	for (size_t block = 0; block < blockCount; block++)
+	{
+		memcpy(fixedPalette.get() + block * PALETTE_BLOCK_SIZE, palette + permutation->sourceBlocks[block] * PALETTE_BLOCK_SIZE, PALETTE_BLOCK_SIZE);
 	}
 
 	return fixedPalette;
 }
 
 /**
-* @brief Read all bytes of a file and return them as a unique pointer
+* @brief Get the fixed palette of a palette of the file, textures using the same palette share the same fixed palette
+* @param palettePosition Position of the palette in the file
 */
-std::unique_ptr<uint8_t[]> DDAFileParser::ReadFile(const std::string& file)
+std::shared_ptr<uint8_t[]> DDAFileParser::GetCachedFixedPalette(size_t palettePosition, DDAClutType clutType, DDAClutFixType fixType)
 {
-	const std::string fileToOpen = file;
+	// One byte for each type: the clut type values (19 and 20) do not fit in 4 bits
+	const uint64_t key = (static_cast<uint64_t>(palettePosition) << 16) | (static_cast<uint64_t>(fixType) << 8) | static_cast<uint64_t>(clutType);
+	std::shared_ptr<uint8_t[]>& fixedPalette = m_fixedPaletteCache[key];
+	if (!fixedPalette)
+	{
+		fixedPalette = GetFixedPalette(m_fileData + palettePosition, clutType, fixType);
+	}
+	return fixedPalette;
+}
 
-	std::fstream fileSteam;
-	fileSteam.open(fileToOpen, std::ios::in | std::ios::binary);
+/**
+* @brief Map the file in memory, the data is not copied
+*/
+bool DDAFileParser::ReadFile(const std::string& file)
+{
+	ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::READ);
+	m_fileData = nullptr;
+	m_fileSize = 0;
 
-	if (!fileSteam.is_open())
+	if (!m_mappedFile.Open(file))
 	{
 		std::cout << "[ERROR] File not opened: " + file << std::endl;
-		return nullptr;
+		return false;
 	}
 
-	// Get file size
-	fileSteam.seekg(0, fileSteam.end);
-	m_fileSize = fileSteam.tellg();
-	fileSteam.seekg(0, fileSteam.beg);
+	m_fileData = m_mappedFile.GetData();
+	m_fileSize = m_mappedFile.GetSize();
 
-	// Read file
-	std::unique_ptr<uint8_t[]> data = std::make_unique<uint8_t[]>(m_fileSize);
-	fileSteam.read((char*)data.get(), m_fileSize);
-	fileSteam.close();
-
-	return data;
+	return true;
 }
 
 /**
@@ -429,7 +716,7 @@ std::unique_ptr<uint8_t[]> DDAFileParser::ReadFile(const std::string& file)
 */
 DDAGameFileType DDAFileParser::GetFileType()
 {
-	const DDAGameFileType fileType = (DDAGameFileType)(*((uint32_t*)m_fileData.get()));
+	const DDAGameFileType fileType = (DDAGameFileType)(*((uint32_t*)m_fileData));
 
 	return fileType;
 }
@@ -447,9 +734,9 @@ std::vector<DDAPacketAndTextureEntry> DDAFileParser::GetPacketAndTextureEntries(
 	std::vector<DDAPacketAndTextureEntry> list;
 
 	//------------------------------------------------------------------- Read packet mesh and texture id table
-	const uint32_t meshPacketTableEntryCount = *(uint32_t*)(m_fileData.get() + GetHeaderOffset(m_fileType) + sizeof(uint32_t));
-	const uint32_t meshPacketTableAddr = static_cast<uint32_t>(*(m_fileData.get() + GetHeaderOffset(m_fileType) + 2 * sizeof(uint32_t)) + GetHeaderOffset(m_fileType)); // CHECK IF TWO HEADEROFFSET IS CORRECT
-	const DDAParentDrawCommandEntry* meshPacketTablePtr = (DDAParentDrawCommandEntry*)(m_fileData.get() + meshPacketTableAddr);
+	const uint32_t meshPacketTableEntryCount = *(uint32_t*)(m_fileData + GetHeaderOffset(m_fileType) + sizeof(uint32_t));
+	const uint32_t meshPacketTableAddr = static_cast<uint32_t>(*(m_fileData + GetHeaderOffset(m_fileType) + 2 * sizeof(uint32_t)) + GetHeaderOffset(m_fileType)); // CHECK IF TWO HEADEROFFSET IS CORRECT
+	const DDAParentDrawCommandEntry* meshPacketTablePtr = (DDAParentDrawCommandEntry*)(m_fileData + meshPacketTableAddr);
 
 	std::vector<DDAParentDrawCommandEntry> meshPacketEntryList;
 
@@ -460,7 +747,7 @@ std::vector<DDAPacketAndTextureEntry> DDAFileParser::GetPacketAndTextureEntries(
 
 		for (size_t packetIndex = 0; packetIndex < meshPacketEntry.vifPacketTexturePairCount; packetIndex++)
 		{
-			DDAPacketAndTextureEntry packetAndTextureEntry = *((DDAPacketAndTextureEntry*)(m_fileData.get() + meshPacketEntry.addr + GetHeaderOffset(m_fileType)) + packetIndex);
+			DDAPacketAndTextureEntry packetAndTextureEntry = *((DDAPacketAndTextureEntry*)(m_fileData + meshPacketEntry.addr + GetHeaderOffset(m_fileType)) + packetIndex);
 			list.push_back(packetAndTextureEntry);
 		}
 	}
@@ -473,23 +760,23 @@ DDATextureTable DDAFileParser::GetTextureTable(uint32_t tableAddress, uint32_t t
 	DDATextureTable textureTable;
 	if (m_fileType == DDAGameFileType::MAP || m_fileType == DDAGameFileType::IN_GAME || m_fileType == DDAGameFileType::CAR)
 	{
-		textureTable.header = *(DDATextureTableHeader*)(m_fileData.get() + tableAddress);
+		textureTable.header = *(DDATextureTableHeader*)(m_fileData + tableAddress);
 
 		textureTable.textureCount = textureTable.header.size / sizeof(DDATextureTableEntry);
 		textureTable.entries.resize(textureTable.textureCount);
 		textureTable.textureNames.resize(textureTable.textureCount);
-		const DDATextureTableEntry* entries = (DDATextureTableEntry*)(m_fileData.get() + tableAddress + textureTable.header.offset + DATA_BLOCK_HEADER_SIZE);
+		const DDATextureTableEntry* entries = (DDATextureTableEntry*)(m_fileData + tableAddress + textureTable.header.offset + DATA_BLOCK_HEADER_SIZE);
 
 		memcpy(textureTable.entries.data(), entries, textureTable.textureCount * sizeof(DDATextureTableEntry));
 
 		size_t index = 0;
 		for (DDATextureTableEntry& entry : textureTable.entries)
 		{
-			textureTable.textureHeaders.push_back(*(DDATextureHeader*)(m_fileData.get() + entry.textureInfosPosition + textureInfoOffset));
+			textureTable.textureHeaders.push_back(*(DDATextureHeader*)(m_fileData + entry.textureInfosPosition + textureInfoOffset));
 			entry.textureInfosPosition += textureInfoOffset;
 			entry.palettePosition += textureInfoOffset;
 			entry.texturePosition += textureInfoOffset;
-			const std::string textureFilePath = std::string((char*)m_fileData.get() + entry.textureInfosPosition + 16);
+			const std::string textureFilePath = std::string((char*)m_fileData + entry.textureInfosPosition + 16);
 			const std::string textureName = GetReducedName(textureFilePath);
 			textureTable.textureNames[index] = textureName;
 			index++;
@@ -500,15 +787,15 @@ DDATextureTable DDAFileParser::GetTextureTable(uint32_t tableAddress, uint32_t t
 		uint32_t offset = 0;
 		do
 		{
-			DDATextureTableEntry entry = *(DDATextureTableEntry*)(m_fileData.get() + tableAddress + DATA_BLOCK_HEADER_SIZE + offset);
+			DDATextureTableEntry entry = *(DDATextureTableEntry*)(m_fileData + tableAddress + DATA_BLOCK_HEADER_SIZE + offset);
 			entry.textureInfosPosition += offset + textureInfoOffset;
 			entry.palettePosition += offset + textureInfoOffset;
 			entry.texturePosition += offset + textureInfoOffset;
 
-			offset += *(uint32_t*)(m_fileData.get() + tableAddress + sizeof(uint32_t) + offset) + DATA_BLOCK_HEADER_SIZE;
+			offset += *(uint32_t*)(m_fileData + tableAddress + sizeof(uint32_t) + offset) + DATA_BLOCK_HEADER_SIZE;
 			textureTable.entries.push_back(entry);
 
-			const std::string textureFilePath = std::string((char*)m_fileData.get() + entry.textureInfosPosition + 16);
+			const std::string textureFilePath = std::string((char*)m_fileData + entry.textureInfosPosition + 16);
 			const std::string textureName = GetReducedName(textureFilePath);
 
 			textureTable.textureNames.push_back(textureName);
@@ -580,14 +867,90 @@ void DDAFileParser::LaunchUnitTests(const std::string& gameFolderPath)
 	LaunchUnitTest(gameFolderPath, DDAGameFile::DD4START, 0x2BC160, 326, 0);
 }
 
-void DDAFileParser::LaunchUnitTest(const std::string& gameFolderPath, DDAGameFile gameFile, size_t expectedFileSize, size_t expectedTextureCount, size_t expectedMeshPacketCount)
+/**
+* @brief Load a file and check what the parser found
+* @param checkMeshPacketCount Also check the number of mesh packets, the expected counts of the game files are not all verified
+* @return True if the test passed
+*/
+bool DDAFileParser::LaunchUnitTest(const std::string& gameFolderPath, DDAGameFile gameFile, size_t expectedFileSize, size_t expectedTextureCount, size_t expectedMeshPacketCount, bool checkMeshPacketCount)
 {
-	bool passed = true;
-	DDAExtractedData data = LoadFile(gameFolderPath, gameFile, "");
+	const DDAExtractedData data = LoadFile(gameFolderPath + filesNames[(int)gameFile], gameFile, "");
+	const bool passed = CheckExtractedData(data, gameFile, expectedFileSize, expectedTextureCount, expectedMeshPacketCount, checkMeshPacketCount);
+	if (passed)
+	{
+		std::cout << "Test passed " + filesNames[(int)gameFile] << std::endl;
+	}
+
+	return passed;
+}
 
+/**
+* @brief Load a generated file (see DDAFixtureGenerator) and check what the parser found, the mipmaps, frames and palettes of the textures too
+* @return True if the test passed
+*/
+bool DDAFileParser::LaunchUnitTest(const std::string& gameFolderPath, DDAGameFile gameFile, const DDAFixtureExpectations& expectations)
+{
+	const DDAExtractedData data = LoadFile(gameFolderPath + filesNames[(int)gameFile], gameFile, "");
+	bool passed = CheckExtractedData(data, gameFile, expectations.fileSize, expectations.textureCount, expectations.meshPacketCount, true);
+
+	size_t mipmapLevelCount = 0;
+	size_t frameCount = 0;
+	size_t alternatePaletteCount = 0;
+	for (const DDATextureCopyParams& textureCopyParams : data.textureCopyParamsList)
+	{
+		mipmapLevelCount += textureCopyParams.mipmapCount - 1;
+		frameCount += textureCopyParams.frameCount > 1 ? textureCopyParams.frameCount : 0;
+		alternatePaletteCount += textureCopyParams.alternatePalettes.size();
+	}
+
+	// The first frame materials are after the ones of the texture table entries
+	size_t entryCount = 0;
+	for (const DDATextureTable& textureTable : data.textureTables)
+	{
+		entryCount += textureTable.entries.size();
+	}
+	const size_t firstFrameTextureCount = data.materials.size() - std::min(entryCount, data.materials.size());
+
+	const std::pair<std::string, std::pair<size_t, size_t>> counts[] =
+	{
+		{ "mipmap level", { expectations.mipmapLevelCount, mipmapLevelCount } },
+		{ "animation frame", { expectations.frameCount, frameCount } },
+		{ "alternate palette", { expectations.alternatePaletteCount, alternatePaletteCount } },
+		{ "first frame texture", { expectations.firstFrameTextureCount, firstFrameTextureCount } },
+	};
+	for (const auto& count : counts)
+	{
+		if (count.second.first != count.second.second)
+		{
+			std::cout << "[ERROR] Test not passed: wrong " + count.first + " count for " + filesNames[(int)gameFile] + ", expected: " + std::to_string(count.second.first) + ", actual: " + std::to_string(count.second.second) << std::endl;
+			passed = false;
+		}
+	}
+
+	if (!CheckFixedPaletteCache(data, gameFile))
+	{
+		passed = false;
+	}
+
+	if (passed)
+	{
+		std::cout << "Test passed " + filesNames[(int)gameFile] << std::endl;
+	}
+
+	return passed;
+}
+
+/**
+* @brief Check the file size, the texture count and the mesh packet count found by the parser
+* @return True if all counts are the expected ones
+*/
+bool DDAFileParser::CheckExtractedData(const DDAExtractedData& data, DDAGameFile gameFile, size_t expectedFileSize, size_t expectedTextureCount, size_t expectedMeshPacketCount, bool checkMeshPacketCount)
+{
+	bool passed = true;
 	if (m_fileSize != expectedFileSize)
 	{
 		std::cout << "[ERROR] Test not passed: wrong file size for " + filesNames[(int)gameFile] + ", expected: " + std::to_string(expectedFileSize) + ", actual: " + std::to_string(m_fileSize) << std::endl;
+		passed = false;
 	}
 
 	bool hasTextures = !data.textureTables.empty() || !data.textureHeaders.empty();
@@ -617,11 +980,54 @@ void DDAFileParser::LaunchUnitTest(const std::string& gameFolderPath, DDAGameFil
 		if (textureCount != expectedTextureCount)
 		{
 			std::cout << "[ERROR] Test not passed: No wrong texture count for " + filesNames[(int)gameFile] + ", expected: " + std::to_string(expectedTextureCount) + ", actual: " + std::to_string(textureCount) << std::endl;
+			passed = false;
 		}
 	}
 
-	if (passed)
+	if (checkMeshPacketCount && data.meshes.size() != expectedMeshPacketCount)
 	{
-		std::cout << "Test passed " + filesNames[(int)gameFile] << std::endl;
+		std::cout << "[ERROR] Test not passed: wrong mesh packet count for " + filesNames[(int)gameFile] + ", expected: " + std::to_string(expectedMeshPacketCount) + ", actual: " + std::to_string(data.meshes.size()) << std::endl;
+		passed = false;
+	}
+
+	return passed;
+}
+
+/**
+* @brief Check that the cached fixed palettes of a car file are the ones of their fix type, a palette position is asked with each fix type
+* @return True if the cached palettes are the same as the uncached ones
+*/
+bool DDAFileParser::CheckFixedPaletteCache(const DDAExtractedData& data, DDAGameFile gameFile)
+{
+	// Car skin palettes have 512 colors, only car files have enough data after each palette
+	if (m_fileType != DDAGameFileType::CAR)
+	{
+		return true;
+	}
+
+	const DDAClutFixType fixTypes[] = { DDAClutFixType::CLUT_NORMAL, DDAClutFixType::CLUT_CAR_SKIN, DDAClutFixType::CLUT_BROKEN_CAR_SKIN };
+	const size_t paletteSize = 256 * sizeof(uint32_t);
+	for (const DDATextureTable& textureTable : data.textureTables)
+	{
+		for (const DDATextureTableEntry& textureEntry : textureTable.entries)
+		{
+			if (textureEntry.clutType != DDAClutType::CLUT_256)
+			{
+				continue;
+			}
+
+			for (DDAClutFixType fixType : fixTypes)
+			{
+				const std::shared_ptr<uint8_t[]> cachedPalette = GetCachedFixedPalette(textureEntry.palettePosition, textureEntry.clutType, fixType);
+				const std::unique_ptr<uint8_t[]> fixedPalette = GetFixedPalette(m_fileData + textureEntry.palettePosition, textureEntry.clutType, fixType);
+				if (memcmp(cachedPalette.get(), fixedPalette.get(), paletteSize) != 0)
+				{
+					std::cout << "[ERROR] Test not passed: wrong cached palette for " + filesNames[(int)gameFile] + ", palette position: " + std::to_string(textureEntry.palettePosition) + ", fix type: " + std::to_string((int)fixType) << std::endl;
+					return false;
+				}
+			}
+		}
 	}
+
+	return true;
 }
\ No newline at end of file
@@ -9,42 +9,57 @@
 #include <string>
 #include <memory>
 #include <vector>
+#include <unordered_map>
 
 #include "dda_structures.h"
+#include "mapped_file.h"
 
 class Material;
 class GameObject;
+struct DDAFixtureExpectations;
 
 class DDAFileParser
 {
 public:
 	DDAExtractedData LoadFile(const std::string& filePath, DDAGameFile gameFile, const std::string& exportFolder);
 	void LaunchUnitTests(const std::string& gameFolderPath);
+	std::unique_ptr<uint8_t[]> GetFixedPalette(const uint8_t* palette, DDAClutType clutType, DDAClutFixType fixType);
+	bool LaunchUnitTest(const std::string& gameFolderPath, DDAGameFile gameFile, size_t expectedFileSize, size_t expectedTextureCount, size_t expectedMeshPacketCount, bool checkMeshPacketCount = false);
+	bool LaunchUnitTest(const std::string& gameFolderPath, DDAGameFile gameFile, const DDAFixtureExpectations& expectations);
 
 private:
-	std::unique_ptr<uint8_t[]> ReadFile(const std::string& file);
+	bool ReadFile(const std::string& file);
 	DDAGameFileType GetFileType();
 	std::vector<DDAPacketAndTextureEntry> GetPacketAndTextureEntries();
 	DDATextureTable GetTextureTable(uint32_t tableAddress, uint32_t textureInfoOffset, bool enableLogging);
 
 	uint32_t GetSkyboxTextureTableHeader(uint32_t baseHeaderAddress);
 	void CopyTextureData(const DDATextureCopyParams& params);
-	std::unique_ptr<uint8_t[]> GetFixedPalette(const uint8_t* palette, DDAClutType clutType, DDAClutFixType fixType);
 	std::vector<uint32_t> GetInGameDataBlockHeaders();
 	std::vector<DDATextureHeader> GetMenuTextureHeaders(uint32_t tableAddress);
 	std::string GetReducedName(const std::string& fullTextureName);
 	std::vector<DDATextureHeader> GetMenuTextures(uint32_t textureTableAddress, bool usePalette, std::vector<DDATextureCopyParams>& textureCopyParamsList, const std::string& exportFolder);
 	void CreateTextureCopyParams(std::vector<DDATextureCopyParams>& textureCopyParamsList, const DDATextureTableEntry& textureEntry, DDAGameFileType gameFileType);
+	uint64_t GetTextureContentHash(const DDATextureCopyParams& params);
+	size_t GetMipmapCount(const DDATextureTableEntry& textureEntry, size_t realWidth, size_t realHeight);
+	size_t GetFrameCount(const DDATextureTableEntry& textureEntry, size_t realWidth, size_t realHeight);
+	bool IsMipmapPadding(const DDATextureTableEntry& textureEntry, size_t realWidth, size_t realHeight, size_t mipmapCount);
+	std::shared_ptr<uint8_t[]> GetCachedFixedPalette(size_t palettePosition, DDAClutType clutType, DDAClutFixType fixType);
 	std::vector<DDAMesh> GenerateMeshes(const std::vector<DDAPacketAndTextureEntry>& packetAndTextureEntryList);
+	void ScaleAnimatedTextureUVs(DDAExtractedData& extractedData);
+	uint32_t AddFirstFrameMaterial(DDAExtractedData& extractedData, uint32_t animatedMaterialIndex);
+	bool CheckExtractedData(const DDAExtractedData& data, DDAGameFile gameFile, size_t expectedFileSize, size_t expectedTextureCount, size_t expectedMeshPacketCount, bool checkMeshPacketCount);
+	bool CheckFixedPaletteCache(const DDAExtractedData& data, DDAGameFile gameFile);
 	
-
-	void LaunchUnitTest(const std::string& gameFolderPath, DDAGameFile gameFile, size_t expectedFileSize, size_t expectedTextureCount, size_t expectedMeshPacketCount);
 	
 	size_t maxObjectToSpawn = 9999;
-	std::unique_ptr<uint8_t[]> m_fileData;
+	MappedFile m_mappedFile;
+	const uint8_t* m_fileData = nullptr;
 	bool groupMeshByMaterial = false;
 	DDAGameFileType m_fileType = DDAGameFileType::CAR;
 	size_t m_fileSize = 0;
 	std::vector<std::shared_ptr<Material>> materials;
 	DDAGameFile m_gameFile;
+	// Fixed palettes by position in the file, fix type and clut type
+	std::unordered_map<uint64_t, std::shared_ptr<uint8_t[]>> m_fixedPaletteCache;
 };
\ No newline at end of file
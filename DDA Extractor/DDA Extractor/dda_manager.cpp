@@ -6,6 +6,7 @@
 
 #include "dda_manager.h"
 
+#include <algorithm>
 #include <filesystem>
 
 #include <assimp/Exporter.hpp>
@@ -15,6 +16,17 @@
 #include "dda_file_parser.h"
 #include "texture_dumper.h"
 #include "mesh_generator.h"
+#include "worker_pool.h"
+#include "extraction_stats.h"
+#include "trace_recorder.h"
+#include "mapped_file.h"
+#include "content_hash.h"
+#include "extraction_manifest.h"
+#include "glb_exporter.h"
+#include "texture_atlas_builder.h"
+#include "frame_table_writer.h"
+#include "texture_alpha_writer.h"
+#include "texture_usage_graph.h"
 #include <iostream>
 
 // Top fix the map in blender, you have to follow these steps:
@@ -25,31 +37,32 @@
 // Alt + N (Open the Mesh->Normals menu)
 // F (Flip normals)
 
-void DDAManager::CreateFXBMesh(const std::vector<DDAMesh>& meshes, const std::vector<DDATextureTable>& textureTableList, const std::string& exportFolder)
+void DDAManager::CreateFXBMesh(const std::vector<DDAMesh>& meshes, const std::vector<DDAMaterial>& materials, const std::string& exportFolder)
 {
+	ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::FBX_EXPORT);
 	const unsigned int meshCount = static_cast<unsigned int>(meshes.size());
 
 	std::vector<aiMaterial*> assimpMaterials;
 
-	for (const DDATextureTable& textureTable : textureTableList)
+	for (const DDAMaterial& material : materials)
 	{
-		const std::vector<DDATextureTableEntry>& entryList = textureTable.entries;
-		const size_t textureCount = entryList.size();
+		aiMaterial* assimpMaterial = new aiMaterial();
+		const aiColor3D diffuseColor(1.0f, 1.0f, 1.0f);
+		assimpMaterial->AddProperty(&diffuseColor, 1, AI_MATKEY_COLOR_DIFFUSE);
 
-		for (size_t i = 0; i < textureCount; i++)
+		const aiString name(material.name);
+		assimpMaterial->AddProperty(&name, AI_MATKEY_NAME);
+		if (!material.textureFileName.empty())
 		{
-			const std::string textureName = textureTable.textureNames[i];
-			aiMaterial* assimpMaterial = new aiMaterial();
-			const aiColor3D diffuseColor(1.0f, 1.0f, 1.0f);
-			assimpMaterial->AddProperty(&diffuseColor, 1, AI_MATKEY_COLOR_DIFFUSE);
-
-			const aiString name(textureName);
-			const aiString assimpPextureName(textureName + ".png");
-			assimpMaterial->AddProperty(&name, AI_MATKEY_NAME);
+			const aiString assimpPextureName(material.textureFileName);
 			assimpMaterial->AddProperty(&assimpPextureName, AI_MATKEY_TEXTURE_DIFFUSE(0));
 
-			assimpMaterials.push_back(assimpMaterial);
+			// Tell the importers if the alpha of the texture is used
+			const int textureFlags = material.alphaType == DDAAlphaType::ALPHA_OPAQUE ? aiTextureFlags_IgnoreAlpha : aiTextureFlags_UseAlpha;
+			assimpMaterial->AddProperty(&textureFlags, 1, AI_MATKEY_TEXFLAGS_DIFFUSE(0));
 		}
+
+		assimpMaterials.push_back(assimpMaterial);
 	}
 
 	const size_t materialCount = assimpMaterials.size();
@@ -134,37 +147,353 @@ void DDAManager::CreateFXBMesh(const std::vector<DDAMesh>& meshes, const std::ve
 		scene->mMaterials[i] = assimpMaterials[i];
 	}
 
+	TraceRecorder::ScopedEvent traceEvent("AssimpExport", exportFolder + "output.fbx");
 	Assimp::Exporter exporter;
 	const aiReturn result = exporter.Export(scene, "fbx", exportFolder + "output.fbx", aiProcess_FlipUVs);
+	if (ExtractionStats::IsEnabled())
+	{
+		std::error_code error;
+		const uintmax_t fileSize = std::filesystem::file_size(exportFolder + "output.fbx", error);
+		ExtractionStats::AddCounter(DDAStatsCounter::BYTES_WRITTEN, error ? 0 : fileSize);
+	}
 	//aiReturn result2 = exporter.Export(scene, "obj", "output.obj", aiProcess_FlipUVs);
 }
 
+bool DDAManager::CanMeshesLoadTextures(DDAMeshFormat meshFormat, DDATextureFormat textureFormat)
+{
+	if (meshFormat == DDAMeshFormat::GLB)
+	{
+		return textureFormat == DDATextureFormat::PNG;
+	}
+	return textureFormat == DDATextureFormat::PNG || textureFormat == DDATextureFormat::DDS;
+}
+
+std::string DDAManager::GetManifestSettings() const
+{
+	std::string settings = std::string("mesh_format=") + (m_meshFormat == DDAMeshFormat::GLB ? "glb" : "fbx");
+	settings += std::string(";indexed_png=") + (m_textureExportOptions.indexedColors ? "1" : "0");
+	const char* pngCompressionNames[] = { "default", "stored", "fast", "max" };
+	settings += std::string(";png_compression=") + pngCompressionNames[(int)m_textureExportOptions.pngCompression];
+	settings += std::string(";texture_format=") + (TextureDumper::GetFileExtension(m_textureExportOptions.textureFormat) + 1);
+	const char* blockCompressionNames[] = { "none", "bc1_bc3", "bc7" };
+	settings += std::string(";block_compression=") + blockCompressionNames[(int)m_textureExportOptions.blockCompression];
+	settings += std::string(";texture_atlas=") + (m_textureAtlas ? "1" : "0");
+	settings += std::string(";used_textures_only=") + (m_usedTexturesOnly ? "1" : "0");
+	return settings;
+}
+
 void DDAManager::ExtractData(DDAGameFile gameFile, const std::string& exportFolder)
 {
-	std::cout << "Extracting: " << filesNames[(int)gameFile] << std::endl;
+	ExtractionStats::FileScope fileScope(gameFile, true);
+	TraceRecorder::ScopedEvent traceEvent("ExtractData", filesNames[(int)gameFile]);
+
 	DDAFileParser fileParser;
-	TextureDumper textureDumper;
 
 	const std::string filePath = m_gameFolderPath + filesNames[(int)gameFile];
 
 	const std::string finalExportFolder = exportFolder + filesNames[(int)gameFile].substr(0, filesNames[(int)gameFile].find_last_of(".")) + "\\";
 
-	const bool extractFolderExists = std::filesystem::exists(finalExportFolder);
-	if (!extractFolderExists)
+	std::filesystem::create_directories(finalExportFolder);
+
+	// Hash the input to know if the previous extraction of this file can be kept
+	ExtractionManifest currentManifest;
+	{
+		MappedFile inputFile;
+		if (!inputFile.Open(filePath))
+		{
+			std::cout << ("[ERROR] Cannot open file: " + filePath + "\n") << std::flush;
+			return;
+		}
+		currentManifest.extractorVersion = EXTRACTOR_VERSION;
+		currentManifest.settings = GetManifestSettings();
+		currentManifest.inputFile = filesNames[(int)gameFile];
+		currentManifest.inputSize = inputFile.GetSize();
+		currentManifest.inputHash = ContentHash::ToString(ContentHash::Hash(inputFile.GetData(), inputFile.GetSize()));
+	}
+
+	ExtractionManifest previousManifest;
+	const bool hasPreviousManifest = previousManifest.Load(finalExportFolder);
+	if (!m_forceExtraction && hasPreviousManifest && previousManifest.IsUpToDate(currentManifest, finalExportFolder))
+	{
+		std::cout << ("Up to date: " + filesNames[(int)gameFile] + "\n") << std::flush;
+
+		// The textures of this file are kept, the next files of this run can be linked to them
+		if (m_textureDeduplication)
+		{
+			for (const DDAManifestOutput& previousOutput : previousManifest.outputs)
+			{
+				uint64_t contentHash;
+				if (ContentHash::FromString(previousOutput.contentHash, contentHash))
+				{
+					m_textureStore.Add(contentHash, finalExportFolder + previousOutput.path);
+				}
+			}
+		}
+		return;
+	}
+
+	// Print the line in one call so lines from parallel extractions are not mixed
+	std::cout << ("Extracting: " + filesNames[(int)gameFile] + "\n") << std::flush;
+
+	// Remove the manifest first, if the extraction is interrupted the file will be extracted again on the next run
+	ExtractionManifest::Remove(finalExportFolder);
+
+	DDAExtractedData data = fileParser.LoadFile(filePath, gameFile, finalExportFolder);
+
+	// Names are chosen before dumping, so the files get the same names whatever the dump order is
+	const std::vector<std::string> textureFilePaths = TextureDumper::GetTextureFilePaths(data.textureCopyParamsList, finalExportFolder, m_textureExportOptions.textureFormat);
+	const size_t textureCount = data.textureCopyParamsList.size();
+
+	// Textures not used by the mesh packets are skipped, their names are still chosen so the names do not depend on this option
+	const TextureUsageGraph textureUsageGraph(data);
+	const bool usedTexturesOnly = m_usedTexturesOnly && textureUsageGraph.HasPackets();
+	const auto isTextureWritten = [&](size_t textureIndex)
+		{
+			return !usedTexturesOnly || textureUsageGraph.IsTextureUsed(textureIndex);
+		};
+
+	const size_t workerCount = WorkerPool::GetWorkerCount(textureCount, m_textureJobCount);
+
+	// Threads not used by the texture workers compress the parts of large textures (car skins for example)
+	DDATextureExportOptions textureExportOptions = m_textureExportOptions;
+	textureExportOptions.compressionJobCount = std::max<size_t>(WorkerPool::GetWorkerCount(SIZE_MAX, m_textureJobCount) / workerCount, 1);
+	std::vector<TextureDumper> textureDumpers(workerCount, TextureDumper(textureExportOptions));
+	std::vector<std::string> textureSourceFilePaths(textureCount);
+	std::vector<std::vector<DDAAlphaType>> textureAlphaTypes(textureCount);
+	WorkerPool::ParallelFor(textureCount, workerCount, [&](size_t textureIndex, size_t workerIndex)
+		{
+			if (!isTextureWritten(textureIndex))
+			{
+				return;
+			}
+
+			ExtractionStats::FileScope textureFileScope(gameFile);
+			const DDATextureCopyParams& textureCopyParams = data.textureCopyParamsList[textureIndex];
+			const std::string& textureFilePath = textureFilePaths[textureIndex];
+			const std::vector<std::string> paletteFilePaths = TextureDumper::GetPaletteFilePaths(textureCopyParams, textureFilePath, textureExportOptions.textureFormat);
+
+			// The files of the previous extraction may be hardlinks to the textures of another game file, they must not be modified
+			for (const std::string& paletteFilePath : paletteFilePaths)
+			{
+				std::error_code error;
+				std::filesystem::remove(paletteFilePath, error);
+			}
+
+			// The frame table is small, it's written for each game file even if the sheet is deduplicated
+			if (textureCopyParams.frameCount > 1 && !FrameTableWriter::Write(textureCopyParams, paletteFilePaths, FrameTableWriter::GetFilePath(textureFilePath)))
+			{
+				std::cout << ("[ERROR] Cannot write the frame table of " + textureFilePath + "\n") << std::flush;
+			}
+
+			// Found from the colors used by the indices, for each palette, so the importers do not have to read the pixels
+			std::vector<DDAAlphaType>& alphaTypes = textureAlphaTypes[textureIndex];
+			alphaTypes.push_back(TextureDumper::GetAlphaType(textureCopyParams, textureCopyParams.palette.get()));
+			for (const std::shared_ptr<uint8_t[]>& alternatePalette : textureCopyParams.alternatePalettes)
+			{
+				alphaTypes.push_back(TextureDumper::GetAlphaType(textureCopyParams, alternatePalette.get()));
+			}
+
+			if (!m_textureDeduplication)
+			{
+				textureDumpers[workerIndex].DumpTexture(textureCopyParams, textureFilePath);
+				return;
+			}
+
+			std::string sourceFilePath;
+			if (m_textureStore.Claim(textureCopyParams.contentHash, textureFilePath, sourceFilePath))
+			{
+				m_textureStore.Complete(textureCopyParams.contentHash, textureDumpers[workerIndex].DumpTexture(textureCopyParams, textureFilePath));
+			}
+			else
+			{
+				// Same content means same palette count, so the source has a file for each palette too
+				const std::vector<std::string> sourcePaletteFilePaths = TextureDumper::GetPaletteFilePaths(textureCopyParams, sourceFilePath, textureExportOptions.textureFormat);
+				bool isLinked = true;
+				for (size_t paletteIndex = 0; paletteIndex < paletteFilePaths.size(); paletteIndex++)
+				{
+					isLinked &= TextureStore::CreateFileLink(sourcePaletteFilePaths[paletteIndex], paletteFilePaths[paletteIndex]);
+				}
+				if (isLinked)
+				{
+					textureSourceFilePaths[textureIndex] = sourceFilePath;
+					ExtractionStats::AddCounter(DDAStatsCounter::TEXTURES_DEDUPLICATED, 1);
+				}
+				else
+				{
+					std::cout << ("[ERROR] Cannot link " + textureFilePath + " to " + sourceFilePath + ", the texture is written again\n") << std::flush;
+
+					// The palettes already linked share the data of the source files, they must not be written in place
+					for (const std::string& paletteFilePath : paletteFilePaths)
+					{
+						std::error_code error;
+						std::filesystem::remove(paletteFilePath, error);
+					}
+					textureDumpers[workerIndex].DumpTexture(textureCopyParams, textureFilePath);
+				}
+			}
+		});
+
+	// The materials use the first palette of their texture
+	for (DDAMaterial& material : data.materials)
+	{
+		if (material.textureIndex < textureCount && !textureAlphaTypes[material.textureIndex].empty())
+		{
+			material.alphaType = textureAlphaTypes[material.textureIndex][0];
+		}
+	}
+
+	std::vector<std::string> outputPaths;
+	std::vector<std::string> outputSources;
+	std::vector<std::string> outputContentHashes;
+	std::vector<DDATextureAlpha> textureAlphas;
+	outputPaths.reserve(textureCount + 1);
+	outputSources.reserve(textureCount + 1);
+	outputContentHashes.reserve(textureCount + 1);
+	for (size_t textureIndex = 0; textureIndex < textureCount; textureIndex++)
+	{
+		if (!isTextureWritten(textureIndex))
+		{
+			continue;
+		}
+
+		const DDATextureCopyParams& textureCopyParams = data.textureCopyParamsList[textureIndex];
+		const std::vector<std::string> paletteFilePaths = TextureDumper::GetPaletteFilePaths(textureCopyParams, textureFilePaths[textureIndex], textureExportOptions.textureFormat);
+		const std::vector<std::string> sourcePaletteFilePaths = TextureDumper::GetPaletteFilePaths(textureCopyParams, textureSourceFilePaths[textureIndex], textureExportOptions.textureFormat);
+		const std::vector<DDAAlphaType>& alphaTypes = textureAlphaTypes[textureIndex];
+		for (size_t paletteIndex = 0; paletteIndex < paletteFilePaths.size(); paletteIndex++)
+		{
+			outputPaths.push_back(paletteFilePaths[paletteIndex].substr(finalExportFolder.size()));
+
+			// Raw files have all palettes in one file, the most transparent palette is used
+			const DDAAlphaType alphaType = paletteFilePaths.size() == 1 ? *std::max_element(alphaTypes.begin(), alphaTypes.end()) : alphaTypes[paletteIndex];
+			textureAlphas.push_back({ outputPaths.back(), alphaType });
+
+			// Sources are stored relative to the main export folder, like the export folders of the game files
+			const std::string sourceFilePath = textureSourceFilePaths[textureIndex].empty() ? "" : sourcePaletteFilePaths[paletteIndex];
+			const bool isInExportFolder = sourceFilePath.compare(0, exportFolder.size(), exportFolder) == 0;
+			outputSources.push_back(isInExportFolder ? sourceFilePath.substr(exportFolder.size()) : sourceFilePath);
+
+			// The other palette files are found from the first one (see TextureDumper::GetPaletteFilePaths)
+			outputContentHashes.push_back(paletteIndex == 0 ? ContentHash::ToString(textureCopyParams.contentHash) : "");
+		}
+
+		if (textureCopyParams.frameCount > 1)
+		{
+			outputPaths.push_back(FrameTableWriter::GetFilePath(textureFilePaths[textureIndex]).substr(finalExportFolder.size()));
+			outputSources.emplace_back();
+			outputContentHashes.emplace_back();
+		}
+	}
+
+	// Built after the dump, the atlases convert the textures again in their buffers
+	if (m_textureAtlas && !data.meshes.empty())
 	{
-		std::filesystem::create_directories(finalExportFolder);
+		const std::string atlasFolder = finalExportFolder + TEXTURE_ATLAS_FOLDER + "\\";
+		const std::string fileExtension = TextureDumper::GetFileExtension(m_textureExportOptions.textureFormat);
+		const size_t firstAtlasMaterial = data.materials.size();
+		const std::vector<DDATextureCopyParams> atlases = TextureAtlasBuilder::Build(data.meshes, data.materials, data.textureCopyParamsList, fileExtension, m_textureJobCount);
+		if (!atlases.empty())
+		{
+			std::filesystem::create_directories(atlasFolder);
+		}
+		for (size_t atlasIndex = 0; atlasIndex < atlases.size(); atlasIndex++)
+		{
+			const DDATextureCopyParams& atlas = atlases[atlasIndex];
+			const std::string atlasFilePath = atlasFolder + atlas.textureName + fileExtension;
+			textureDumpers[0].DumpTexture(atlas, atlasFilePath);
+			outputPaths.push_back(atlasFilePath.substr(finalExportFolder.size()));
+			outputSources.emplace_back();
+			textureAlphas.push_back({ outputPaths.back(), data.materials[firstAtlasMaterial + atlasIndex].alphaType });
+		}
 	}
 
-	const DDAExtractedData data = fileParser.LoadFile(filePath, gameFile, finalExportFolder);
-	if(!extractFolderExists)
+	if (textureUsageGraph.HasPackets())
 	{
-		for (const DDATextureCopyParams& textureCopyParams: data.textureCopyParamsList)
+		if (textureUsageGraph.Write(data, textureFilePaths, finalExportFolder))
+		{
+			outputPaths.push_back(TEXTURE_USAGE_FILE_NAME);
+			outputSources.emplace_back();
+		}
+		else
 		{
-			textureDumper.DumpTexture(textureCopyParams, finalExportFolder);
+			std::cout << ("[ERROR] Cannot write " + finalExportFolder + TEXTURE_USAGE_FILE_NAME + "\n") << std::flush;
 		}
 	}
+
+	if (!textureAlphas.empty())
+	{
+		if (TextureAlphaWriter::Write(textureAlphas, finalExportFolder + TEXTURE_ALPHA_FILE_NAME))
+		{
+			outputPaths.push_back(TEXTURE_ALPHA_FILE_NAME);
+			outputSources.emplace_back();
+		}
+		else
+		{
+			std::cout << ("[ERROR] Cannot write " + finalExportFolder + TEXTURE_ALPHA_FILE_NAME + "\n") << std::flush;
+		}
+	}
+
 	if (!data.meshes.empty())
 	{
-		CreateFXBMesh(data.meshes, data.textureTables, finalExportFolder);
+		// The materials use the names chosen for the files, the atlas materials already have theirs
+		const bool meshesHaveTextures = CanMeshesLoadTextures(m_meshFormat, m_textureExportOptions.textureFormat);
+		for (DDAMaterial& material : data.materials)
+		{
+			if (!meshesHaveTextures)
+			{
+				material.textureFileName.clear();
+			}
+			else if (material.textureIndex < textureCount)
+			{
+				material.textureFileName = isTextureWritten(material.textureIndex) ? textureFilePaths[material.textureIndex].substr(finalExportFolder.size()) : "";
+			}
+		}
+
+		if (m_meshFormat == DDAMeshFormat::GLB)
+		{
+			GlbExporter::Export(data.meshes, data.materials, finalExportFolder + "output.glb");
+			outputPaths.push_back("output.glb");
+		}
+		else
+		{
+			CreateFXBMesh(data.meshes, data.materials, finalExportFolder);
+			outputPaths.push_back("output.fbx");
+		}
+		outputSources.emplace_back();
+	}
+
+	// Delete the files of the previous extraction that are not created anymore (renamed textures for example)
+	if (hasPreviousManifest)
+	{
+		for (const DDAManifestOutput& previousOutput : previousManifest.outputs)
+		{
+			if (std::find(outputPaths.begin(), outputPaths.end(), previousOutput.path) == outputPaths.end())
+			{
+				std::error_code error;
+				std::filesystem::remove(finalExportFolder + previousOutput.path, error);
+			}
+		}
+	}
+
+	// Only the textures have a content hash, the atlases and the other files are added after them
+	outputContentHashes.resize(outputPaths.size());
+
+	// Without all outputs, no manifest is written so the file is extracted again on the next run
+	for (size_t outputIndex = 0; outputIndex < outputPaths.size(); outputIndex++)
+	{
+		const std::string& outputPath = outputPaths[outputIndex];
+		std::error_code error;
+		const uintmax_t fileSize = std::filesystem::file_size(finalExportFolder + outputPath, error);
+		if (error)
+		{
+			std::cout << ("[ERROR] File not created: " + finalExportFolder + outputPath + "\n") << std::flush;
+			return;
+		}
+		currentManifest.outputs.push_back({ outputPath, fileSize, outputSources[outputIndex], outputContentHashes[outputIndex] });
+	}
+
+	if (!currentManifest.Save(finalExportFolder))
+	{
+		std::cout << ("[ERROR] Manifest not created: " + finalExportFolder + MANIFEST_FILE_NAME + "\n") << std::flush;
 	}
 }
\ No newline at end of file
@@ -10,6 +10,15 @@
 #include <memory>
 
 #include "dda_structures.h"
+#include "texture_dumper.h"
+#include "texture_store.h"
+
+// Format of the file containing the meshes of a game file
+enum class DDAMeshFormat
+{
+	FBX, // output.fbx, written by Assimp
+	GLB, // output.glb, written by GlbExporter, faster
+};
 
 class DDAManager
 {
@@ -21,11 +30,70 @@ public:
 	/**
 	* @brief Extracts data from the specified game file and saves it to the export folder.
 	* @brief Extracts meshes and textures.
+	* @brief Can be called from multiple threads at the same time with different game files.
+	* @brief Skipped if the manifest of the export folder says the input and the extractor did not change.
 	*/
 	void ExtractData(DDAGameFile gameFile, const std::string& exportFolder);
 
+	/**
+	* @brief Set the number of threads used to dump the textures of one file (0 = one per CPU thread)
+	*/
+	void SetTextureJobCount(size_t textureJobCount) { m_textureJobCount = textureJobCount; }
+
+	/**
+	* @brief Extract files even if their manifest says the previous extraction is up to date
+	*/
+	void SetForceExtraction(bool forceExtraction) { m_forceExtraction = forceExtraction; }
+
+	void SetMeshFormat(DDAMeshFormat meshFormat) { m_meshFormat = meshFormat; }
+
+	void SetTextureExportOptions(const DDATextureExportOptions& textureExportOptions)
+	{
+		m_textureExportOptions = textureExportOptions;
+		m_textureStore.Clear();
+	}
+
+	/**
+	* @brief Write each texture content once, textures already written for another game file are hardlinked (or copied)
+	*/
+	void SetTextureDeduplication(bool textureDeduplication) { m_textureDeduplication = textureDeduplication; }
+
+	/**
+	* @brief Pack the textures of the meshes in atlases, the meshes use the atlases instead of one material per texture (see TextureAtlasBuilder)
+	*/
+	void SetTextureAtlas(bool textureAtlas) { m_textureAtlas = textureAtlas; }
+
+	/**
+	* @brief Only write the textures used by the mesh packets of the maps and cars (see TextureUsageGraph), the other files write all their textures
+	* @brief The skybox textures are not used by the mesh packets, they are skipped too
+	*/
+	void SetUsedTexturesOnly(bool usedTexturesOnly) { m_usedTexturesOnly = usedTexturesOnly; }
+
+	/**
+	* @brief Export the meshes in an "output.fbx" file with their materials (see DDAExtractedData::materials)
+	*/
+	void CreateFXBMesh(const std::vector<DDAMesh>& meshes, const std::vector<DDAMaterial>& materials, const std::string& exportFolder);
+
+	/**
+	* @brief Check if the importers of a mesh format can load the texture files, the meshes are exported without textures otherwise
+	* @brief gltf only has png images without extensions, the fbx importers (Blender, Unity...) also load dds files
+	*/
+	static bool CanMeshesLoadTextures(DDAMeshFormat meshFormat, DDATextureFormat textureFormat);
+
 private:
-	void CreateFXBMesh(const std::vector<DDAMesh>& meshes, const std::vector<DDATextureTable>& textureTableList, const std::string& exportFolder);
+	/**
+	* @brief Get the options that change the created files, stored in the manifest
+	*/
+	std::string GetManifestSettings() const;
+
 	std::string m_gameFolderPath;
+	size_t m_textureJobCount = 1;
+	bool m_forceExtraction = false;
+	DDAMeshFormat m_meshFormat = DDAMeshFormat::FBX;
+	DDATextureExportOptions m_textureExportOptions;
+	bool m_textureDeduplication = true;
+	bool m_textureAtlas = false;
+	bool m_usedTexturesOnly = false;
+	TextureStore m_textureStore;
 };
 
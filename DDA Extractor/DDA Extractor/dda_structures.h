@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
 #include <memory>
 #include <vector>
@@ -201,6 +202,14 @@ enum class DDAClutType : uint32_t
 	CLUT_16 = 20, // 16 colors
 };
 
+// How a texture uses its alpha, from the least to the most transparent
+enum class DDAAlphaType
+{
+	ALPHA_OPAQUE, // All colors are opaque
+	ALPHA_CUTOUT, // Colors are opaque or fully transparent
+	ALPHA_BLEND, // Some colors are partially transparent
+};
+
 enum class DDAClutFixType : uint32_t
 {
 	CLUT_NORMAL = 0, // 256 colors
@@ -288,11 +297,17 @@ struct DDATextureCopyParams
 	size_t exportHeight = 0;
 	size_t xOffset = 0;
 	size_t yOffset = 0;
+	// Levels under the first level, from left to right, each level is half the size of the previous one
+	size_t mipmapCount = 1;
+	// Frames of an animated texture, stacked from top to bottom in the export size, see FrameTableWriter
+	size_t frameCount = 1;
 	DDAClutType clutType = DDAClutType::CLUT_256;
-	uint8_t* inputTextureData = nullptr;
-	std::unique_ptr<uint8_t[]> outputTextureData;
-	std::unique_ptr<uint8_t[]> palette;
+	const uint8_t* inputTextureData = nullptr; // Palette indices, or RGBA pixels with CLUT_NONE, read from the game file when the texture is dumped
+	std::unique_ptr<uint8_t[]> ownedTextureData; // Pixels of the textures made by the extractor (atlases), inputTextureData points to them
+	std::shared_ptr<uint8_t[]> palette; // Shared by the textures using the same palette
+	std::vector<std::shared_ptr<uint8_t[]>> alternatePalettes; // Other palettes of the texture (clutCount > 1), each one is exported with the same indices
 	std::string textureName;
+	uint64_t contentHash = 0; // Hash of the size, the pixels and the palette, same textures of different files have the same hash
 };
 
 struct DDASubMesh
@@ -326,12 +341,22 @@ public:
 	DDAVertexDescriptor vertexDescriptor;
 };
 
+// Material of the exported meshes, DDASubMesh::materialIndex is an index in DDAExtractedData::materials
+struct DDAMaterial
+{
+	std::string name;
+	std::string textureFileName; // Base color texture, relative to the mesh file, set once the file names are chosen (empty if the mesh format cannot load the texture format)
+	size_t textureIndex = SIZE_MAX; // Texture in DDAExtractedData::textureCopyParamsList, SIZE_MAX if the texture is not one of them (atlas)
+	DDAAlphaType alphaType = DDAAlphaType::ALPHA_OPAQUE; // Set when the texture is dumped, see TextureDumper::GetAlphaType
+};
+
 struct DDAExtractedData
 {
 	std::vector<DDATextureTable> textureTables;
 	std::vector<std::vector<DDATextureHeader>> textureHeaders; // Used for menu textures because there is no texture table
 	std::vector<DDAPacketAndTextureEntry> packetAndTextureEntryList;
 	std::vector<DDAMesh> meshes;
+	std::vector<DDAMaterial> materials; // One per texture of the texture tables, then the first frame materials of the animated textures repeated by the meshes
 
 	std::vector< DDATextureCopyParams> textureCopyParamsList;
 	size_t fileSize = 0;
@@ -397,6 +422,33 @@ const std::string filesNames[50] =
 	"FLASH\\DD4START\\DD4START.UBR", // 49
 };
 
+// Addresses of the texture header lists in the menu files
+struct DDAMenuTextureListAddresses
+{
+	uint32_t directColorList = 0; // RGBA textures
+	uint32_t paletteList = 0; // Textures with a 256 colors palette
+};
+
+inline bool GetMenuTextureListAddresses(DDAGameFile gameFile, DDAMenuTextureListAddresses& addresses)
+{
+	if (gameFile == DDAGameFile::DD4FRONT)
+	{
+		addresses = { 0x003BCFD0, 0x0055D7C0 };
+		return true;
+	}
+	if (gameFile == DDAGameFile::DD4GAME)
+	{
+		addresses = { 0x0008D9F0, 0x0017D3C0 };
+		return true;
+	}
+	if (gameFile == DDAGameFile::DD4START)
+	{
+		addresses = { 0x0009F890, 0x002222E0 };
+		return true;
+	}
+	return false;
+}
+
 inline uint32_t GetHeaderOffset(DDAGameFileType fileType)
 {
 	if (fileType == DDAGameFileType::SPRITES)
@@ -0,0 +1,776 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "deflate_encoder.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <queue>
+
+namespace
+{
+	constexpr size_t WINDOW_SIZE = 32768;
+	constexpr size_t WINDOW_MASK = WINDOW_SIZE - 1;
+	constexpr size_t MIN_MATCH = 3;
+	constexpr size_t MAX_MATCH = 258;
+	constexpr int HASH_BITS = 15;
+	constexpr int MAX_CHAIN_LENGTH = 1024;
+	constexpr size_t MAX_STORED_BLOCK_SIZE = 65535;
+	constexpr size_t MAX_BLOCK_SYMBOLS = 1 << 16;
+
+	constexpr int LITERAL_LENGTH_CODE_COUNT = 286;
+	constexpr int FIXED_LITERAL_LENGTH_CODE_COUNT = 288;
+	constexpr int DISTANCE_CODE_COUNT = 30;
+	constexpr int CODE_LENGTH_CODE_COUNT = 19;
+	constexpr int END_OF_BLOCK = 256;
+	constexpr int MAX_CODE_LENGTH = 15;
+	constexpr int MAX_CODE_LENGTH_CODE_LENGTH = 7;
+
+	constexpr uint32_t BLOCK_TYPE_STORED = 0;
+	constexpr uint32_t BLOCK_TYPE_FIXED = 1;
+	constexpr uint32_t BLOCK_TYPE_DYNAMIC = 2;
+
+	const uint16_t lengthBases[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const uint8_t lengthExtraBits[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const uint16_t distanceBases[DISTANCE_CODE_COUNT] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const uint8_t distanceExtraBits[DISTANCE_CODE_COUNT] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+	const uint8_t codeLengthOrder[CODE_LENGTH_CODE_COUNT] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	// A literal (distance = 0) or a match
+	struct DDADeflateSymbol
+	{
+		uint16_t literalOrLength = 0;
+		uint16_t distance = 0;
+	};
+
+	struct DDAHuffmanCode
+	{
+		uint8_t lengths[FIXED_LITERAL_LENGTH_CODE_COUNT] = {};
+		uint16_t codes[FIXED_LITERAL_LENGTH_CODE_COUNT] = {}; // Bits are reversed, deflate writes Huffman codes from the most significant bit
+	};
+
+	/**
+	* @brief Find the length and distance codes without searching in the bases
+	*/
+	struct CodeTables
+	{
+		uint8_t lengthCodes[MAX_MATCH + 1] = {};
+		uint8_t distanceCodes[512] = {}; // See GetDistanceCode
+		DDAHuffmanCode fixedLiteralLengthCode;
+		DDAHuffmanCode fixedDistanceCode;
+
+		CodeTables();
+	};
+
+	void BuildCanonicalCodes(DDAHuffmanCode& huffmanCode, int symbolCount);
+
+	CodeTables::CodeTables()
+	{
+		for (int code = 0; code < 29; code++)
+		{
+			// 258 is in the range of the code 27 but it has its own code, set after
+			for (int length = lengthBases[code]; length < lengthBases[code] + (1 << lengthExtraBits[code]) && length <= (int)MAX_MATCH; length++)
+			{
+				lengthCodes[length] = static_cast<uint8_t>(code);
+			}
+		}
+
+		for (int code = 0; code < DISTANCE_CODE_COUNT; code++)
+		{
+			for (int distance = distanceBases[code]; distance < distanceBases[code] + (1 << distanceExtraBits[code]); distance++)
+			{
+				const int index = distance - 1 < 256 ? distance - 1 : 256 + ((distance - 1) >> 7);
+				distanceCodes[index] = static_cast<uint8_t>(code);
+			}
+		}
+
+		for (int symbol = 0; symbol < FIXED_LITERAL_LENGTH_CODE_COUNT; symbol++)
+		{
+			fixedLiteralLengthCode.lengths[symbol] = symbol < 144 ? 8 : (symbol < 256 ? 9 : (symbol < 280 ? 7 : 8));
+		}
+		BuildCanonicalCodes(fixedLiteralLengthCode, FIXED_LITERAL_LENGTH_CODE_COUNT);
+
+		for (int symbol = 0; symbol < DISTANCE_CODE_COUNT; symbol++)
+		{
+			fixedDistanceCode.lengths[symbol] = 5;
+		}
+		BuildCanonicalCodes(fixedDistanceCode, DISTANCE_CODE_COUNT);
+	}
+
+	const CodeTables& GetCodeTables()
+	{
+		static const CodeTables codeTables;
+		return codeTables;
+	}
+
+	int GetDistanceCode(const CodeTables& codeTables, uint32_t distance)
+	{
+		return codeTables.distanceCodes[distance - 1 < 256 ? distance - 1 : 256 + ((distance - 1) >> 7)];
+	}
+
+	class BitWriter
+	{
+	public:
+		explicit BitWriter(std::vector<uint8_t>& output)
+			: m_output(output) {
+		}
+
+		void Write(uint32_t bits, int bitCount)
+		{
+			m_bits |= static_cast<uint64_t>(bits) << m_bitCount;
+			m_bitCount += bitCount;
+			while (m_bitCount >= 8)
+			{
+				m_output.push_back(static_cast<uint8_t>(m_bits));
+				m_bits >>= 8;
+				m_bitCount -= 8;
+			}
+		}
+
+		void AlignToByte()
+		{
+			if (m_bitCount > 0)
+			{
+				m_output.push_back(static_cast<uint8_t>(m_bits));
+				m_bits = 0;
+				m_bitCount = 0;
+			}
+		}
+
+		/**
+		* @brief Add bytes after AlignToByte
+		*/
+		void WriteBytes(const uint8_t* data, size_t size)
+		{
+			m_output.insert(m_output.end(), data, data + size);
+		}
+
+	private:
+		std::vector<uint8_t>& m_output;
+		uint64_t m_bits = 0;
+		int m_bitCount = 0;
+	};
+
+	void BuildCanonicalCodes(DDAHuffmanCode& huffmanCode, int symbolCount)
+	{
+		int lengthCounts[MAX_CODE_LENGTH + 1] = {};
+		for (int symbol = 0; symbol < symbolCount; symbol++)
+		{
+			lengthCounts[huffmanCode.lengths[symbol]]++;
+		}
+		lengthCounts[0] = 0;
+
+		int nextCodes[MAX_CODE_LENGTH + 1] = {};
+		int code = 0;
+		for (int length = 1; length <= MAX_CODE_LENGTH; length++)
+		{
+			code = (code + lengthCounts[length - 1]) << 1;
+			nextCodes[length] = code;
+		}
+
+		for (int symbol = 0; symbol < symbolCount; symbol++)
+		{
+			const int length = huffmanCode.lengths[symbol];
+			if (length == 0)
+			{
+				continue;
+			}
+
+			const int symbolCode = nextCodes[length]++;
+			uint16_t reversedCode = 0;
+			for (int bit = 0; bit < length; bit++)
+			{
+				reversedCode |= ((symbolCode >> bit) & 1) << (length - 1 - bit);
+			}
+			huffmanCode.codes[symbol] = reversedCode;
+		}
+	}
+
+	/**
+	* @brief Compute the code length of each symbol from their frequencies
+	* @brief Frequencies are divided by 2 until no code is longer than maxLength, the codes are a bit less efficient but it's rare
+	*/
+	void BuildCodeLengths(const uint32_t* frequencies, int symbolCount, int maxLength, uint8_t* lengths)
+	{
+		std::vector<uint32_t> scaledFrequencies(frequencies, frequencies + symbolCount);
+
+		// Make sure there are at least 2 codes, a code with 1 symbol is not complete and some decoders refuse it
+		int usedSymbolCount = 0;
+		for (int symbol = 0; symbol < symbolCount; symbol++)
+		{
+			usedSymbolCount += scaledFrequencies[symbol] != 0 ? 1 : 0;
+		}
+		for (int symbol = 0; symbol < symbolCount && usedSymbolCount < 2; symbol++)
+		{
+			if (scaledFrequencies[symbol] == 0)
+			{
+				scaledFrequencies[symbol] = 1;
+				usedSymbolCount++;
+			}
+		}
+
+		std::vector<uint64_t> weights;
+		std::vector<int> parents;
+		while (true)
+		{
+			// Nodes 0 to symbolCount - 1 are the symbols, the next ones are the merged nodes
+			weights.assign(scaledFrequencies.begin(), scaledFrequencies.end());
+			parents.assign(symbolCount, -1);
+
+			using Node = std::pair<uint64_t, int>;
+			std::priority_queue<Node, std::vector<Node>, std::greater<Node>> queue;
+			for (int symbol = 0; symbol < symbolCount; symbol++)
+			{
+				if (scaledFrequencies[symbol] != 0)
+				{
+					queue.push({ scaledFrequencies[symbol], symbol });
+				}
+			}
+
+			while (queue.size() > 1)
+			{
+				const Node first = queue.top();
+				queue.pop();
+				const Node second = queue.top();
+				queue.pop();
+
+				const int mergedNode = static_cast<int>(weights.size());
+				weights.push_back(first.first + second.first);
+				parents.push_back(-1);
+				parents[first.second] = mergedNode;
+				parents[second.second] = mergedNode;
+				queue.push({ first.first + second.first, mergedNode });
+			}
+
+			// Merged nodes are created after their children, so the depths are computed from the root
+			std::vector<int> depths(weights.size(), 0);
+			for (int node = static_cast<int>(weights.size()) - 1; node >= 0; node--)
+			{
+				if (parents[node] >= 0)
+				{
+					depths[node] = depths[parents[node]] + 1;
+				}
+			}
+
+			int longestLength = 0;
+			for (int symbol = 0; symbol < symbolCount; symbol++)
+			{
+				lengths[symbol] = scaledFrequencies[symbol] != 0 ? static_cast<uint8_t>(depths[symbol]) : 0;
+				longestLength = std::max<int>(longestLength, lengths[symbol]);
+			}
+
+			if (longestLength <= maxLength)
+			{
+				return;
+			}
+
+			for (uint32_t& frequency : scaledFrequencies)
+			{
+				if (frequency != 0)
+				{
+					frequency = (frequency + 1) / 2;
+				}
+			}
+		}
+	}
+
+	// Code lengths of the dynamic block header, compressed with the repeat codes 16, 17 and 18
+	struct DDACodeLengthSymbol
+	{
+		uint8_t symbol = 0;
+		uint8_t extraValue = 0;
+	};
+
+	void AddCodeLengthSymbols(const uint8_t* lengths, int lengthCount, std::vector<DDACodeLengthSymbol>& symbols)
+	{
+		int i = 0;
+		while (i < lengthCount)
+		{
+			const uint8_t length = lengths[i];
+			int runLength = 1;
+			while (i + runLength < lengthCount && lengths[i + runLength] == length)
+			{
+				runLength++;
+			}
+
+			if (length == 0 && runLength >= 3)
+			{
+				const int count = std::min(runLength, 138);
+				if (count >= 11)
+				{
+					symbols.push_back({ 18, static_cast<uint8_t>(count - 11) });
+				}
+				else
+				{
+					symbols.push_back({ 17, static_cast<uint8_t>(count - 3) });
+				}
+				i += count;
+			}
+			else if (length != 0 && runLength >= 4)
+			{
+				// The length is written once, then repeated 3 to 6 times
+				symbols.push_back({ length, 0 });
+				const int count = std::min(runLength - 1, 6);
+				symbols.push_back({ 16, static_cast<uint8_t>(count - 3) });
+				i += 1 + count;
+			}
+			else
+			{
+				symbols.push_back({ length, 0 });
+				i++;
+			}
+		}
+	}
+
+	int GetCodeLengthExtraBits(uint8_t symbol)
+	{
+		return symbol == 16 ? 2 : (symbol == 17 ? 3 : (symbol == 18 ? 7 : 0));
+	}
+
+	/**
+	* @brief Size in bits of the symbols written with the codes
+	*/
+	uint64_t GetSymbolsBitCount(const uint32_t* literalLengthFrequencies, const uint32_t* distanceFrequencies, const DDAHuffmanCode& literalLengthCode, const DDAHuffmanCode& distanceCode)
+	{
+		uint64_t bitCount = 0;
+		for (int symbol = 0; symbol < LITERAL_LENGTH_CODE_COUNT; symbol++)
+		{
+			const int extraBits = symbol > END_OF_BLOCK ? lengthExtraBits[symbol - END_OF_BLOCK - 1] : 0;
+			bitCount += static_cast<uint64_t>(literalLengthFrequencies[symbol]) * (literalLengthCode.lengths[symbol] + extraBits);
+		}
+		for (int symbol = 0; symbol < DISTANCE_CODE_COUNT; symbol++)
+		{
+			bitCount += static_cast<uint64_t>(distanceFrequencies[symbol]) * (distanceCode.lengths[symbol] + distanceExtraBits[symbol]);
+		}
+		return bitCount;
+	}
+
+	void WriteSymbols(BitWriter& writer, const DDADeflateSymbol* symbols, size_t symbolCount, const DDAHuffmanCode& literalLengthCode, const DDAHuffmanCode& distanceCode)
+	{
+		const CodeTables& codeTables = GetCodeTables();
+		for (size_t i = 0; i < symbolCount; i++)
+		{
+			const DDADeflateSymbol& symbol = symbols[i];
+			if (symbol.distance == 0)
+			{
+				writer.Write(literalLengthCode.codes[symbol.literalOrLength], literalLengthCode.lengths[symbol.literalOrLength]);
+				continue;
+			}
+
+			const int lengthCode = codeTables.lengthCodes[symbol.literalOrLength];
+			writer.Write(literalLengthCode.codes[END_OF_BLOCK + 1 + lengthCode], literalLengthCode.lengths[END_OF_BLOCK + 1 + lengthCode]);
+			if (lengthExtraBits[lengthCode] != 0)
+			{
+				writer.Write(symbol.literalOrLength - lengthBases[lengthCode], lengthExtraBits[lengthCode]);
+			}
+
+			const int distanceCodeIndex = GetDistanceCode(codeTables, symbol.distance);
+			writer.Write(distanceCode.codes[distanceCodeIndex], distanceCode.lengths[distanceCodeIndex]);
+			if (distanceExtraBits[distanceCodeIndex] != 0)
+			{
+				writer.Write(symbol.distance - distanceBases[distanceCodeIndex], distanceExtraBits[distanceCodeIndex]);
+			}
+		}
+		writer.Write(literalLengthCode.codes[END_OF_BLOCK], literalLengthCode.lengths[END_OF_BLOCK]);
+	}
+
+	void WriteStoredBlocks(BitWriter& writer, const uint8_t* data, size_t size, bool isFinal)
+	{
+		size_t offset = 0;
+		do
+		{
+			const size_t blockSize = std::min(size - offset, MAX_STORED_BLOCK_SIZE);
+			const bool isLastBlock = offset + blockSize == size;
+			writer.Write(isFinal && isLastBlock ? 1 : 0, 1);
+			writer.Write(BLOCK_TYPE_STORED, 2);
+			writer.AlignToByte();
+
+			const uint8_t sizes[4] =
+			{
+				static_cast<uint8_t>(blockSize), static_cast<uint8_t>(blockSize >> 8),
+				static_cast<uint8_t>(~blockSize), static_cast<uint8_t>(~blockSize >> 8),
+			};
+			writer.WriteBytes(sizes, sizeof(sizes));
+			writer.WriteBytes(data + offset, blockSize);
+			offset += blockSize;
+		} while (offset < size);
+	}
+
+	/**
+	* @brief Write a block with the smallest type: stored, fixed Huffman codes or dynamic Huffman codes
+	* @param data The bytes represented by the symbols
+	*/
+	void WriteBlock(BitWriter& writer, const std::vector<DDADeflateSymbol>& symbols, const uint8_t* data, size_t size, bool isFinal)
+	{
+		const CodeTables& codeTables = GetCodeTables();
+
+		uint32_t literalLengthFrequencies[LITERAL_LENGTH_CODE_COUNT] = {};
+		uint32_t distanceFrequencies[DISTANCE_CODE_COUNT] = {};
+		for (const DDADeflateSymbol& symbol : symbols)
+		{
+			if (symbol.distance == 0)
+			{
+				literalLengthFrequencies[symbol.literalOrLength]++;
+			}
+			else
+			{
+				literalLengthFrequencies[END_OF_BLOCK + 1 + codeTables.lengthCodes[symbol.literalOrLength]]++;
+				distanceFrequencies[GetDistanceCode(codeTables, symbol.distance)]++;
+			}
+		}
+		literalLengthFrequencies[END_OF_BLOCK]++;
+
+		DDAHuffmanCode literalLengthCode;
+		DDAHuffmanCode distanceCode;
+		BuildCodeLengths(literalLengthFrequencies, LITERAL_LENGTH_CODE_COUNT, MAX_CODE_LENGTH, literalLengthCode.lengths);
+		BuildCodeLengths(distanceFrequencies, DISTANCE_CODE_COUNT, MAX_CODE_LENGTH, distanceCode.lengths);
+		BuildCanonicalCodes(literalLengthCode, LITERAL_LENGTH_CODE_COUNT);
+		BuildCanonicalCodes(distanceCode, DISTANCE_CODE_COUNT);
+
+		// Header of the dynamic block: the code lengths of both codes, compressed with a third code
+		int literalLengthCount = LITERAL_LENGTH_CODE_COUNT;
+		while (literalLengthCount > 257 && literalLengthCode.lengths[literalLengthCount - 1] == 0)
+		{
+			literalLengthCount--;
+		}
+		int distanceCount = DISTANCE_CODE_COUNT;
+		while (distanceCount > 1 && distanceCode.lengths[distanceCount - 1] == 0)
+		{
+			distanceCount--;
+		}
+
+		uint8_t allLengths[LITERAL_LENGTH_CODE_COUNT + DISTANCE_CODE_COUNT];
+		memcpy(allLengths, literalLengthCode.lengths, literalLengthCount);
+		memcpy(allLengths + literalLengthCount, distanceCode.lengths, distanceCount);
+		std::vector<DDACodeLengthSymbol> codeLengthSymbols;
+		AddCodeLengthSymbols(allLengths, literalLengthCount + distanceCount, codeLengthSymbols);
+
+		uint32_t codeLengthFrequencies[CODE_LENGTH_CODE_COUNT] = {};
+		for (const DDACodeLengthSymbol& codeLengthSymbol : codeLengthSymbols)
+		{
+			codeLengthFrequencies[codeLengthSymbol.symbol]++;
+		}
+		DDAHuffmanCode codeLengthCode;
+		BuildCodeLengths(codeLengthFrequencies, CODE_LENGTH_CODE_COUNT, MAX_CODE_LENGTH_CODE_LENGTH, codeLengthCode.lengths);
+		BuildCanonicalCodes(codeLengthCode, CODE_LENGTH_CODE_COUNT);
+
+		int codeLengthCount = CODE_LENGTH_CODE_COUNT;
+		while (codeLengthCount > 4 && codeLengthCode.lengths[codeLengthOrder[codeLengthCount - 1]] == 0)
+		{
+			codeLengthCount--;
+		}
+
+		// Compare the size of each block type
+		uint64_t dynamicBitCount = 3 + 5 + 5 + 4 + 3 * codeLengthCount;
+		for (const DDACodeLengthSymbol& codeLengthSymbol : codeLengthSymbols)
+		{
+			dynamicBitCount += codeLengthCode.lengths[codeLengthSymbol.symbol] + GetCodeLengthExtraBits(codeLengthSymbol.symbol);
+		}
+		dynamicBitCount += GetSymbolsBitCount(literalLengthFrequencies, distanceFrequencies, literalLengthCode, distanceCode);
+
+		const uint64_t fixedBitCount = 3 + GetSymbolsBitCount(literalLengthFrequencies, distanceFrequencies, codeTables.fixedLiteralLengthCode, codeTables.fixedDistanceCode);
+
+		const uint64_t storedBlockCount = std::max<uint64_t>((size + MAX_STORED_BLOCK_SIZE - 1) / MAX_STORED_BLOCK_SIZE, 1);
+		const uint64_t storedBitCount = storedBlockCount * (3 + 7 + 32) + static_cast<uint64_t>(size) * 8;
+
+		if (storedBitCount <= fixedBitCount && storedBitCount <= dynamicBitCount)
+		{
+			WriteStoredBlocks(writer, data, size, isFinal);
+		}
+		else if (fixedBitCount <= dynamicBitCount)
+		{
+			writer.Write(isFinal ? 1 : 0, 1);
+			writer.Write(BLOCK_TYPE_FIXED, 2);
+			WriteSymbols(writer, symbols.data(), symbols.size(), codeTables.fixedLiteralLengthCode, codeTables.fixedDistanceCode);
+		}
+		else
+		{
+			writer.Write(isFinal ? 1 : 0, 1);
+			writer.Write(BLOCK_TYPE_DYNAMIC, 2);
+			writer.Write(literalLengthCount - 257, 5);
+			writer.Write(distanceCount - 1, 5);
+			writer.Write(codeLengthCount - 4, 4);
+			for (int i = 0; i < codeLengthCount; i++)
+			{
+				writer.Write(codeLengthCode.lengths[codeLengthOrder[i]], 3);
+			}
+			for (const DDACodeLengthSymbol& codeLengthSymbol : codeLengthSymbols)
+			{
+				writer.Write(codeLengthCode.codes[codeLengthSymbol.symbol], codeLengthCode.lengths[codeLengthSymbol.symbol]);
+				const int extraBits = GetCodeLengthExtraBits(codeLengthSymbol.symbol);
+				if (extraBits != 0)
+				{
+					writer.Write(codeLengthSymbol.extraValue, extraBits);
+				}
+			}
+			WriteSymbols(writer, symbols.data(), symbols.size(), literalLengthCode, distanceCode);
+		}
+	}
+
+	uint32_t Hash(const uint8_t* data)
+	{
+		const uint32_t value = data[0] | (data[1] << 8) | (data[2] << 16);
+		return (value * 0x9E3779B1u) >> (32 - HASH_BITS);
+	}
+
+	size_t GetMatchLength(const uint8_t* first, const uint8_t* second, size_t maxLength)
+	{
+		size_t length = 0;
+		while (length + 8 <= maxLength)
+		{
+			uint64_t firstValue;
+			uint64_t secondValue;
+			memcpy(&firstValue, first + length, sizeof(firstValue));
+			memcpy(&secondValue, second + length, sizeof(secondValue));
+			if (firstValue != secondValue)
+			{
+				break;
+			}
+			length += 8;
+		}
+		while (length < maxLength && first[length] == second[length])
+		{
+			length++;
+		}
+		return length;
+	}
+
+	/**
+	* @brief Cut the data in symbols and write the blocks, a block is written each time the symbol list is full
+	*/
+	class BlockBuilder
+	{
+	public:
+		BlockBuilder(BitWriter& writer, const uint8_t* data)
+			: m_writer(writer), m_data(data) {
+			m_symbols.reserve(MAX_BLOCK_SYMBOLS);
+		}
+
+		void AddLiteral()
+		{
+			m_symbols.push_back({ m_data[m_blockEnd], 0 });
+			m_blockEnd++;
+			FlushIfFull();
+		}
+
+		void AddMatch(size_t length, size_t distance)
+		{
+			m_symbols.push_back({ static_cast<uint16_t>(length), static_cast<uint16_t>(distance) });
+			m_blockEnd += length;
+			FlushIfFull();
+		}
+
+		void Flush(bool isFinal)
+		{
+			WriteBlock(m_writer, m_symbols, m_data + m_blockStart, m_blockEnd - m_blockStart, isFinal);
+			m_symbols.clear();
+			m_blockStart = m_blockEnd;
+		}
+
+	private:
+		void FlushIfFull()
+		{
+			if (m_symbols.size() >= MAX_BLOCK_SYMBOLS)
+			{
+				Flush(false);
+			}
+		}
+
+		BitWriter& m_writer;
+		const uint8_t* m_data = nullptr;
+		std::vector<DDADeflateSymbol> m_symbols;
+		size_t m_blockStart = 0;
+		size_t m_blockEnd = 0;
+	};
+
+	/**
+	* @brief Use the last position with the same hash, without checking older positions
+	*/
+	void FindMatchesFast(const uint8_t* data, size_t size, BlockBuilder& blockBuilder)
+	{
+		std::vector<int64_t> head(static_cast<size_t>(1) << HASH_BITS, -1);
+		size_t position = 0;
+		while (position < size)
+		{
+			if (position + MIN_MATCH <= size)
+			{
+				const uint32_t hash = Hash(data + position);
+				const int64_t candidate = head[hash];
+				head[hash] = static_cast<int64_t>(position);
+				if (candidate >= 0 && position - candidate <= WINDOW_SIZE)
+				{
+					const size_t length = GetMatchLength(data + candidate, data + position, std::min(MAX_MATCH, size - position));
+					if (length >= MIN_MATCH)
+					{
+						blockBuilder.AddMatch(length, position - candidate);
+						position += length;
+						continue;
+					}
+				}
+			}
+
+			blockBuilder.AddLiteral();
+			position++;
+		}
+	}
+
+	/**
+	* @brief Check all positions with the same hash in the window, and delay a match by one byte if the next match is longer (lazy matching)
+	*/
+	void FindMatchesMax(const uint8_t* data, size_t size, BlockBuilder& blockBuilder)
+	{
+		std::vector<int64_t> head(static_cast<size_t>(1) << HASH_BITS, -1);
+		std::vector<int64_t> previous(WINDOW_SIZE, -1);
+
+		const auto insertPosition = [&](size_t position)
+			{
+				const uint32_t hash = Hash(data + position);
+				previous[position & WINDOW_MASK] = head[hash];
+				head[hash] = static_cast<int64_t>(position);
+			};
+
+		const auto findMatch = [&](size_t position, size_t& bestLength, size_t& bestDistance)
+			{
+				bestLength = 0;
+				bestDistance = 0;
+				const size_t maxLength = std::min(MAX_MATCH, size - position);
+				int64_t candidate = head[Hash(data + position)];
+				int chainLength = MAX_CHAIN_LENGTH;
+				while (candidate >= 0 && position - candidate <= WINDOW_SIZE && chainLength-- > 0)
+				{
+					// Quick check of the byte that would make the match longer than the best one
+					if (data[candidate + bestLength] == data[position + bestLength] || bestLength == 0)
+					{
+						const size_t length = GetMatchLength(data + candidate, data + position, maxLength);
+						if (length > bestLength)
+						{
+							bestLength = length;
+							bestDistance = position - candidate;
+							if (length == maxLength)
+							{
+								break;
+							}
+						}
+					}
+
+					const int64_t nextCandidate = previous[candidate & WINDOW_MASK];
+					if (nextCandidate >= candidate)
+					{
+						break;
+					}
+					candidate = nextCandidate;
+				}
+			};
+
+		bool hasPendingMatch = false;
+		size_t pendingLength = 0;
+		size_t pendingDistance = 0;
+		size_t position = 0;
+		while (position < size)
+		{
+			size_t length = 0;
+			size_t distance = 0;
+			if (position + MIN_MATCH <= size)
+			{
+				findMatch(position, length, distance);
+				insertPosition(position);
+			}
+
+			// The match of the previous position is kept if this one is not longer
+			if (hasPendingMatch && pendingLength >= MIN_MATCH && length <= pendingLength)
+			{
+				blockBuilder.AddMatch(pendingLength, pendingDistance);
+				const size_t matchEnd = position - 1 + pendingLength;
+				for (size_t matchPosition = position + 1; matchPosition < matchEnd; matchPosition++)
+				{
+					if (matchPosition + MIN_MATCH <= size)
+					{
+						insertPosition(matchPosition);
+					}
+				}
+				position = matchEnd;
+				hasPendingMatch = false;
+				continue;
+			}
+
+			if (hasPendingMatch)
+			{
+				blockBuilder.AddLiteral();
+			}
+			hasPendingMatch = true;
+			pendingLength = length;
+			pendingDistance = distance;
+			position++;
+		}
+
+		if (hasPendingMatch)
+		{
+			if (pendingLength >= MIN_MATCH)
+			{
+				blockBuilder.AddMatch(pendingLength, pendingDistance);
+			}
+			else
+			{
+				blockBuilder.AddLiteral();
+			}
+		}
+	}
+}
+
+void DeflateEncoder::CompressRaw(const uint8_t* data, size_t size, DDADeflateLevel level, bool isLastPart, std::vector<uint8_t>& output)
+{
+	BitWriter writer(output);
+
+	if (level == DDADeflateLevel::STORED)
+	{
+		WriteStoredBlocks(writer, data, size, isLastPart);
+	}
+	else
+	{
+		BlockBuilder blockBuilder(writer, data);
+		if (level == DDADeflateLevel::FAST)
+		{
+			FindMatchesFast(data, size, blockBuilder);
+		}
+		else
+		{
+			FindMatchesMax(data, size, blockBuilder);
+		}
+		blockBuilder.Flush(isLastPart);
+	}
+
+	// An empty stored block ends the part on a byte boundary (like a zlib sync flush)
+	if (!isLastPart && level != DDADeflateLevel::STORED)
+	{
+		WriteStoredBlocks(writer, nullptr, 0, false);
+	}
+	writer.AlignToByte();
+}
+
+uint32_t DeflateEncoder::Adler32(const uint8_t* data, size_t size)
+{
+	// Largest number of bytes before the sums need a modulo to stay in 32 bits
+	constexpr size_t MAX_BYTES_BEFORE_MODULO = 5552;
+	constexpr uint32_t ADLER_MODULO = 65521;
+
+	uint32_t first = 1;
+	uint32_t second = 0;
+	while (size > 0)
+	{
+		const size_t byteCount = std::min(size, MAX_BYTES_BEFORE_MODULO);
+		for (size_t i = 0; i < byteCount; i++)
+		{
+			first += data[i];
+			second += first;
+		}
+		first %= ADLER_MODULO;
+		second %= ADLER_MODULO;
+		data += byteCount;
+		size -= byteCount;
+	}
+	return (second << 16) | first;
+}
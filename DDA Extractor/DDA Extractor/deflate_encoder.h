@@ -0,0 +1,37 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+enum class DDADeflateLevel
+{
+	STORED, // No compression
+	FAST, // First match found and fixed Huffman codes
+	MAX, // Long match search and Huffman codes made for each block
+};
+
+/**
+* @brief Deflate compression (RFC 1951) used to write png files
+*/
+class DeflateEncoder
+{
+public:
+	/**
+	* @brief Compress data in deflate blocks, without the zlib header
+	* @param isLastPart False to end on a byte boundary without the final block, so the next part can be appended to the output
+	* @param output The compressed data is added at the end
+	*/
+	static void CompressRaw(const uint8_t* data, size_t size, DDADeflateLevel level, bool isLastPart, std::vector<uint8_t>& output);
+
+	/**
+	* @brief Checksum of the zlib format
+	*/
+	static uint32_t Adler32(const uint8_t* data, size_t size);
+};
@@ -0,0 +1,189 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "extraction_manifest.h"
+
+#include <filesystem>
+#include <fstream>
+
+#include "json_utils.h"
+
+namespace
+{
+	/**
+	* @brief Read the JSON string value of a key in a line like "key": "value"
+	* @return False if the key is not in the line
+	*/
+	bool ReadStringValue(const std::string& line, const std::string& key, std::string& value)
+	{
+		const std::string keyText = "\"" + key + "\": \"";
+		size_t position = line.find(keyText);
+		if (position == std::string::npos)
+		{
+			return false;
+		}
+
+		value.clear();
+		for (position += keyText.size(); position < line.size() && line[position] != '"'; position++)
+		{
+			if (line[position] == '\\' && position + 1 < line.size())
+			{
+				position++;
+				const char escapedCharacter = line[position];
+				if (escapedCharacter == 'n')
+				{
+					value += '\n';
+					continue;
+				}
+				else if (escapedCharacter == 'r')
+				{
+					value += '\r';
+					continue;
+				}
+				else if (escapedCharacter == 't')
+				{
+					value += '\t';
+					continue;
+				}
+				else if (escapedCharacter == 'u' && position + 4 < line.size())
+				{
+					value += static_cast<char>(std::stoi(line.substr(position + 1, 4), nullptr, 16));
+					position += 4;
+					continue;
+				}
+			}
+			value += line[position];
+		}
+		return true;
+	}
+
+	/**
+	* @brief Read the JSON number value of a key in a line like "key": 123
+	* @return False if the key is not in the line
+	*/
+	bool ReadNumberValue(const std::string& line, const std::string& key, uint64_t& value)
+	{
+		const std::string keyText = "\"" + key + "\": ";
+		const size_t position = line.find(keyText);
+		if (position == std::string::npos)
+		{
+			return false;
+		}
+
+		try
+		{
+			value = std::stoull(line.substr(position + keyText.size()));
+		}
+		catch (const std::exception&)
+		{
+			return false;
+		}
+		return true;
+	}
+}
+
+bool ExtractionManifest::Load(const std::string& exportFolder)
+{
+	*this = ExtractionManifest();
+
+	std::ifstream file(exportFolder + MANIFEST_FILE_NAME);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	// The manifest is written by Save with one value or one output per line
+	std::string line;
+	while (std::getline(file, line))
+	{
+		DDAManifestOutput output;
+		if (ReadStringValue(line, "path", output.path))
+		{
+			if (!ReadNumberValue(line, "size", output.size))
+			{
+				return false;
+			}
+			ReadStringValue(line, "source", output.source);
+			ReadStringValue(line, "content_hash", output.contentHash);
+			outputs.push_back(output);
+		}
+		else if (!ReadStringValue(line, "extractor_version", extractorVersion) &&
+			!ReadStringValue(line, "settings", settings) &&
+			!ReadStringValue(line, "input_file", inputFile) &&
+			!ReadStringValue(line, "input_hash", inputHash))
+		{
+			ReadNumberValue(line, "input_size", inputSize);
+		}
+	}
+
+	return !extractorVersion.empty() && !inputHash.empty();
+}
+
+bool ExtractionManifest::Save(const std::string& exportFolder) const
+{
+	std::ofstream file(exportFolder + MANIFEST_FILE_NAME, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file << "{\n";
+	file << "\t\"extractor_version\": \"" << JsonUtils::EscapeString(extractorVersion) << "\",\n";
+	file << "\t\"settings\": \"" << JsonUtils::EscapeString(settings) << "\",\n";
+	file << "\t\"input_file\": \"" << JsonUtils::EscapeString(inputFile) << "\",\n";
+	file << "\t\"input_size\": " << inputSize << ",\n";
+	file << "\t\"input_hash\": \"" << inputHash << "\",\n";
+	file << "\t\"outputs\": [";
+	for (size_t i = 0; i < outputs.size(); i++)
+	{
+		file << (i == 0 ? "\n" : ",\n");
+		file << "\t\t{ \"path\": \"" << JsonUtils::EscapeString(outputs[i].path) << "\", \"size\": " << outputs[i].size;
+		if (!outputs[i].source.empty())
+		{
+			file << ", \"source\": \"" << JsonUtils::EscapeString(outputs[i].source) << "\"";
+		}
+		if (!outputs[i].contentHash.empty())
+		{
+			file << ", \"content_hash\": \"" << outputs[i].contentHash << "\"";
+		}
+		file << " }";
+	}
+	file << "\n\t]\n";
+	file << "}\n";
+
+	return file.good();
+}
+
+void ExtractionManifest::Remove(const std::string& exportFolder)
+{
+	std::error_code error;
+	std::filesystem::remove(exportFolder + MANIFEST_FILE_NAME, error);
+}
+
+bool ExtractionManifest::IsUpToDate(const ExtractionManifest& currentManifest, const std::string& exportFolder) const
+{
+	if (extractorVersion != currentManifest.extractorVersion ||
+		settings != currentManifest.settings ||
+		inputFile != currentManifest.inputFile ||
+		inputSize != currentManifest.inputSize ||
+		inputHash != currentManifest.inputHash)
+	{
+		return false;
+	}
+
+	// A file may have been deleted or modified by the user
+	for (const DDAManifestOutput& output : outputs)
+	{
+		std::error_code error;
+		const uintmax_t fileSize = std::filesystem::file_size(exportFolder + output.path, error);
+		if (error || fileSize != output.size)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+// Change it when the extracted files change, so files extracted by an older version are extracted again
+constexpr const char* EXTRACTOR_VERSION = "9";
+
+constexpr const char* MANIFEST_FILE_NAME = "manifest.json";
+
+// A file created by the extraction
+struct DDAManifestOutput
+{
+	std::string path; // Relative to the export folder
+	uint64_t size = 0;
+	std::string source; // Same texture written for another game file, relative to the main export folder (the file is a hardlink or a copy of it), empty if written for this file
+	std::string contentHash; // DDATextureCopyParams::contentHash of the texture on its first palette file, so the next runs can link to it, empty for the other files
+};
+
+/**
+* @brief Describe the extraction of one game file: the input hash, the extractor version and the created files
+* @brief Stored in the export folder of the game file, it's written at the end of the extraction,
+* @brief so an interrupted extraction does not have a manifest and is done again
+*/
+class ExtractionManifest
+{
+public:
+	std::string extractorVersion;
+	std::string settings; // Extraction options that change the created files
+	std::string inputFile;
+	uint64_t inputSize = 0;
+	std::string inputHash;
+	std::vector<DDAManifestOutput> outputs;
+
+	/**
+	* @brief Load the manifest of an export folder
+	* @return False if there is no manifest or if it cannot be read
+	*/
+	bool Load(const std::string& exportFolder);
+
+	/**
+	* @brief Write the manifest in an export folder
+	*/
+	bool Save(const std::string& exportFolder) const;
+
+	/**
+	* @brief Delete the manifest of an export folder
+	*/
+	static void Remove(const std::string& exportFolder);
+
+	/**
+	* @brief Check if the extraction described by this manifest does not need to be done again
+	* @return True if the input, the version and the settings did not change and all outputs are still there
+	*/
+	bool IsUpToDate(const ExtractionManifest& currentManifest, const std::string& exportFolder) const;
+};
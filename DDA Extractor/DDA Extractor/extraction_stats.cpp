@@ -0,0 +1,212 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "extraction_stats.h"
+
+#include <atomic>
+#include <iterator>
+#include <sstream>
+
+#include "json_utils.h"
+
+namespace
+{
+	const char* phaseNames[(int)DDAStatsPhase::COUNT] =
+	{
+		"read",
+		"table_parse",
+		"packet_scan",
+		"mesh_generation",
+		"palette_fix",
+		"clut_decode",
+		"png_encode",
+		"texture_write",
+		"block_encode",
+		"texture_atlas",
+		"fbx_export",
+		"glb_export",
+	};
+
+	const char* counterNames[(int)DDAStatsCounter::COUNT] =
+	{
+		"packets_found",
+		"packets_aborted",
+		"triangles",
+		"textures",
+		"textures_deduplicated",
+		"bytes_written",
+	};
+
+	// Stats of one file, the textures of a file can be dumped by several threads
+	struct FileStats
+	{
+		std::atomic<bool> used{ false };
+		std::atomic<uint64_t> totalNanoseconds{ 0 };
+		std::atomic<uint64_t> phaseNanoseconds[(int)DDAStatsPhase::COUNT] = {};
+		std::atomic<uint64_t> counters[(int)DDAStatsCounter::COUNT] = {};
+	};
+
+	FileStats filesStats[std::size(filesNames)];
+
+	// File processed by the current thread, -1 if none
+	thread_local int currentFile = -1;
+	thread_local ExtractionStats::ScopedPhaseTimer* currentTimer = nullptr;
+
+	FileStats* GetCurrentFileStats()
+	{
+		if (currentFile < 0)
+		{
+			return nullptr;
+		}
+		return &filesStats[currentFile];
+	}
+
+	uint64_t ToNanoseconds(std::chrono::steady_clock::duration duration)
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+	}
+
+}
+
+ExtractionStats::FileScope::FileScope(DDAGameFile gameFile, bool measureTime)
+{
+	if (!s_enabled)
+	{
+		return;
+	}
+
+	m_previousFile = currentFile;
+	currentFile = (int)gameFile;
+	filesStats[currentFile].used = true;
+	m_measureTime = measureTime;
+	if (m_measureTime)
+	{
+		m_startTime = std::chrono::steady_clock::now();
+	}
+}
+
+ExtractionStats::FileScope::~FileScope()
+{
+	if (!s_enabled)
+	{
+		return;
+	}
+
+	if (m_measureTime)
+	{
+		filesStats[currentFile].totalNanoseconds += ToNanoseconds(std::chrono::steady_clock::now() - m_startTime);
+	}
+	currentFile = m_previousFile;
+}
+
+void ExtractionStats::ScopedPhaseTimer::Start(DDAStatsPhase phase)
+{
+	m_phase = phase;
+	m_started = true;
+	m_startTime = std::chrono::steady_clock::now();
+
+	// Pause the parent timer
+	m_parent = currentTimer;
+	if (m_parent)
+	{
+		AddPhaseTime(m_parent->m_phase, m_startTime - m_parent->m_startTime);
+	}
+	currentTimer = this;
+}
+
+void ExtractionStats::ScopedPhaseTimer::StopTimer()
+{
+	m_started = false;
+	const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+	AddPhaseTime(m_phase, endTime - m_startTime);
+
+	// Resume the parent timer
+	if (m_parent)
+	{
+		m_parent->m_startTime = endTime;
+	}
+	currentTimer = m_parent;
+}
+
+void ExtractionStats::AddCounterToCurrentFile(DDAStatsCounter counter, uint64_t value)
+{
+	FileStats* fileStats = GetCurrentFileStats();
+	if (fileStats)
+	{
+		fileStats->counters[(int)counter].fetch_add(value, std::memory_order_relaxed);
+	}
+}
+
+void ExtractionStats::AddPhaseTime(DDAStatsPhase phase, std::chrono::steady_clock::duration duration)
+{
+	FileStats* fileStats = GetCurrentFileStats();
+	if (fileStats)
+	{
+		fileStats->phaseNanoseconds[(int)phase].fetch_add(ToNanoseconds(duration), std::memory_order_relaxed);
+	}
+}
+
+std::string ExtractionStats::ToJson()
+{
+	uint64_t totalPhaseNanoseconds[(int)DDAStatsPhase::COUNT] = {};
+	uint64_t totalCounters[(int)DDAStatsCounter::COUNT] = {};
+
+	// Phase times are the sum of the time of all threads, it can be more than the total time of the file
+	std::ostringstream json;
+	json << "{\n";
+	json << "\t\"files\": [";
+	bool firstFile = true;
+	for (size_t fileIndex = 0; fileIndex < std::size(filesStats); fileIndex++)
+	{
+		const FileStats& fileStats = filesStats[fileIndex];
+		if (!fileStats.used)
+		{
+			continue;
+		}
+
+		json << (firstFile ? "\n" : ",\n");
+		firstFile = false;
+		json << "\t\t{\n";
+		json << "\t\t\t\"file\": \"" << JsonUtils::EscapeString(filesNames[fileIndex]) << "\",\n";
+		json << "\t\t\t\"total_seconds\": " << fileStats.totalNanoseconds / 1e9 << ",\n";
+		json << "\t\t\t\"phases_seconds\": {";
+		for (int phase = 0; phase < (int)DDAStatsPhase::COUNT; phase++)
+		{
+			const uint64_t nanoseconds = fileStats.phaseNanoseconds[phase];
+			totalPhaseNanoseconds[phase] += nanoseconds;
+			json << (phase == 0 ? " " : ", ") << "\"" << phaseNames[phase] << "\": " << nanoseconds / 1e9;
+		}
+		json << " },\n";
+		json << "\t\t\t\"counters\": {";
+		for (int counter = 0; counter < (int)DDAStatsCounter::COUNT; counter++)
+		{
+			const uint64_t value = fileStats.counters[counter];
+			totalCounters[counter] += value;
+			json << (counter == 0 ? " " : ", ") << "\"" << counterNames[counter] << "\": " << value;
+		}
+		json << " }\n";
+		json << "\t\t}";
+	}
+	json << "\n\t],\n";
+
+	json << "\t\"totals\": {\n";
+	json << "\t\t\"phases_seconds\": {";
+	for (int phase = 0; phase < (int)DDAStatsPhase::COUNT; phase++)
+	{
+		json << (phase == 0 ? " " : ", ") << "\"" << phaseNames[phase] << "\": " << totalPhaseNanoseconds[phase] / 1e9;
+	}
+	json << " },\n";
+	json << "\t\t\"counters\": {";
+	for (int counter = 0; counter < (int)DDAStatsCounter::COUNT; counter++)
+	{
+		json << (counter == 0 ? " " : ", ") << "\"" << counterNames[counter] << "\": " << totalCounters[counter];
+	}
+	json << " }\n";
+	json << "\t}\n";
+	json << "}\n";
+
+	return json.str();
+}
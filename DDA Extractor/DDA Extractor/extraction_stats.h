@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+#include <chrono>
+#include <cstdint>
+
+#include "dda_structures.h"
+
+// Steps of an extraction, each one has its own time in the stats
+enum class DDAStatsPhase
+{
+	READ,
+	TABLE_PARSE,
+	PACKET_SCAN,
+	MESH_GENERATION,
+	PALETTE_FIX,
+	CLUT_DECODE,
+	PNG_ENCODE,
+	TEXTURE_WRITE,
+	BLOCK_ENCODE,
+	TEXTURE_ATLAS,
+	FBX_EXPORT,
+	GLB_EXPORT,
+	COUNT
+};
+
+enum class DDAStatsCounter
+{
+	PACKETS_FOUND,
+	PACKETS_ABORTED,
+	TRIANGLES,
+	TEXTURES,
+	TEXTURES_DEDUPLICATED,
+	BYTES_WRITTEN,
+	COUNT
+};
+
+/**
+* @brief Time spent in each phase and counters of each extracted file
+* @brief Disabled by default, when disabled the timers and counters only check a bool
+*/
+class ExtractionStats
+{
+public:
+	/**
+	* @brief Enable or disable the stats, must be called before the extraction starts
+	*/
+	static void SetEnabled(bool enabled) { s_enabled = enabled; }
+	static bool IsEnabled() { return s_enabled; }
+
+	/**
+	* @brief Add a value to a counter of the file processed by the current thread (see FileScope)
+	*/
+	static void AddCounter(DDAStatsCounter counter, uint64_t value)
+	{
+		if (s_enabled)
+		{
+			AddCounterToCurrentFile(counter, value);
+		}
+	}
+
+	/**
+	* @brief Get the stats of all extracted files as JSON
+	*/
+	static std::string ToJson();
+
+	/**
+	* @brief Set the file processed by the current thread while the scope is alive
+	*/
+	class FileScope
+	{
+	public:
+		/**
+		* @param measureTime Measure the total time of the file, used for the scope around the whole extraction of the file
+		*/
+		explicit FileScope(DDAGameFile gameFile, bool measureTime = false);
+		~FileScope();
+
+		FileScope(const FileScope&) = delete;
+		FileScope& operator=(const FileScope&) = delete;
+
+	private:
+		int m_previousFile = -1;
+		bool m_measureTime = false;
+		std::chrono::steady_clock::time_point m_startTime;
+	};
+
+	/**
+	* @brief Add the time of the scope to a phase of the current file
+	* @brief The time of a nested timer is not added to the parent timer, so phases do not overlap
+	*/
+	class ScopedPhaseTimer
+	{
+	public:
+		explicit ScopedPhaseTimer(DDAStatsPhase phase)
+		{
+			if (s_enabled)
+			{
+				Start(phase);
+			}
+		}
+
+		~ScopedPhaseTimer()
+		{
+			Stop();
+		}
+
+		ScopedPhaseTimer(const ScopedPhaseTimer&) = delete;
+		ScopedPhaseTimer& operator=(const ScopedPhaseTimer&) = delete;
+
+		/**
+		* @brief Stop the timer before the end of the scope
+		*/
+		void Stop()
+		{
+			if (m_started)
+			{
+				StopTimer();
+			}
+		}
+
+	private:
+		void Start(DDAStatsPhase phase);
+		void StopTimer();
+
+		DDAStatsPhase m_phase = DDAStatsPhase::READ;
+		bool m_started = false;
+		ScopedPhaseTimer* m_parent = nullptr;
+		std::chrono::steady_clock::time_point m_startTime;
+	};
+
+private:
+	static void AddCounterToCurrentFile(DDAStatsCounter counter, uint64_t value);
+	static void AddPhaseTime(DDAStatsPhase phase, std::chrono::steady_clock::duration duration);
+
+	static inline bool s_enabled = false;
+};
@@ -0,0 +1,850 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "fixture_generator.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+
+namespace
+{
+	constexpr size_t MAP_HEADER_OFFSET = 0x80;
+	constexpr size_t SKYBOX_DATA_HEADER_ADDRESS = 0;
+	constexpr size_t MESH_PACKETS_PER_LIST = 8;
+	constexpr size_t LISTS_PER_PARENT_PACKET = 4;
+	constexpr size_t MENU_TEXTURE_HEADER_LIST_START = 0x28;
+	constexpr size_t MENU_TEXTURE_HEADER_SIZE = 0x90;
+	constexpr size_t MENU_PALETTE_SIZE = 0x400;
+	constexpr float BOUNDING_BOX_CORNER = 131072.0f; // Gives a mesh scale of 16 (see MeshGenerator::GetScaleAxis)
+	constexpr size_t ANIMATED_MAP_TEXTURE_INDEX = 7; // Animated texture of the maps, used by the first mesh packets
+
+	size_t Align(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	/**
+	* @brief Content of the generated file
+	*/
+	class FixtureBuffer
+	{
+	public:
+		size_t GetSize() const { return m_data.size(); }
+
+		/**
+		* @brief Add zeroed bytes at the end of the file
+		* @return Address of the new bytes
+		*/
+		size_t Allocate(size_t size, size_t alignment = 16)
+		{
+			const size_t address = Align(m_data.size(), alignment);
+			m_data.resize(address + size, 0);
+			return address;
+		}
+
+		void Resize(size_t size) { m_data.resize(size, 0); }
+		void AlignSize(size_t alignment) { m_data.resize(Align(m_data.size(), alignment), 0); }
+		uint8_t* GetPointer(size_t address) { return m_data.data() + address; }
+		std::vector<uint8_t>& GetData() { return m_data; }
+
+		template<typename T>
+		void Write(size_t address, const T& value)
+		{
+			memcpy(m_data.data() + address, &value, sizeof(T));
+		}
+
+	private:
+		std::vector<uint8_t> m_data;
+	};
+
+	struct FixtureTexture
+	{
+		std::string name;
+		DDAClutType clutType = DDAClutType::CLUT_256;
+		uint32_t width = 0; // Without the mipmaps
+		uint32_t height = 0;
+		uint32_t mipmapCount = 1;
+		bool isCarSkin = false; // Normal and broken skins side by side with two palettes
+		uint32_t clutCount = 1; // Palettes of a texture that is not a car skin, stored one after the other
+		uint32_t frameCount = 1; // Frames of an animated texture, stacked in the entry, the mipmap count of the entry is set to the frame count
+		bool hasPaddedMipmaps = false; // The entry of a mipmapped texture is twice the height instead of 1.5 times, like an animated texture with 2 frames
+	};
+
+	DDAGameFileType GetFixtureFileType(DDAGameFile gameFile)
+	{
+		if (gameFile <= DDAGameFile::WINBOWL)
+		{
+			return DDAGameFileType::MAP;
+		}
+		else if (gameFile <= DDAGameFile::ZTAXI)
+		{
+			return DDAGameFileType::CAR;
+		}
+		else if (gameFile == DDAGameFile::INGAME)
+		{
+			return DDAGameFileType::IN_GAME;
+		}
+		else if (gameFile == DDAGameFile::SPRITES)
+		{
+			return DDAGameFileType::SPRITES;
+		}
+		else if (gameFile == DDAGameFile::FONT)
+		{
+			return DDAGameFileType::FONT;
+		}
+		return DDAGameFileType::MENU;
+	}
+
+	std::string GetFixtureFileName(DDAGameFile gameFile)
+	{
+		const std::string& filePath = filesNames[(int)gameFile];
+		const size_t lastSlash = filePath.find_last_of('\\');
+		const std::string fileName = filePath.substr(lastSlash == std::string::npos ? 0 : lastSlash + 1);
+		return fileName.substr(0, fileName.find_last_of('.'));
+	}
+
+	void WriteName(char* destination, size_t destinationSize, const std::string& name)
+	{
+		memset(destination, 0, destinationSize);
+		memcpy(destination, name.c_str(), std::min(name.size(), destinationSize - 1));
+	}
+
+	/**
+	* @brief Data block names are 4 characters without a null terminator
+	*/
+	void WriteBlockName(char (&destination)[DATA_BLOCK_HEADER_NAME_SIZE], const std::string& name)
+	{
+		memset(destination, 0, DATA_BLOCK_HEADER_NAME_SIZE);
+		memcpy(destination, name.c_str(), std::min(name.size(), DATA_BLOCK_HEADER_NAME_SIZE));
+	}
+
+	/**
+	* @brief Get the position of a color in a palette stored in the file
+	* @brief This is the opposite of DDAFileParser::GetFixedPalette: in each group of 32 colors, the colors 8-15 and 16-23 are swapped
+	* @brief Car skins have two 256 colors palettes mixed by groups of 16 colors
+	*/
+	size_t GetSwizzledColorIndex(size_t colorIndex, size_t paletteIndex, size_t paletteCount)
+	{
+		const size_t bit3 = (colorIndex >> 3) & 1;
+		const size_t bit4 = (colorIndex >> 4) & 1;
+		const size_t swappedIndex = (colorIndex & ~static_cast<size_t>(0x18)) | (bit3 << 4) | (bit4 << 3);
+		return ((swappedIndex >> 4) * paletteCount + paletteIndex) * 16 + (swappedIndex & 0x0F);
+	}
+
+	/**
+	* @brief Create random palette colors with PS2 alpha values (0-128)
+	*/
+	std::vector<uint8_t> GeneratePaletteColors(std::mt19937& random, size_t colorCount)
+	{
+		// Some textures have transparent or translucent colors
+		const uint32_t alphaMode = random() % 4;
+		std::vector<uint8_t> colors(colorCount * 4);
+		for (size_t colorIndex = 0; colorIndex < colorCount; colorIndex++)
+		{
+			uint8_t* color = colors.data() + colorIndex * 4;
+			color[0] = static_cast<uint8_t>(random());
+			color[1] = static_cast<uint8_t>(random());
+			color[2] = static_cast<uint8_t>(random());
+			color[3] = 0x80;
+			if (alphaMode == 1 && colorIndex == 0)
+			{
+				color[3] = 0;
+			}
+			else if (alphaMode == 2 && colorIndex % 4 == 0)
+			{
+				color[3] = 0x40;
+			}
+		}
+		return colors;
+	}
+
+	/**
+	* @brief Fill the texture with blocks of colors and some noise
+	*/
+	void FillIndices(std::mt19937& random, std::vector<uint8_t>& indices, size_t stride, size_t xStart, size_t width, size_t height, size_t colorCount)
+	{
+		const size_t blockSize = static_cast<size_t>(4) << (random() % 3);
+		const uint32_t seed = random();
+		for (size_t y = 0; y < height; y++)
+		{
+			for (size_t x = 0; x < width; x++)
+			{
+				size_t colorId = (x / blockSize + (y / blockSize) * 3 + seed) % colorCount;
+				if (random() % 8 == 0)
+				{
+					colorId = random() % colorCount;
+				}
+				indices[xStart + x + y * stride] = static_cast<uint8_t>(colorId);
+			}
+		}
+	}
+
+	/**
+	* @brief Write the texture infos, palette and pixels at the end of the file
+	* @param origin Address used as the start of the texture positions of the entry
+	* @param expectations The mipmaps, frames and palettes of the texture are added to it
+	* @return The texture table entry of the texture
+	*/
+	DDATextureTableEntry WriteTexture(FixtureBuffer& buffer, std::mt19937& random, const FixtureTexture& texture, size_t origin, uint32_t textureIndex, DDAFixtureExpectations& expectations)
+	{
+		const bool is16Colors = texture.clutType == DDAClutType::CLUT_16;
+		const size_t colorCount = is16Colors ? 16 : 256;
+
+		// Texture infos with the size without mipmaps and the texture file path
+		DDATextureHeader textureHeader = {};
+		textureHeader.width = texture.width;
+		textureHeader.height = texture.height;
+		textureHeader.indexInDataChunk = textureIndex;
+		WriteName(textureHeader.filePath, sizeof(textureHeader.filePath), "C:\\DDA\\TEXTURES\\" + texture.name + ".TGA");
+		const size_t textureInfosAddress = buffer.Allocate(sizeof(DDATextureHeader));
+		buffer.Write(textureInfosAddress, textureHeader);
+
+		// Palette, a 16 colors palette uses the colors 0-7 and 16-23 of 32 colors
+		// Car skin palettes are mixed, the palettes of other textures are one after the other
+		const size_t paletteCount = texture.isCarSkin ? 2 : texture.clutCount;
+		const size_t mixedPaletteCount = texture.isCarSkin ? 2 : 1;
+		const size_t paletteSize = (is16Colors ? 32 : colorCount * mixedPaletteCount) * sizeof(uint32_t);
+		const size_t paletteAddress = buffer.Allocate(paletteSize * (paletteCount / mixedPaletteCount));
+		for (size_t paletteIndex = 0; paletteIndex < paletteCount; paletteIndex++)
+		{
+			const std::vector<uint8_t> colors = GeneratePaletteColors(random, colorCount);
+			const size_t mixedPaletteIndex = paletteIndex % mixedPaletteCount;
+			const size_t currentPaletteAddress = paletteAddress + (paletteIndex / mixedPaletteCount) * paletteSize;
+			for (size_t colorIndex = 0; colorIndex < colorCount; colorIndex++)
+			{
+				const size_t swizzledIndex = GetSwizzledColorIndex(colorIndex, mixedPaletteIndex, mixedPaletteCount);
+				memcpy(buffer.GetPointer(currentPaletteAddress + swizzledIndex * sizeof(uint32_t)), colors.data() + colorIndex * 4, sizeof(uint32_t));
+			}
+		}
+
+		// Mipmaps are stored under the first level, from left to right
+		const uint32_t entryWidth = texture.isCarSkin ? texture.width * 2 : texture.width;
+		uint32_t entryHeight = texture.height;
+		if (texture.mipmapCount > 1)
+		{
+			entryHeight = texture.hasPaddedMipmaps ? texture.height * 2 : texture.height + texture.height / 2;
+		}
+		if (texture.frameCount > 1)
+		{
+			entryHeight = texture.height * texture.frameCount;
+		}
+		std::vector<uint8_t> indices(static_cast<size_t>(entryWidth) * entryHeight, 0);
+		FillIndices(random, indices, entryWidth, 0, texture.width, texture.height * texture.frameCount, colorCount);
+		if (texture.isCarSkin)
+		{
+			FillIndices(random, indices, entryWidth, texture.width, texture.width, texture.height, colorCount);
+		}
+
+		size_t mipmapX = 0;
+		for (uint32_t mipmapLevel = 1; mipmapLevel < texture.mipmapCount; mipmapLevel++)
+		{
+			const size_t mipmapWidth = texture.width >> mipmapLevel;
+			const size_t mipmapHeight = texture.height >> mipmapLevel;
+			for (size_t y = 0; y < mipmapHeight; y++)
+			{
+				for (size_t x = 0; x < mipmapWidth; x++)
+				{
+					indices[(mipmapX + x) + (texture.height + y) * entryWidth] = indices[(x << mipmapLevel) + (y << mipmapLevel) * entryWidth];
+				}
+			}
+			mipmapX += mipmapWidth;
+		}
+
+		// With 16 colors, there are two pixels per byte
+		size_t textureAddress = 0;
+		if (is16Colors)
+		{
+			textureAddress = buffer.Allocate(indices.size() / 2);
+			uint8_t* textureData = buffer.GetPointer(textureAddress);
+			for (size_t i = 0; i < indices.size() / 2; i++)
+			{
+				textureData[i] = static_cast<uint8_t>(indices[i * 2] | (indices[i * 2 + 1] << 4));
+			}
+		}
+		else
+		{
+			textureAddress = buffer.Allocate(indices.size());
+			memcpy(buffer.GetPointer(textureAddress), indices.data(), indices.size());
+		}
+
+		// Car skins are split in two textures without mipmaps, their two palettes are not alternate palettes
+		if (!texture.isCarSkin)
+		{
+			expectations.mipmapLevelCount += texture.mipmapCount - 1;
+			expectations.frameCount += texture.frameCount > 1 ? texture.frameCount : 0;
+			expectations.alternatePaletteCount += texture.clutCount - 1;
+		}
+
+		DDATextureTableEntry entry;
+		entry.mipmapCount = texture.frameCount > 1 ? texture.frameCount : texture.mipmapCount;
+		entry.clutType = texture.clutType;
+		entry.width = entryWidth;
+		entry.height = entryHeight;
+		entry.unknown0 = textureIndex;
+		entry.unknown1 = 1;
+		entry.texturePosition = static_cast<uint32_t>(textureAddress - origin);
+		entry.unknown3 = 16;
+		entry.unknown4 = static_cast<uint32_t>(16 * paletteCount);
+		entry.clutCount = static_cast<uint32_t>(paletteCount);
+		entry.palettePosition = static_cast<uint32_t>(paletteAddress - origin);
+		entry.textureInfosPosition = static_cast<uint32_t>(textureInfosAddress - origin);
+		return entry;
+	}
+
+	/**
+	* @brief Get a random texture, a texture name is sometimes used twice like in the game files
+	*/
+	FixtureTexture GetRandomTexture(std::mt19937& random, const std::string& fileName, size_t textureIndex, uint32_t maxSizeShift)
+	{
+		FixtureTexture texture;
+		const size_t nameIndex = (textureIndex % 16 == 15) ? textureIndex - 1 : textureIndex;
+		texture.name = fileName + "_TEX_" + std::to_string(nameIndex);
+		texture.clutType = random() % 3 == 0 ? DDAClutType::CLUT_16 : DDAClutType::CLUT_256;
+		texture.width = 16u << (random() % maxSizeShift);
+		texture.height = 16u << (random() % maxSizeShift);
+		if (random() % 2 == 0)
+		{
+			// Keep the smallest mipmap at least 4 pixels wide
+			uint32_t maxMipmapCount = 1;
+			while ((std::min(texture.width, texture.height) >> maxMipmapCount) >= 4 && maxMipmapCount < 4)
+			{
+				maxMipmapCount++;
+			}
+			texture.mipmapCount = 1 + random() % maxMipmapCount;
+
+			// With 2 levels, a padded entry has the size and the mipmap count of a 2 frames animation, only its empty padding tells them apart
+			texture.hasPaddedMipmaps = texture.mipmapCount > 1 && textureIndex % 4 == 3;
+		}
+		// Some textures have alternate palettes (other colors of the same texture)
+		if (textureIndex % 8 == 5)
+		{
+			texture.clutCount = 2 + static_cast<uint32_t>(textureIndex % 3);
+		}
+		return texture;
+	}
+
+	/**
+	* @brief Write a mesh packet with the VIF unpacks MeshGenerator::GetMeshDataInfos is looking for
+	* @param isTextureRepeated Put the UVs between 1 and 2 instead of 0 and 1, like the meshes repeating their texture
+	*/
+	void WriteMeshPacket(FixtureBuffer& buffer, std::mt19937& random, bool isTextureRepeated)
+	{
+		const uint8_t vertexCount = static_cast<uint8_t>(8 + random() % 40);
+
+		// Unpack with a gif tag right after
+		const size_t gifTagAddress = buffer.Allocate(5 * sizeof(uint32_t), 4);
+		uint8_t* gifTag = buffer.GetPointer(gifTagAddress);
+		gifTag[1] = 0x80;
+		gifTag[2] = 0x01;
+		gifTag[3] = 0x6C;
+		gifTag[4] = vertexCount;
+		gifTag[5] = 0x80;
+
+		// STROW with the first bounding box corner
+		const size_t strowAddress = buffer.Allocate(sizeof(uint32_t) + 3 * sizeof(float), 4);
+		buffer.GetPointer(strowAddress)[3] = 0x30;
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			buffer.Write(strowAddress + sizeof(uint32_t) + axis * sizeof(float), BOUNDING_BOX_CORNER);
+		}
+
+		// Positions, unpack V3_16
+		const size_t positionsAddress = buffer.Allocate(sizeof(uint32_t) + vertexCount * 3 * sizeof(uint16_t), 4);
+		const uint8_t positionsUnpack[4] = { 0x02, 0xC0, vertexCount, 0x69 };
+		memcpy(buffer.GetPointer(positionsAddress), positionsUnpack, sizeof(positionsUnpack));
+		for (size_t i = 0; i < vertexCount * 3; i++)
+		{
+			buffer.Write(positionsAddress + sizeof(uint32_t) + i * sizeof(uint16_t), static_cast<uint16_t>(random() % 0x1000));
+		}
+		buffer.AlignSize(4);
+
+		// Second bounding box corner, unpack V3_32, it moves the mesh center
+		const size_t boundingBoxAddress = buffer.Allocate(sizeof(uint32_t) + 3 * sizeof(float), 4);
+		const uint8_t boundingBoxUnpack[4] = { 0x01, 0x80, 0x01, 0x68 };
+		memcpy(buffer.GetPointer(boundingBoxAddress), boundingBoxUnpack, sizeof(boundingBoxUnpack));
+		for (size_t axis = 0; axis < 3; axis++)
+		{
+			const float corner = BOUNDING_BOX_CORNER + 4.0f * static_cast<float>(random() % 512);
+			buffer.Write(boundingBoxAddress + sizeof(uint32_t) + axis * sizeof(float), corner);
+		}
+
+		// UVs, unpack V2_16, the first bit is the end of strip flag, keep one strip
+		const size_t uvsAddress = buffer.Allocate(sizeof(uint32_t) + vertexCount * 2 * sizeof(uint16_t), 4);
+		const uint8_t uvsUnpack[4] = { 0x50, 0x80, vertexCount, 0x65 };
+		memcpy(buffer.GetPointer(uvsAddress), uvsUnpack, sizeof(uvsUnpack));
+		const uint16_t uvOffset = isTextureRepeated ? 0x1000 : 0;
+		for (size_t i = 0; i < vertexCount * 2; i++)
+		{
+			buffer.Write(uvsAddress + sizeof(uint32_t) + i * sizeof(uint16_t), static_cast<uint16_t>((random() % 0x800) * 2 + uvOffset));
+		}
+
+		// Colors (maps) or normals (cars), unpack V3_8, right after the UVs
+		const size_t colorsAddress = buffer.Allocate(sizeof(uint32_t) + vertexCount * 3, 4);
+		const uint8_t colorsUnpack[4] = { 0x9E, 0xC0, vertexCount, 0x6A };
+		memcpy(buffer.GetPointer(colorsAddress), colorsUnpack, sizeof(colorsUnpack));
+		for (size_t i = 0; i < vertexCount * 3; i++)
+		{
+			buffer.GetPointer(colorsAddress + sizeof(uint32_t))[i] = static_cast<uint8_t>(0x20 + random() % 0x60);
+		}
+
+		// The parser skips a few bytes after the colors, do not start the next packet in them
+		const size_t colorsSize = sizeof(uint32_t) + vertexCount * 3;
+		buffer.Resize(Align(colorsAddress + colorsSize + colorsSize % 4 + 1, 4));
+	}
+
+	/**
+	* @brief Write the parent packets, packet/texture pairs and VIF packet lists of a map or a car
+	* @param animatedTextureIndex Texture used by the first packet list, its last packet repeats the texture, SIZE_MAX to only use random textures
+	*/
+	void WriteMeshPackets(FixtureBuffer& buffer, std::mt19937& random, size_t meshPacketCount, size_t textureCount, size_t animatedTextureIndex)
+	{
+		const size_t listCount = (meshPacketCount + MESH_PACKETS_PER_LIST - 1) / MESH_PACKETS_PER_LIST;
+		const size_t parentCount = (listCount + LISTS_PER_PARENT_PACKET - 1) / LISTS_PER_PARENT_PACKET;
+
+		// The parser only reads the first byte of the parent packet table address
+		const size_t parentTableAddress = buffer.Allocate(parentCount * sizeof(DDAParentDrawCommandEntry));
+		buffer.Write(MAP_HEADER_OFFSET + sizeof(uint32_t), static_cast<uint32_t>(parentCount));
+		buffer.Write(MAP_HEADER_OFFSET + sizeof(uint32_t) * 2, static_cast<uint32_t>(parentTableAddress - MAP_HEADER_OFFSET));
+
+		size_t remainingPacketCount = meshPacketCount;
+		for (size_t parentIndex = 0; parentIndex < parentCount; parentIndex++)
+		{
+			const size_t pairCount = std::min(LISTS_PER_PARENT_PACKET, listCount - parentIndex * LISTS_PER_PARENT_PACKET);
+			const size_t pairsAddress = buffer.Allocate(pairCount * sizeof(DDAPacketAndTextureEntry));
+
+			DDAParentDrawCommandEntry parentEntry;
+			parentEntry.vifPacketTexturePairCount = static_cast<uint32_t>(pairCount);
+			parentEntry.addr = static_cast<uint32_t>(pairsAddress - MAP_HEADER_OFFSET);
+			buffer.Write(parentTableAddress + parentIndex * sizeof(DDAParentDrawCommandEntry), parentEntry);
+
+			for (size_t pairIndex = 0; pairIndex < pairCount; pairIndex++)
+			{
+				// The list starts with its size in quadwords
+				const size_t listAddress = buffer.Allocate(DATA_BLOCK_HEADER_SIZE);
+				const size_t packetCount = std::min(MESH_PACKETS_PER_LIST, remainingPacketCount);
+				remainingPacketCount -= packetCount;
+				const bool isAnimatedTextureList = parentIndex == 0 && pairIndex == 0 && animatedTextureIndex < textureCount;
+				for (size_t packetIndex = 0; packetIndex < packetCount; packetIndex++)
+				{
+					WriteMeshPacket(buffer, random, isAnimatedTextureList && packetIndex == packetCount - 1);
+				}
+				buffer.AlignSize(16);
+				buffer.Write(listAddress, static_cast<uint16_t>((buffer.GetSize() - listAddress) / 16));
+
+				DDAPacketAndTextureEntry pair;
+				pair.vifPacketListAddr = static_cast<uint32_t>(listAddress - MAP_HEADER_OFFSET);
+				pair.textureIndex = static_cast<uint32_t>(random() % textureCount);
+				if (isAnimatedTextureList)
+				{
+					pair.textureIndex = static_cast<uint32_t>(animatedTextureIndex);
+				}
+				buffer.Write(pairsAddress + pairIndex * sizeof(DDAPacketAndTextureEntry), pair);
+			}
+		}
+	}
+
+	/**
+	* @brief Write a texture table header and its entries, the texture data is written later
+	* @return Address of the table header
+	*/
+	size_t WriteTextureTableHeader(FixtureBuffer& buffer, const std::string& name, size_t entryCount)
+	{
+		const size_t entriesSize = entryCount * sizeof(DDATextureTableEntry);
+		const size_t tableAddress = buffer.Allocate(sizeof(DDATextureTableHeader) + entriesSize);
+		buffer.AlignSize(16);
+
+		DDATextureTableHeader header;
+		header.blockDataSize = static_cast<uint32_t>(buffer.GetSize() - tableAddress - DATA_BLOCK_HEADER_SIZE);
+		WriteBlockName(header.name, name);
+		header.offset = DATA_BLOCK_HEADER_SIZE;
+		header.size = static_cast<uint32_t>(entriesSize);
+		buffer.Write(tableAddress, header);
+		return tableAddress;
+	}
+
+	void WriteTextureTableEntry(FixtureBuffer& buffer, size_t tableAddress, size_t entryIndex, const DDATextureTableEntry& entry)
+	{
+		buffer.Write(tableAddress + sizeof(DDATextureTableHeader) + entryIndex * sizeof(DDATextureTableEntry), entry);
+	}
+
+	/**
+	* @brief Generate a map or a car file
+	* @brief Layout: file header, parent packets, packet/texture pairs, VIF packet lists, texture table, skybox texture table, texture data
+	*/
+	void GenerateMapFile(FixtureBuffer& buffer, std::mt19937& random, DDAGameFile gameFile, const DDAFixtureProfile& profile, DDAFixtureExpectations& expectations)
+	{
+		const DDAGameFileType fileType = GetFixtureFileType(gameFile);
+		const bool isCar = fileType == DDAGameFileType::CAR;
+		const std::string fileName = GetFixtureFileName(gameFile);
+
+		// WINBOWL and cars do not have a skybox
+		size_t skyboxTextureCount = 0;
+		if (!isCar && gameFile != DDAGameFile::WINBOWL && profile.textureCount > 1)
+		{
+			skyboxTextureCount = std::max<size_t>(profile.textureCount / 32, 1);
+		}
+		const size_t textureCount = profile.textureCount - skyboxTextureCount;
+
+		buffer.Allocate(MAP_HEADER_OFFSET + DATA_BLOCK_HEADER_SIZE);
+		buffer.Write(0, static_cast<uint32_t>(fileType));
+		buffer.Write(sizeof(uint32_t), static_cast<uint32_t>(SKYBOX_DATA_HEADER_ADDRESS));
+
+		// The UVs of the meshes using an animated texture are scaled to its first frame
+		const size_t animatedTextureIndex = isCar ? SIZE_MAX : ANIMATED_MAP_TEXTURE_INDEX;
+		WriteMeshPackets(buffer, random, profile.meshPacketCount, textureCount, animatedTextureIndex);
+
+		// The skybox texture table is the next block with the same name
+		const std::string tableName = fileName.substr(0, DATA_BLOCK_HEADER_NAME_SIZE);
+		const size_t tableAddress = WriteTextureTableHeader(buffer, tableName, textureCount);
+		buffer.Write(sizeof(uint32_t) * 2, static_cast<uint32_t>(tableAddress));
+		size_t skyboxTableAddress = 0;
+		if (skyboxTextureCount > 0)
+		{
+			skyboxTableAddress = WriteTextureTableHeader(buffer, tableName, skyboxTextureCount);
+		}
+
+		for (size_t textureIndex = 0; textureIndex < textureCount; textureIndex++)
+		{
+			FixtureTexture texture = GetRandomTexture(random, fileName, textureIndex, 4);
+			// The car skin is 512 pixels wide with the mipmap and the broken skin
+			if (isCar && textureIndex == 0)
+			{
+				texture.clutType = DDAClutType::CLUT_256;
+				texture.width = 256;
+				texture.height = 256;
+				texture.mipmapCount = 1;
+				texture.isCarSkin = true;
+			}
+			else if (textureIndex == animatedTextureIndex)
+			{
+				texture.mipmapCount = 1;
+				texture.frameCount = 4;
+			}
+			const DDATextureTableEntry entry = WriteTexture(buffer, random, texture, MAP_HEADER_OFFSET, static_cast<uint32_t>(textureIndex), expectations);
+			WriteTextureTableEntry(buffer, tableAddress, textureIndex, entry);
+		}
+
+		const size_t skyboxOrigin = SKYBOX_DATA_HEADER_ADDRESS + MAP_HEADER_OFFSET + MAP_HEADER_OFFSET;
+		for (size_t textureIndex = 0; textureIndex < skyboxTextureCount; textureIndex++)
+		{
+			FixtureTexture texture = GetRandomTexture(random, fileName + "_SKY", textureIndex, 4);
+			texture.mipmapCount = 1;
+			const DDATextureTableEntry entry = WriteTexture(buffer, random, texture, skyboxOrigin, static_cast<uint32_t>(textureIndex), expectations);
+			WriteTextureTableEntry(buffer, skyboxTableAddress, textureIndex, entry);
+		}
+
+		buffer.AlignSize(16);
+		expectations.textureCount = profile.textureCount;
+		expectations.meshPacketCount = profile.meshPacketCount;
+		expectations.firstFrameTextureCount = animatedTextureIndex < textureCount && profile.meshPacketCount > 0 ? 1 : 0;
+	}
+
+	/**
+	* @brief Generate the SPRITES file, a list of blocks with one texture table entry and its data in each block
+	*/
+	void GenerateSpritesFile(FixtureBuffer& buffer, std::mt19937& random, const DDAFixtureProfile& profile, DDAFixtureExpectations& expectations)
+	{
+		for (size_t textureIndex = 0; textureIndex < profile.textureCount; textureIndex++)
+		{
+			const size_t blockAddress = buffer.Allocate(DATA_BLOCK_HEADER_SIZE + sizeof(DDATextureTableEntry));
+			const size_t origin = blockAddress + DATA_BLOCK_HEADER_SIZE;
+
+			FixtureTexture texture = GetRandomTexture(random, "SPRITE", textureIndex, 3);
+			// Some sprites are animated, like the particles of the game
+			if (textureIndex % 6 == 4)
+			{
+				texture.mipmapCount = 1;
+				texture.frameCount = 2 + static_cast<uint32_t>(textureIndex % 7);
+			}
+			const DDATextureTableEntry entry = WriteTexture(buffer, random, texture, origin, static_cast<uint32_t>(textureIndex), expectations);
+			buffer.AlignSize(16);
+
+			// The first block header starts with the file type
+			const uint32_t blockType = textureIndex == 0 ? static_cast<uint32_t>(DDAGameFileType::SPRITES) : 0;
+			buffer.Write(blockAddress, blockType);
+			buffer.Write(blockAddress + sizeof(uint32_t), static_cast<uint32_t>(buffer.GetSize() - origin));
+			buffer.Write(origin, entry);
+		}
+
+		expectations.textureCount = profile.textureCount;
+	}
+
+	/**
+	* @brief Generate the IN_GAME file
+	* @brief Layout: texture data blocks linked by their headers, then the texture tables until the end of the file
+	*/
+	void GenerateInGameFile(FixtureBuffer& buffer, std::mt19937& random, const DDAFixtureProfile& profile, DDAFixtureExpectations& expectations)
+	{
+		const std::string baseName = "INGM";
+		const size_t tableCount = std::min<size_t>(3, profile.textureCount);
+		std::vector<std::vector<DDATextureTableEntry>> tablesEntries(tableCount);
+
+		buffer.Allocate(DATA_BLOCK_HEADER_SIZE);
+		size_t textureIndex = 0;
+		size_t previousBlockAddress = 0;
+		for (size_t tableIndex = 0; tableIndex < tableCount; tableIndex++)
+		{
+			// The texture data of the first table is in the first block, the other ones start 0x80 bytes after their block header
+			size_t origin = DATA_BLOCK_HEADER_SIZE;
+			if (tableIndex > 0)
+			{
+				const size_t blockAddress = buffer.Allocate(MAP_HEADER_OFFSET);
+				origin = blockAddress + MAP_HEADER_OFFSET;
+
+				DDATextureTableHeader blockHeader;
+				WriteBlockName(blockHeader.name, "BLK" + std::to_string(tableIndex));
+				buffer.Write(blockAddress, blockHeader);
+				if (tableIndex > 1)
+				{
+					buffer.Write(previousBlockAddress + sizeof(uint32_t) * 2, static_cast<uint32_t>(blockAddress - previousBlockAddress));
+				}
+				previousBlockAddress = blockAddress;
+			}
+
+			const size_t tableTextureCount = profile.textureCount / tableCount + (tableIndex < profile.textureCount % tableCount ? 1 : 0);
+			for (size_t i = 0; i < tableTextureCount; i++)
+			{
+				const FixtureTexture texture = GetRandomTexture(random, "INGAME", textureIndex, 3);
+				tablesEntries[tableIndex].push_back(WriteTexture(buffer, random, texture, origin, static_cast<uint32_t>(textureIndex), expectations));
+				textureIndex++;
+			}
+			buffer.AlignSize(16);
+
+			if (tableIndex == 0)
+			{
+				buffer.Write(sizeof(uint32_t), static_cast<uint32_t>(buffer.GetSize() - DATA_BLOCK_HEADER_SIZE));
+			}
+		}
+
+		// The first texture table has the same name as the first block, this ends the block list
+		const size_t firstTableAddress = buffer.GetSize();
+		if (previousBlockAddress != 0)
+		{
+			buffer.Write(previousBlockAddress + sizeof(uint32_t) * 2, static_cast<uint32_t>(firstTableAddress - previousBlockAddress));
+		}
+		for (size_t tableIndex = 0; tableIndex < tableCount; tableIndex++)
+		{
+			const std::vector<DDATextureTableEntry>& entries = tablesEntries[tableIndex];
+			const size_t tableAddress = WriteTextureTableHeader(buffer, tableIndex == 0 ? baseName : "TBL" + std::to_string(tableIndex), entries.size());
+			for (size_t entryIndex = 0; entryIndex < entries.size(); entryIndex++)
+			{
+				WriteTextureTableEntry(buffer, tableAddress, entryIndex, entries[entryIndex]);
+			}
+		}
+
+		DDATextureTableHeader baseHeader;
+		baseHeader.unkown0 = static_cast<uint32_t>(DDAGameFileType::IN_GAME);
+		baseHeader.blockDataSize = *reinterpret_cast<uint32_t*>(buffer.GetPointer(sizeof(uint32_t)));
+		baseHeader.bytesCountBeforeEndFile = static_cast<uint32_t>(firstTableAddress);
+		WriteBlockName(baseHeader.name, baseName);
+		memcpy(buffer.GetPointer(0), &baseHeader, DATA_BLOCK_HEADER_SIZE);
+
+		expectations.textureCount = profile.textureCount;
+	}
+
+	/**
+	* @brief Write a menu texture header list at a fixed address, followed by the texture data and the palettes
+	*/
+	void WriteMenuTextureList(FixtureBuffer& buffer, std::mt19937& random, const std::string& fileName, size_t listAddress, size_t textureCount, bool usePalette)
+	{
+		const uint32_t width = 32;
+		const uint32_t height = usePalette ? 32 : 16;
+		const size_t blockAddress = listAddress - DATA_BLOCK_HEADER_SIZE;
+		const size_t headerListSize = Align(MENU_TEXTURE_HEADER_LIST_START + textureCount * MENU_TEXTURE_HEADER_SIZE, 16);
+		buffer.Resize(listAddress + headerListSize);
+		buffer.Write(listAddress + sizeof(uint32_t), static_cast<uint32_t>(textureCount));
+		buffer.Write(listAddress + sizeof(uint32_t) * 2, static_cast<uint32_t>(headerListSize));
+
+		// Texture addresses are relative to the end of the header list minus a block header
+		const size_t dataAddress = blockAddress + headerListSize;
+		for (size_t textureIndex = 0; textureIndex < textureCount; textureIndex++)
+		{
+			const size_t pixelCount = static_cast<size_t>(width) * height;
+			const size_t textureAddress = buffer.Allocate(usePalette ? pixelCount : pixelCount * sizeof(uint32_t));
+			uint8_t* textureData = buffer.GetPointer(textureAddress);
+			if (usePalette)
+			{
+				std::vector<uint8_t> indices(pixelCount);
+				FillIndices(random, indices, width, 0, width, height, 256);
+				memcpy(textureData, indices.data(), pixelCount);
+			}
+			else
+			{
+				for (size_t i = 0; i < pixelCount * sizeof(uint32_t); i++)
+				{
+					textureData[i] = static_cast<uint8_t>(random());
+				}
+			}
+
+			DDATextureHeader textureHeader = {};
+			textureHeader.unkown0 = static_cast<uint32_t>(textureAddress - dataAddress);
+			textureHeader.width = width;
+			textureHeader.height = height;
+			textureHeader.indexInDataChunk = static_cast<uint32_t>(textureIndex);
+			const std::string textureName = fileName + (usePalette ? "_PAL_" : "_RGBA_") + std::to_string(textureIndex);
+			WriteName(textureHeader.filePath, sizeof(textureHeader.filePath), "FLASH\\" + fileName + "\\" + textureName + ".PNG");
+			buffer.Write(listAddress + MENU_TEXTURE_HEADER_LIST_START + textureIndex * MENU_TEXTURE_HEADER_SIZE, textureHeader);
+		}
+		buffer.AlignSize(16);
+		buffer.Write(blockAddress + sizeof(uint32_t) * 2, static_cast<uint32_t>(buffer.GetSize() - dataAddress));
+
+		// One 256 colors palette per texture after the texture data
+		if (usePalette)
+		{
+			const size_t palettesAddress = buffer.Allocate(textureCount * MENU_PALETTE_SIZE);
+			for (size_t textureIndex = 0; textureIndex < textureCount; textureIndex++)
+			{
+				const std::vector<uint8_t> colors = GeneratePaletteColors(random, 256);
+				for (size_t colorIndex = 0; colorIndex < 256; colorIndex++)
+				{
+					const size_t swizzledIndex = GetSwizzledColorIndex(colorIndex, 0, 1);
+					memcpy(buffer.GetPointer(palettesAddress + textureIndex * MENU_PALETTE_SIZE + swizzledIndex * sizeof(uint32_t)), colors.data() + colorIndex * 4, sizeof(uint32_t));
+				}
+			}
+		}
+	}
+
+	/**
+	* @brief Generate a menu file, the texture header lists are at the addresses used by the parser
+	*/
+	void GenerateMenuFile(FixtureBuffer& buffer, std::mt19937& random, DDAGameFile gameFile, const DDAFixtureProfile& profile, DDAFixtureExpectations& expectations)
+	{
+		DDAMenuTextureListAddresses addresses;
+		if (!GetMenuTextureListAddresses(gameFile, addresses))
+		{
+			return;
+		}
+
+		// The RGBA textures have to fit before the second list
+		const size_t directColorTextureSize = 32 * 16 * sizeof(uint32_t);
+		const size_t availableSize = addresses.paletteList - addresses.directColorList - DATA_BLOCK_HEADER_SIZE * 2 - MENU_TEXTURE_HEADER_LIST_START;
+		const size_t maxDirectColorTextureCount = availableSize / (MENU_TEXTURE_HEADER_SIZE + directColorTextureSize);
+		const size_t directColorTextureCount = std::min(profile.textureCount * 2 / 5, maxDirectColorTextureCount);
+		const size_t paletteTextureCount = profile.textureCount - directColorTextureCount;
+
+		const std::string fileName = GetFixtureFileName(gameFile);
+		buffer.Resize(addresses.directColorList - DATA_BLOCK_HEADER_SIZE);
+		buffer.Write(0, static_cast<uint32_t>(DDAGameFileType::MENU));
+		WriteMenuTextureList(buffer, random, fileName, addresses.directColorList, directColorTextureCount, false);
+		buffer.Resize(addresses.paletteList - DATA_BLOCK_HEADER_SIZE);
+		WriteMenuTextureList(buffer, random, fileName, addresses.paletteList, paletteTextureCount, true);
+
+		expectations.textureCount = directColorTextureCount + paletteTextureCount;
+	}
+}
+
+std::vector<DDAGameFile> DDAFixtureGenerator::GetSupportedFiles()
+{
+	std::vector<DDAGameFile> gameFiles;
+	for (int gameFile = (int)DDAGameFile::AIRPORT; gameFile <= (int)DDAGameFile::DD4START; gameFile++)
+	{
+		// The font file is not extracted
+		if ((DDAGameFile)gameFile != DDAGameFile::FONT)
+		{
+			gameFiles.push_back((DDAGameFile)gameFile);
+		}
+	}
+	return gameFiles;
+}
+
+DDAFixtureProfile DDAFixtureGenerator::GetProfile(DDAGameFile gameFile, float scale)
+{
+	// Texture and mesh packet counts of the game files (see DDAFileParser::LaunchUnitTests)
+	DDAFixtureProfile profile;
+	switch (gameFile)
+	{
+	case DDAGameFile::AIRPORT: profile = { 283, 4233 }; break;
+	case DDAGameFile::BMOVIE: profile = { 145, 1090 }; break;
+	case DDAGameFile::BRON_2ND: profile = { 312, 4116 }; break;
+	case DDAGameFile::BRONX: profile = { 351, 5415 }; break;
+	case DDAGameFile::CHIN_2ND: profile = { 334, 5191 }; break;
+	case DDAGameFile::CHINATWN: profile = { 317, 5379 }; break;
+	case DDAGameFile::CONSTR: profile = { 187, 4002 }; break;
+	case DDAGameFile::DAM: profile = { 183, 6719 }; break;
+	case DDAGameFile::ENGINE: profile = { 65, 1760 }; break;
+	case DDAGameFile::GLADIATO: profile = { 84, 1924 }; break;
+	case DDAGameFile::GODS: profile = { 42, 829 }; break;
+	case DDAGameFile::JUSTICE: profile = { 128, 1709 }; break;
+	case DDAGameFile::REFINERY: profile = { 217, 6037 }; break;
+	case DDAGameFile::SHIPYARD: profile = { 272, 4779 }; break;
+	case DDAGameFile::STEELWRK: profile = { 147, 3534 }; break;
+	case DDAGameFile::SUBWAY: profile = { 194, 4800 }; break;
+	case DDAGameFile::VEGA_2ND: profile = { 417, 7436 }; break;
+	case DDAGameFile::VEGAS: profile = { 364, 5531 }; break;
+	case DDAGameFile::WINBOWL: profile = { 54, 1287 }; break;
+	case DDAGameFile::SPRITES: profile = { 67, 0 }; break;
+	case DDAGameFile::INGAME: profile = { 102, 0 }; break;
+	case DDAGameFile::DD4FRONT: profile = { 985, 0 }; break;
+	case DDAGameFile::DD4GAME: profile = { 314, 0 }; break;
+	case DDAGameFile::DD4START: profile = { 326, 0 }; break;
+	case DDAGameFile::FONT: profile = { 0, 0 }; break;
+	default: profile = { 1, 48 }; break; // Cars
+	}
+
+	profile.textureCount = std::max<size_t>(static_cast<size_t>(std::lround(profile.textureCount * scale)), 1);
+	profile.meshPacketCount = static_cast<size_t>(std::lround(profile.meshPacketCount * scale));
+	return profile;
+}
+
+std::vector<uint8_t> DDAFixtureGenerator::GenerateFileData(DDAGameFile gameFile, float scale, DDAFixtureExpectations& expectations)
+{
+	expectations = DDAFixtureExpectations();
+
+	FixtureBuffer buffer;
+	std::mt19937 random(static_cast<uint32_t>(gameFile) + 1);
+	const DDAFixtureProfile profile = GetProfile(gameFile, scale);
+
+	switch (GetFixtureFileType(gameFile))
+	{
+	case DDAGameFileType::MAP:
+	case DDAGameFileType::CAR:
+		GenerateMapFile(buffer, random, gameFile, profile, expectations);
+		break;
+	case DDAGameFileType::SPRITES:
+		GenerateSpritesFile(buffer, random, profile, expectations);
+		break;
+	case DDAGameFileType::IN_GAME:
+		GenerateInGameFile(buffer, random, profile, expectations);
+		break;
+	case DDAGameFileType::MENU:
+		GenerateMenuFile(buffer, random, gameFile, profile, expectations);
+		break;
+	default:
+		break;
+	}
+
+	expectations.fileSize = buffer.GetSize();
+	return std::move(buffer.GetData());
+}
+
+bool DDAFixtureGenerator::GenerateFile(const std::string& outputFolder, DDAGameFile gameFile, float scale, DDAFixtureExpectations& expectations)
+{
+	const std::vector<uint8_t> fileData = GenerateFileData(gameFile, scale, expectations);
+	if (fileData.empty())
+	{
+		std::cout << "[ERROR] Cannot generate: " + filesNames[(int)gameFile] << std::endl;
+		return false;
+	}
+
+	const std::string filePath = outputFolder + filesNames[(int)gameFile];
+	std::error_code error;
+	std::filesystem::create_directories(std::filesystem::path(filePath).parent_path(), error);
+
+	std::ofstream fileStream(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!fileStream.is_open())
+	{
+		std::cout << "[ERROR] File not created: " + filePath << std::endl;
+		return false;
+	}
+	fileStream.write(reinterpret_cast<const char*>(fileData.data()), fileData.size());
+
+	return fileStream.good();
+}
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <cstdint>
+
+#include "dda_structures.h"
+
+// Size of a generated file, a scale of 1 gives about the same texture and mesh count as the game file
+struct DDAFixtureProfile
+{
+	size_t textureCount = 0;
+	size_t meshPacketCount = 0;
+};
+
+// What the parser should find in a generated file
+struct DDAFixtureExpectations
+{
+	size_t fileSize = 0;
+	size_t textureCount = 0; // Texture table entries or menu texture headers
+	size_t meshPacketCount = 0;
+	size_t mipmapLevelCount = 0; // Levels under the first level, summed for all textures
+	size_t frameCount = 0; // Frames of the animated textures, summed
+	size_t alternatePaletteCount = 0; // Palettes after the first one (not the car skin palettes), summed
+	size_t firstFrameTextureCount = 0; // First frame textures of the animated textures repeated by a mesh
+};
+
+/**
+* @brief Generate fake game files with the same structure as the real ones (texture tables, swizzled palettes, VIF packets...)
+* @brief Used to test and benchmark the extractor without the game data
+*/
+class DDAFixtureGenerator
+{
+public:
+	/**
+	* @brief Write one file, the path is the same as in the game folder (TRACKS, SOLOCARS, FLASH folders...)
+	* @param scale Multiplies the texture and mesh count of the file
+	* @param expectations Filled with what the parser should find in the file
+	*/
+	bool GenerateFile(const std::string& outputFolder, DDAGameFile gameFile, float scale, DDAFixtureExpectations& expectations);
+
+	/**
+	* @brief Generate the content of a file in memory, the same file is generated for the same game file and scale
+	*/
+	std::vector<uint8_t> GenerateFileData(DDAGameFile gameFile, float scale, DDAFixtureExpectations& expectations);
+
+	/**
+	* @brief Get the list of files that can be generated
+	*/
+	static std::vector<DDAGameFile> GetSupportedFiles();
+
+	static DDAFixtureProfile GetProfile(DDAGameFile gameFile, float scale);
+};
@@ -0,0 +1,62 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "frame_table_writer.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "json_utils.h"
+
+namespace
+{
+	std::string GetFileName(const std::string& filePath)
+	{
+		const size_t separatorPosition = filePath.find_last_of("\\/");
+		return separatorPosition == std::string::npos ? filePath : filePath.substr(separatorPosition + 1);
+	}
+}
+
+bool FrameTableWriter::Write(const DDATextureCopyParams& textureCopyParams, const std::vector<std::string>& textureFilePaths, const std::string& filePath)
+{
+	std::ofstream file(filePath, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	const size_t frameWidth = textureCopyParams.exportWidth;
+	const size_t frameHeight = textureCopyParams.exportHeight / std::max<size_t>(textureCopyParams.frameCount, 1);
+
+	file << "{\n";
+	file << "\t\"texture\": \"" << JsonUtils::EscapeString(textureCopyParams.textureName) << "\",\n";
+	file << "\t\"files\": [";
+	for (size_t i = 0; i < textureFilePaths.size(); i++)
+	{
+		file << (i == 0 ? " \"" : ", \"") << JsonUtils::EscapeString(GetFileName(textureFilePaths[i])) << "\"";
+	}
+	file << " ],\n";
+	file << "\t\"sheet_width\": " << textureCopyParams.exportWidth << ",\n";
+	file << "\t\"sheet_height\": " << textureCopyParams.exportHeight << ",\n";
+	file << "\t\"frame_width\": " << frameWidth << ",\n";
+	file << "\t\"frame_height\": " << frameHeight << ",\n";
+	file << "\t\"frames\": [";
+	for (size_t frameIndex = 0; frameIndex < textureCopyParams.frameCount; frameIndex++)
+	{
+		file << (frameIndex == 0 ? "\n" : ",\n");
+		file << "\t\t{ \"x\": 0, \"y\": " << frameIndex * frameHeight << ", \"width\": " << frameWidth << ", \"height\": " << frameHeight << " }";
+	}
+	file << "\n\t]\n";
+	file << "}\n";
+
+	return file.good();
+}
+
+std::string FrameTableWriter::GetFilePath(const std::string& textureFilePath)
+{
+	const size_t extensionPosition = std::min(textureFilePath.find_last_of('.'), textureFilePath.size());
+	return textureFilePath.substr(0, extensionPosition) + ".frames.json";
+}
@@ -0,0 +1,31 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "dda_structures.h"
+
+/**
+* @brief Write the frame table of an animated texture, the texture files are sheets with the frames from top to bottom
+*/
+class FrameTableWriter
+{
+public:
+	/**
+	* @brief Write the position and size of each frame in a JSON file
+	* @param textureFilePaths Files of the texture, one per palette (see TextureDumper::GetPaletteFilePaths), the file names are written in the table
+	* @return False if the file cannot be written
+	*/
+	static bool Write(const DDATextureCopyParams& textureCopyParams, const std::vector<std::string>& textureFilePaths, const std::string& filePath);
+
+	/**
+	* @brief Get the path of the frame table of a texture file: "name.frames.json" for "name.png"
+	*/
+	static std::string GetFilePath(const std::string& textureFilePath);
+};
@@ -0,0 +1,415 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "glb_exporter.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "extraction_stats.h"
+#include "json_utils.h"
+#include "trace_recorder.h"
+
+static_assert(sizeof(DDAVector3) == sizeof(float) * 3, "Positions are written directly in the glb buffer");
+static_assert(sizeof(DDAVector2) == sizeof(float) * 2, "UVs are written directly in the glb buffer");
+
+namespace
+{
+	constexpr uint32_t GLB_MAGIC = 0x46546C67; // "glTF"
+	constexpr uint32_t GLB_VERSION = 2;
+	constexpr uint32_t GLB_CHUNK_JSON = 0x4E4F534A; // "JSON"
+	constexpr uint32_t GLB_CHUNK_BIN = 0x004E4942; // "BIN"
+	constexpr uint32_t GLB_HEADER_SIZE = 12;
+	constexpr uint32_t GLB_CHUNK_HEADER_SIZE = 8;
+
+	// glTF constants
+	constexpr int GL_ARRAY_BUFFER = 34962;
+	constexpr int GL_FLOAT = 5126;
+	constexpr int GL_UNSIGNED_BYTE = 5121;
+	constexpr int GL_TRIANGLES = 4;
+
+	enum class DDAGlbAttribute
+	{
+		POSITION,
+		TEXCOORD,
+		NORMAL,
+		COLOR,
+	};
+
+	// A part of the binary chunk, written in the same order as the buffer views
+	struct DDAGlbBufferPart
+	{
+		const DDASubMesh* subMesh = nullptr;
+		DDAGlbAttribute attribute = DDAGlbAttribute::POSITION;
+		uint32_t vertexCount = 0;
+	};
+
+	uint32_t GetAttributeSize(DDAGlbAttribute attribute)
+	{
+		switch (attribute)
+		{
+		case DDAGlbAttribute::POSITION:
+		case DDAGlbAttribute::NORMAL:
+			return sizeof(float) * 3;
+		case DDAGlbAttribute::TEXCOORD:
+			return sizeof(float) * 2;
+		case DDAGlbAttribute::COLOR:
+			return sizeof(uint8_t) * 4;
+		}
+		return 0;
+	}
+
+	void AppendFloat(std::string& json, float value)
+	{
+		char text[32];
+		snprintf(text, sizeof(text), "%.9g", value);
+		json += text;
+	}
+
+	/**
+	* @brief Encode a file path for the uri of an image ("my texture.png" -> "my%20texture.png"), '/' separates the folders
+	*/
+	std::string EncodeUri(const std::string& text)
+	{
+		const char digits[] = "0123456789ABCDEF";
+		std::string encodedText;
+		for (const char c : text)
+		{
+			const uint8_t byte = static_cast<uint8_t>(c);
+			if (isalnum(byte) || c == '-' || c == '_' || c == '.' || c == '~' || c == '/')
+			{
+				encodedText += c;
+			}
+			else
+			{
+				encodedText += '%';
+				encodedText += digits[byte >> 4];
+				encodedText += digits[byte & 0xF];
+			}
+		}
+		return encodedText;
+	}
+
+	/**
+	* @brief Add an accessor and its buffer view to the json, return the accessor index
+	*/
+	uint32_t AddAccessor(std::string& accessorsJson, std::string& bufferViewsJson, uint32_t& accessorCount, uint32_t& bufferOffset, DDAGlbAttribute attribute, uint32_t vertexCount)
+	{
+		const uint32_t byteLength = GetAttributeSize(attribute) * vertexCount;
+
+		bufferViewsJson += accessorCount == 0 ? "" : ",";
+		bufferViewsJson += "{\"buffer\":0,\"byteOffset\":" + std::to_string(bufferOffset) + ",\"byteLength\":" + std::to_string(byteLength) + ",\"target\":" + std::to_string(GL_ARRAY_BUFFER) + "}";
+
+		accessorsJson += accessorCount == 0 ? "" : ",";
+		accessorsJson += "{\"bufferView\":" + std::to_string(accessorCount) + ",\"count\":" + std::to_string(vertexCount);
+		switch (attribute)
+		{
+		case DDAGlbAttribute::POSITION:
+		case DDAGlbAttribute::NORMAL:
+			accessorsJson += ",\"componentType\":" + std::to_string(GL_FLOAT) + ",\"type\":\"VEC3\"";
+			break;
+		case DDAGlbAttribute::TEXCOORD:
+			accessorsJson += ",\"componentType\":" + std::to_string(GL_FLOAT) + ",\"type\":\"VEC2\"";
+			break;
+		case DDAGlbAttribute::COLOR:
+			accessorsJson += ",\"componentType\":" + std::to_string(GL_UNSIGNED_BYTE) + ",\"normalized\":true,\"type\":\"VEC4\"";
+			break;
+		}
+
+		bufferOffset += byteLength;
+		return accessorCount++;
+	}
+
+	/**
+	* @brief Add the bounds of the positions to the last accessor, they are required by glTF
+	*/
+	void AddPositionBounds(std::string& accessorsJson, const std::vector<DDAVector3>& positions, uint32_t vertexCount)
+	{
+		float minimum[3] = { 0, 0, 0 };
+		float maximum[3] = { 0, 0, 0 };
+		bool firstPosition = true;
+		for (uint32_t i = 0; i < vertexCount; i++)
+		{
+			const float position[3] = { positions[i].x, positions[i].y, positions[i].z };
+			if (!std::isfinite(position[0]) || !std::isfinite(position[1]) || !std::isfinite(position[2]))
+			{
+				continue;
+			}
+
+			for (int axis = 0; axis < 3; axis++)
+			{
+				minimum[axis] = firstPosition ? position[axis] : std::min(minimum[axis], position[axis]);
+				maximum[axis] = firstPosition ? position[axis] : std::max(maximum[axis], position[axis]);
+			}
+			firstPosition = false;
+		}
+
+		accessorsJson += ",\"min\":[";
+		for (int axis = 0; axis < 3; axis++)
+		{
+			accessorsJson += axis == 0 ? "" : ",";
+			AppendFloat(accessorsJson, minimum[axis]);
+		}
+		accessorsJson += "],\"max\":[";
+		for (int axis = 0; axis < 3; axis++)
+		{
+			accessorsJson += axis == 0 ? "" : ",";
+			AppendFloat(accessorsJson, maximum[axis]);
+		}
+		accessorsJson += "]";
+	}
+
+	/**
+	* @brief Write a part of the binary chunk, conversionBuffer is reused between parts to avoid allocations
+	*/
+	void WriteBufferPart(std::ofstream& file, const DDAGlbBufferPart& part, std::vector<uint8_t>& conversionBuffer)
+	{
+		const DDASubMesh& subMesh = *part.subMesh;
+		switch (part.attribute)
+		{
+		case DDAGlbAttribute::POSITION:
+			file.write(reinterpret_cast<const char*>(subMesh.verticesPositions.data()), sizeof(DDAVector3) * part.vertexCount);
+			break;
+		case DDAGlbAttribute::TEXCOORD:
+			// The UVs are already in the glTF convention (origin at the top left)
+			file.write(reinterpret_cast<const char*>(subMesh.verticesUVs.data()), sizeof(DDAVector2) * part.vertexCount);
+			break;
+		case DDAGlbAttribute::NORMAL:
+		{
+			// glTF needs unit normals
+			conversionBuffer.resize(sizeof(float) * 3 * part.vertexCount);
+			float* normals = reinterpret_cast<float*>(conversionBuffer.data());
+			for (uint32_t i = 0; i < part.vertexCount; i++)
+			{
+				const DDAVector3& normal = subMesh.verticesNormals[i];
+				const float length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+				if (length > 0)
+				{
+					normals[i * 3 + 0] = normal.x / length;
+					normals[i * 3 + 1] = normal.y / length;
+					normals[i * 3 + 2] = normal.z / length;
+				}
+				else
+				{
+					normals[i * 3 + 0] = 0;
+					normals[i * 3 + 1] = 0;
+					normals[i * 3 + 2] = 1;
+				}
+			}
+			file.write(reinterpret_cast<const char*>(conversionBuffer.data()), conversionBuffer.size());
+			break;
+		}
+		case DDAGlbAttribute::COLOR:
+		{
+			// Colors can be brighter than 1 (see MeshGenerator), glTF colors are between 0 and 1
+			conversionBuffer.resize(sizeof(uint8_t) * 4 * part.vertexCount);
+			for (uint32_t i = 0; i < part.vertexCount; i++)
+			{
+				const DDAColor& color = subMesh.verticesColors[i];
+				const float channels[4] = { color.r, color.g, color.b, color.a };
+				for (int channel = 0; channel < 4; channel++)
+				{
+					conversionBuffer[i * 4 + channel] = static_cast<uint8_t>(std::clamp(channels[channel], 0.0f, 1.0f) * 255.0f + 0.5f);
+				}
+			}
+			file.write(reinterpret_cast<const char*>(conversionBuffer.data()), conversionBuffer.size());
+			break;
+		}
+		}
+	}
+
+	void WriteUint32(std::ofstream& file, uint32_t value)
+	{
+		file.write(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+}
+
+bool GlbExporter::Export(const std::vector<DDAMesh>& meshes, const std::vector<DDAMaterial>& materials, const std::string& filePath)
+{
+	ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::GLB_EXPORT);
+	TraceRecorder::ScopedEvent traceEvent("GlbExport", filePath);
+
+	// One texture per material, like the fbx export
+	std::string materialsJson;
+	std::string texturesJson;
+	std::string imagesJson;
+	uint32_t materialCount = 0;
+	uint32_t textureCount = 0;
+	for (const DDAMaterial& material : materials)
+	{
+		const std::string separator = materialCount == 0 ? "" : ",";
+
+		// Opaque is the default alpha mode of gltf
+		std::string alphaModeJson;
+		if (material.alphaType == DDAAlphaType::ALPHA_CUTOUT)
+		{
+			alphaModeJson = ",\"alphaMode\":\"MASK\",\"alphaCutoff\":0.5";
+		}
+		else if (material.alphaType == DDAAlphaType::ALPHA_BLEND)
+		{
+			alphaModeJson = ",\"alphaMode\":\"BLEND\"";
+		}
+		// Without a texture file (format not loadable by gltf), the material only has its alpha mode
+		std::string baseColorTextureJson;
+		if (!material.textureFileName.empty())
+		{
+			const std::string textureSeparator = textureCount == 0 ? "" : ",";
+			const std::string index = std::to_string(textureCount);
+			baseColorTextureJson = "\"baseColorTexture\":{\"index\":" + index + "},";
+			texturesJson += textureSeparator + "{\"sampler\":0,\"source\":" + index + "}";
+			imagesJson += textureSeparator + "{\"uri\":\"" + JsonUtils::EscapeString(EncodeUri(material.textureFileName)) + "\"}";
+			textureCount++;
+		}
+		materialsJson += separator + "{\"name\":\"" + JsonUtils::EscapeString(material.name) + "\",\"pbrMetallicRoughness\":{" + baseColorTextureJson + "\"metallicFactor\":0,\"roughnessFactor\":1}" + alphaModeJson + "}";
+		materialCount++;
+	}
+
+	// Describe the binary chunk, the data is written after the json
+	std::vector<DDAGlbBufferPart> bufferParts;
+	std::string meshesJson;
+	std::string nodesJson;
+	std::string accessorsJson;
+	std::string bufferViewsJson;
+	uint32_t meshCount = 0;
+	uint32_t accessorCount = 0;
+	uint32_t bufferSize = 0;
+	for (const DDAMesh& ddaMesh : meshes)
+	{
+		std::string primitivesJson;
+		for (const DDASubMesh& ddaSubMesh : ddaMesh.subMeshes)
+		{
+			// Only whole triangles, there is no index buffer
+			uint32_t vertexCount = static_cast<uint32_t>(ddaSubMesh.verticesPositions.size());
+			vertexCount -= vertexCount % 3;
+			if (vertexCount == 0)
+			{
+				continue;
+			}
+
+			std::string attributesJson = "\"POSITION\":" + std::to_string(accessorCount);
+			AddAccessor(accessorsJson, bufferViewsJson, accessorCount, bufferSize, DDAGlbAttribute::POSITION, vertexCount);
+			AddPositionBounds(accessorsJson, ddaSubMesh.verticesPositions, vertexCount);
+			accessorsJson += "}";
+			bufferParts.push_back({ &ddaSubMesh, DDAGlbAttribute::POSITION, vertexCount });
+
+			const std::pair<DDAGlbAttribute, size_t> optionalAttributes[] =
+			{
+				{ DDAGlbAttribute::TEXCOORD, ddaSubMesh.verticesUVs.size() },
+				{ DDAGlbAttribute::NORMAL, ddaSubMesh.verticesNormals.size() },
+				{ DDAGlbAttribute::COLOR, ddaSubMesh.verticesColors.size() },
+			};
+			const char* attributeNames[] = { "TEXCOORD_0", "NORMAL", "COLOR_0" };
+			for (int i = 0; i < 3; i++)
+			{
+				if (optionalAttributes[i].second < vertexCount)
+				{
+					continue;
+				}
+				attributesJson += std::string(",\"") + attributeNames[i] + "\":" + std::to_string(accessorCount);
+				AddAccessor(accessorsJson, bufferViewsJson, accessorCount, bufferSize, optionalAttributes[i].first, vertexCount);
+				accessorsJson += "}";
+				bufferParts.push_back({ &ddaSubMesh, optionalAttributes[i].first, vertexCount });
+			}
+
+			primitivesJson += primitivesJson.empty() ? "" : ",";
+			primitivesJson += "{\"attributes\":{" + attributesJson + "},\"mode\":" + std::to_string(GL_TRIANGLES);
+			if (materialCount != 0)
+			{
+				const uint32_t materialIndex = ddaSubMesh.materialIndex < materialCount ? ddaSubMesh.materialIndex : 0;
+				primitivesJson += ",\"material\":" + std::to_string(materialIndex);
+			}
+			primitivesJson += "}";
+		}
+
+		if (primitivesJson.empty())
+		{
+			continue;
+		}
+
+		const std::string separator = meshCount == 0 ? "" : ",";
+		meshesJson += separator + "{\"primitives\":[" + primitivesJson + "]}";
+		nodesJson += separator + "{\"name\":\"Mesh_" + std::to_string(meshCount) + "\",\"mesh\":" + std::to_string(meshCount) + "}";
+		meshCount++;
+	}
+
+	std::string json = "{\"asset\":{\"version\":\"2.0\",\"generator\":\"DDA Extractor\"}";
+	if (meshCount != 0)
+	{
+		std::string sceneNodesJson;
+		for (uint32_t i = 0; i < meshCount; i++)
+		{
+			sceneNodesJson += (i == 0 ? "" : ",") + std::to_string(i);
+		}
+		json += ",\"scene\":0,\"scenes\":[{\"nodes\":[" + sceneNodesJson + "]}]";
+		json += ",\"nodes\":[" + nodesJson + "]";
+		json += ",\"meshes\":[" + meshesJson + "]";
+		json += ",\"accessors\":[" + accessorsJson + "]";
+		json += ",\"bufferViews\":[" + bufferViewsJson + "]";
+		json += ",\"buffers\":[{\"byteLength\":" + std::to_string(bufferSize) + "}]";
+	}
+	if (materialCount != 0)
+	{
+		json += ",\"materials\":[" + materialsJson + "]";
+	}
+	if (textureCount != 0)
+	{
+		json += ",\"textures\":[" + texturesJson + "]";
+		json += ",\"images\":[" + imagesJson + "]";
+		json += ",\"samplers\":[{}]";
+	}
+	json += "}";
+
+	// Chunks are aligned on 4 bytes, the json is padded with spaces
+	while (json.size() % 4 != 0)
+	{
+		json += ' ';
+	}
+
+	const uint32_t jsonChunkSize = static_cast<uint32_t>(json.size());
+	const bool hasBinaryChunk = bufferSize != 0;
+	const uint32_t fileSize = GLB_HEADER_SIZE + GLB_CHUNK_HEADER_SIZE + jsonChunkSize + (hasBinaryChunk ? GLB_CHUNK_HEADER_SIZE + bufferSize : 0);
+
+	std::ofstream file(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << ("[ERROR] File not created: " + filePath + "\n") << std::flush;
+		return false;
+	}
+
+	WriteUint32(file, GLB_MAGIC);
+	WriteUint32(file, GLB_VERSION);
+	WriteUint32(file, fileSize);
+
+	WriteUint32(file, jsonChunkSize);
+	WriteUint32(file, GLB_CHUNK_JSON);
+	file.write(json.data(), json.size());
+
+	// All attribute sizes are multiples of 4 bytes, no padding is needed
+	if (hasBinaryChunk)
+	{
+		WriteUint32(file, bufferSize);
+		WriteUint32(file, GLB_CHUNK_BIN);
+		std::vector<uint8_t> conversionBuffer;
+		for (const DDAGlbBufferPart& part : bufferParts)
+		{
+			WriteBufferPart(file, part, conversionBuffer);
+		}
+	}
+
+	file.close();
+	if (!file)
+	{
+		std::cout << ("[ERROR] Failed to write file: " + filePath + "\n") << std::flush;
+		return false;
+	}
+
+	ExtractionStats::AddCounter(DDAStatsCounter::BYTES_WRITTEN, fileSize);
+	return true;
+}
@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "dda_structures.h"
+
+/**
+* @brief Write meshes in a binary glTF 2.0 file (.glb) without Assimp
+*/
+class GlbExporter
+{
+public:
+	/**
+	* @brief Export the meshes in a glb file with their materials (see DDAExtractedData::materials), the textures are files next to the glb file
+	* @brief Positions and UVs are written directly from the meshes, normals and colors are converted to the glTF formats
+	* @return False if the file cannot be written
+	*/
+	static bool Export(const std::vector<DDAMesh>& meshes, const std::vector<DDAMaterial>& materials, const std::string& filePath);
+};
@@ -0,0 +1,46 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "json_utils.h"
+
+std::string JsonUtils::EscapeString(const std::string& text)
+{
+	std::string escapedText;
+	escapedText.reserve(text.size());
+	for (const char c : text)
+	{
+		const unsigned char character = static_cast<unsigned char>(c);
+		if (c == '\\' || c == '"')
+		{
+			escapedText += '\\';
+			escapedText += c;
+		}
+		else if (c == '\n')
+		{
+			escapedText += "\\n";
+		}
+		else if (c == '\r')
+		{
+			escapedText += "\\r";
+		}
+		else if (c == '\t')
+		{
+			escapedText += "\\t";
+		}
+		else if (character < 0x20)
+		{
+			const char* hexDigits = "0123456789abcdef";
+			escapedText += "\\u00";
+			escapedText += hexDigits[character >> 4];
+			escapedText += hexDigits[character & 0x0f];
+		}
+		else
+		{
+			escapedText += c;
+		}
+	}
+	return escapedText;
+}
@@ -0,0 +1,21 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+
+/**
+* @brief Helpers shared by the JSON files written by the extractor (manifest, stats, trace, gltf...)
+*/
+class JsonUtils
+{
+public:
+	/**
+	* @brief Escape a text to write it between quotes: '"', '\' and the control characters
+	*/
+	static std::string EscapeString(const std::string& text);
+};
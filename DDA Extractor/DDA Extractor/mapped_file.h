@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+/**
+* @brief Read only view of a whole file mapped in memory
+* @brief The data is shared with the OS page cache, so nothing is copied and several workers reading the same file share the same memory
+*/
+class MappedFile
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+	MappedFile(MappedFile&& other) noexcept;
+	MappedFile& operator=(MappedFile&& other) noexcept;
+
+	/**
+	* @brief Map a file in memory, the previous mapped file is closed
+	* @return True if the file has been mapped
+	*/
+	bool Open(const std::string& filePath);
+	void Close();
+
+	const uint8_t* GetData() const { return m_data; }
+	size_t GetSize() const { return m_size; }
+	bool IsOpen() const { return m_data != nullptr; }
+
+private:
+	const uint8_t* m_data = nullptr;
+	size_t m_size = 0;
+#if defined(_WIN32)
+	void* m_fileHandle = nullptr;
+	void* m_mappingHandle = nullptr;
+#endif
+};
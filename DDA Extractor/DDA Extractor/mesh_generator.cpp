@@ -8,6 +8,9 @@
 
 #include <iostream>
 
+#include "extraction_stats.h"
+#include "trace_recorder.h"
+
 DDAVector3 MeshGenerator::GetMeshCenter(const uint8_t* posPart0, const uint8_t* posPart1)
 {
 	const DDAVector3 positionA = DDAVector3(*((float*)(posPart0)+0), *((float*)(posPart0)+1), *((float*)(posPart0)+2));
@@ -45,16 +48,18 @@ float MeshGenerator::ShortToFloat(const uint8_t* data)
 	return v / std::powf(2, 8);
 }
 
-DDAMesh MeshGenerator::GenerateMeshFromVifPacket(const DDAFileMeshDataInfo& vifPacket, const std::vector<DDAPacketAndTextureEntry>& packetAndTextureEntryList, const std::unique_ptr<uint8_t[]>& fileData, DDAGameFileType fileType)
+DDAMesh MeshGenerator::GenerateMeshFromVifPacket(const DDAFileMeshDataInfo& vifPacket, const std::vector<DDAPacketAndTextureEntry>& packetAndTextureEntryList, const uint8_t* fileData, DDAGameFileType fileType)
 {
+	TraceRecorder::ScopedEvent traceEvent("GenerateMeshFromVifPacket");
+
 	float uvDiviserX = 16;
 	float uvDiviserY = 16;
 	float uvOffset = 0;
 
 	DDAMesh mesh;
 
-	const uint8_t* meshScaleData = (uint8_t*)fileData.get() + vifPacket.meshPositionAndSizeA;
-	const uint8_t* boundingBoxData = (uint8_t*)fileData.get() + vifPacket.meshPositionB;
+	const uint8_t* meshScaleData = (uint8_t*)fileData + vifPacket.meshPositionAndSizeA;
+	const uint8_t* boundingBoxData = (uint8_t*)fileData + vifPacket.meshPositionB;
 
 	// Get mesh position and scale
 	const uint8_t scaleMultiplierX = *((uint8_t*)(meshScaleData)+2);
@@ -70,10 +75,10 @@ DDAMesh MeshGenerator::GenerateMeshFromVifPacket(const DDAFileMeshDataInfo& vifP
 	// ------------------------------------------------------ Read mesh vertices data
 
 	// Get pointers to the data
-	const uint8_t* verticesPosData = (uint8_t*)fileData.get() + vifPacket.verticesPositionLocation;
-	const uint8_t* uvdata = (uint8_t*)fileData.get() + vifPacket.uvPositionLocation;
-	const uint8_t* colordata = (uint8_t*)fileData.get() + vifPacket.verticesColorsLocation;
-	const uint8_t* normalData = (uint8_t*)fileData.get() + vifPacket.verticesColorsLocation;
+	const uint8_t* verticesPosData = (uint8_t*)fileData + vifPacket.verticesPositionLocation;
+	const uint8_t* uvdata = (uint8_t*)fileData + vifPacket.uvPositionLocation;
+	const uint8_t* colordata = (uint8_t*)fileData + vifPacket.verticesColorsLocation;
+	const uint8_t* normalData = (uint8_t*)fileData + vifPacket.verticesColorsLocation;
 
 	std::vector<DDAVector3> verticesPositions;
 	std::vector<DDAVector2> verticesUVs;
@@ -242,7 +247,7 @@ DDAMesh MeshGenerator::GenerateMeshFromVifPacket(const DDAFileMeshDataInfo& vifP
 /**
 * @brief Create a list of all mesh data packets
 */
-std::vector<DDAFileMeshDataInfo> MeshGenerator::GetMeshDataInfos(DDAGameFileType fileType, const std::unique_ptr<uint8_t[]>& fileData, const std::vector<DDAPacketAndTextureEntry>& packetAndTextureEntryList, bool enableLogging)
+std::vector<DDAFileMeshDataInfo> MeshGenerator::GetMeshDataInfos(DDAGameFileType fileType, const uint8_t* fileData, const std::vector<DDAPacketAndTextureEntry>& packetAndTextureEntryList, bool enableLogging)
 {
 	std::vector<DDAFileMeshDataInfo> list;
 
@@ -252,7 +257,7 @@ std::vector<DDAFileMeshDataInfo> MeshGenerator::GetMeshDataInfos(DDAGameFileType
 	// Each parent packet, contains a list of small mesh packets
 	for (size_t packetIndex = 0; packetIndex < packetAndTextureEntryListCount; packetIndex++)
 	{
-		const uint16_t bigPacketSize = *(uint16_t*)(fileData.get() + packetAndTextureEntryList[packetIndex].vifPacketListAddr + GetHeaderOffset(fileType)) * 16; // Size in bytes
+		const uint16_t bigPacketSize = *(uint16_t*)(fileData + packetAndTextureEntryList[packetIndex].vifPacketListAddr + GetHeaderOffset(fileType)) * 16; // Size in bytes
 		const uint32_t packetStart = packetAndTextureEntryList[packetIndex].vifPacketListAddr + GetHeaderOffset(fileType);
 		const uint32_t packetEnd = packetStart + bigPacketSize;
 
@@ -445,6 +450,8 @@ std::vector<DDAFileMeshDataInfo> MeshGenerator::GetMeshDataInfos(DDAGameFileType
 		std::cout << "Abort count: " + std::to_string(abortCount) << std::endl;
 		std::cout << "Found packet count: " + std::to_string(list.size()) << std::endl;
 	}
+	ExtractionStats::AddCounter(DDAStatsCounter::PACKETS_FOUND, list.size());
+	ExtractionStats::AddCounter(DDAStatsCounter::PACKETS_ABORTED, abortCount);
 
 	return list;
 }
@@ -13,8 +13,8 @@
 class MeshGenerator
 {
 public:
-	DDAMesh GenerateMeshFromVifPacket(const DDAFileMeshDataInfo& vifPacket, const std::vector<DDAPacketAndTextureEntry>& packetAndTextureEntryList, const std::unique_ptr<uint8_t[]>& fileData, DDAGameFileType fileType);
-	std::vector<DDAFileMeshDataInfo> GetMeshDataInfos(DDAGameFileType fileType, const std::unique_ptr<uint8_t[]>& fileData, const std::vector<DDAPacketAndTextureEntry>& packetAndTextureEntryList, bool enableLogging);
+	DDAMesh GenerateMeshFromVifPacket(const DDAFileMeshDataInfo& vifPacket, const std::vector<DDAPacketAndTextureEntry>& packetAndTextureEntryList, const uint8_t* fileData, DDAGameFileType fileType);
+	std::vector<DDAFileMeshDataInfo> GetMeshDataInfos(DDAGameFileType fileType, const uint8_t* fileData, const std::vector<DDAPacketAndTextureEntry>& packetAndTextureEntryList, bool enableLogging);
 
 private:
 	DDAVector3 GetMeshCenter(const uint8_t* posPart0, const uint8_t* posPart1);
@@ -0,0 +1,352 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "png_writer.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+#include "deflate_encoder.h"
+#include "worker_pool.h"
+
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+namespace
+{
+	constexpr uint8_t PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+	constexpr uint8_t PNG_COLOR_TYPE_PALETTE = 3;
+	constexpr uint8_t PNG_COLOR_TYPE_RGBA = 6;
+	constexpr int ZLIB_QUALITY = 8; // Same as stbi_write_png
+
+	// Images are compressed in parts of this size, each part can be compressed by a different thread
+	// The size does not depend on the thread count, so the files are the same whatever the thread count is
+	constexpr size_t COMPRESSION_PART_SIZE = 256 * 1024;
+
+	enum class DDAPngFilter : uint8_t
+	{
+		NONE = 0,
+		SUB = 1,
+		UP = 2,
+		AVERAGE = 3,
+		PAETH = 4,
+	};
+
+	struct CrcTable
+	{
+		uint32_t values[256];
+
+		CrcTable()
+		{
+			for (uint32_t i = 0; i < 256; i++)
+			{
+				uint32_t crc = i;
+				for (int bit = 0; bit < 8; bit++)
+				{
+					crc = (crc & 1) ? 0xEDB88320 ^ (crc >> 1) : crc >> 1;
+				}
+				values[i] = crc;
+			}
+		}
+	};
+
+	uint32_t Crc32(uint32_t crc, const uint8_t* data, size_t size)
+	{
+		static const CrcTable crcTable;
+		for (size_t i = 0; i < size; i++)
+		{
+			crc = crcTable.values[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+		}
+		return crc;
+	}
+
+	void AppendUint32BigEndian(std::vector<uint8_t>& buffer, uint32_t value)
+	{
+		buffer.push_back(static_cast<uint8_t>(value >> 24));
+		buffer.push_back(static_cast<uint8_t>(value >> 16));
+		buffer.push_back(static_cast<uint8_t>(value >> 8));
+		buffer.push_back(static_cast<uint8_t>(value));
+	}
+
+	/**
+	* @brief Add a chunk (size, type, data and crc) to the file content
+	*/
+	void AppendChunk(std::vector<uint8_t>& buffer, const char type[4], const uint8_t* data, size_t size)
+	{
+		AppendUint32BigEndian(buffer, static_cast<uint32_t>(size));
+		const size_t typePosition = buffer.size();
+		buffer.insert(buffer.end(), type, type + 4);
+		buffer.insert(buffer.end(), data, data + size);
+		const uint32_t crc = Crc32(0xFFFFFFFF, buffer.data() + typePosition, size + 4) ^ 0xFFFFFFFF;
+		AppendUint32BigEndian(buffer, crc);
+	}
+
+	uint8_t PaethPredictor(int left, int up, int upLeft)
+	{
+		const int prediction = left + up - upLeft;
+		const int leftDistance = abs(prediction - left);
+		const int upDistance = abs(prediction - up);
+		const int upLeftDistance = abs(prediction - upLeft);
+		if (leftDistance <= upDistance && leftDistance <= upLeftDistance)
+		{
+			return static_cast<uint8_t>(left);
+		}
+		return static_cast<uint8_t>(upDistance <= upLeftDistance ? up : upLeft);
+	}
+
+	/**
+	* @brief Apply a filter to a row
+	* @param previousRow Row above, nullptr for the first row
+	*/
+	void FilterRow(DDAPngFilter filter, const uint8_t* row, const uint8_t* previousRow, size_t rowSize, size_t bytesPerPixel, uint8_t* output)
+	{
+		switch (filter)
+		{
+		case DDAPngFilter::NONE:
+			memcpy(output, row, rowSize);
+			break;
+		case DDAPngFilter::SUB:
+			memcpy(output, row, std::min(bytesPerPixel, rowSize));
+			for (size_t i = bytesPerPixel; i < rowSize; i++)
+			{
+				output[i] = static_cast<uint8_t>(row[i] - row[i - bytesPerPixel]);
+			}
+			break;
+		case DDAPngFilter::UP:
+			for (size_t i = 0; i < rowSize; i++)
+			{
+				output[i] = static_cast<uint8_t>(row[i] - (previousRow ? previousRow[i] : 0));
+			}
+			break;
+		case DDAPngFilter::AVERAGE:
+			for (size_t i = 0; i < rowSize; i++)
+			{
+				const int left = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+				const int up = previousRow ? previousRow[i] : 0;
+				output[i] = static_cast<uint8_t>(row[i] - ((left + up) >> 1));
+			}
+			break;
+		case DDAPngFilter::PAETH:
+			for (size_t i = 0; i < rowSize; i++)
+			{
+				const int left = i >= bytesPerPixel ? row[i - bytesPerPixel] : 0;
+				const int up = previousRow ? previousRow[i] : 0;
+				const int upLeft = previousRow && i >= bytesPerPixel ? previousRow[i - bytesPerPixel] : 0;
+				output[i] = static_cast<uint8_t>(row[i] - PaethPredictor(left, up, upLeft));
+			}
+			break;
+		}
+	}
+
+	/**
+	* @brief Estimate how well a filtered row will be compressed, lower is better
+	*/
+	uint64_t GetFilterScore(const uint8_t* filteredRow, size_t rowSize)
+	{
+		uint64_t score = 0;
+		for (size_t i = 0; i < rowSize; i++)
+		{
+			score += static_cast<uint64_t>(abs(static_cast<int8_t>(filteredRow[i])));
+		}
+		return score;
+	}
+}
+
+bool PngWriter::WriteRgba(const std::string& filePath, const uint8_t* pixels, size_t width, size_t height)
+{
+	if (m_compression == DDAPngCompression::DEFAULT)
+	{
+		return stbi_write_png(filePath.c_str(), static_cast<int>(width), static_cast<int>(height), 4, pixels, 0) != 0;
+	}
+
+	const size_t rowSize = width * 4;
+	if (!CompressRows(pixels, rowSize, height, rowSize, 4, false))
+	{
+		return false;
+	}
+	return WriteFile(filePath, width, height, 8, PNG_COLOR_TYPE_RGBA, nullptr, 0);
+}
+
+bool PngWriter::WriteIndexed(const std::string& filePath, const uint8_t* indices, size_t width, size_t height, size_t rowStride, int bitDepth, const uint32_t* palette, size_t colorCount)
+{
+	const size_t rowSize = bitDepth == 4 ? (width + 1) / 2 : width;
+	if (!CompressRows(indices, rowSize, height, rowStride, 0, bitDepth == 4))
+	{
+		return false;
+	}
+	return WriteFile(filePath, width, height, bitDepth, PNG_COLOR_TYPE_PALETTE, palette, colorCount);
+}
+
+bool PngWriter::CompressRows(const uint8_t* rows, size_t rowSize, size_t height, size_t rowStride, size_t bytesPerPixel, bool swapNibbles)
+{
+	// Filters tried on each row, the png specification recommends no filter for palette images
+	std::vector<DDAPngFilter> filters;
+	if (bytesPerPixel == 0 || m_compression == DDAPngCompression::STORED)
+	{
+		filters = { DDAPngFilter::NONE };
+	}
+	else if (m_compression == DDAPngCompression::FAST)
+	{
+		filters = { DDAPngFilter::SUB, DDAPngFilter::UP };
+	}
+	else
+	{
+		filters = { DDAPngFilter::NONE, DDAPngFilter::SUB, DDAPngFilter::UP, DDAPngFilter::AVERAGE, DDAPngFilter::PAETH };
+	}
+
+	// Each row starts with its filter type
+	const size_t scanlineSize = rowSize + 1;
+	m_scanlines.resize(scanlineSize * height);
+	const auto filterRows = [&](size_t firstRow, size_t rowCount)
+		{
+			std::vector<uint8_t> filteredRow(filters.size() > 1 ? rowSize : 0);
+			for (size_t y = firstRow; y < firstRow + rowCount; y++)
+			{
+				uint8_t* scanline = m_scanlines.data() + y * scanlineSize;
+				const uint8_t* row = rows + y * rowStride;
+				const uint8_t* previousRow = y == 0 ? nullptr : row - rowStride;
+				if (swapNibbles)
+				{
+					scanline[0] = static_cast<uint8_t>(DDAPngFilter::NONE);
+					for (size_t i = 0; i < rowSize; i++)
+					{
+						scanline[1 + i] = static_cast<uint8_t>((row[i] << 4) | (row[i] >> 4));
+					}
+					continue;
+				}
+
+				if (filters.size() == 1)
+				{
+					scanline[0] = static_cast<uint8_t>(filters[0]);
+					FilterRow(filters[0], row, previousRow, rowSize, bytesPerPixel, scanline + 1);
+					continue;
+				}
+
+				uint64_t bestScore = UINT64_MAX;
+				for (const DDAPngFilter filter : filters)
+				{
+					FilterRow(filter, row, previousRow, rowSize, bytesPerPixel, filteredRow.data());
+					const uint64_t score = GetFilterScore(filteredRow.data(), rowSize);
+					if (score < bestScore)
+					{
+						bestScore = score;
+						scanline[0] = static_cast<uint8_t>(filter);
+						memcpy(scanline + 1, filteredRow.data(), rowSize);
+					}
+				}
+			}
+		};
+
+	if (m_compression == DDAPngCompression::DEFAULT)
+	{
+		filterRows(0, height);
+		int compressedSize = 0;
+		unsigned char* compressedData = stbi_zlib_compress(m_scanlines.data(), static_cast<int>(m_scanlines.size()), &compressedSize, ZLIB_QUALITY);
+		if (!compressedData)
+		{
+			return false;
+		}
+		m_compressedData.assign(compressedData, compressedData + compressedSize);
+		STBIW_FREE(compressedData);
+		return true;
+	}
+
+	const DDADeflateLevel level = m_compression == DDAPngCompression::STORED ? DDADeflateLevel::STORED :
+		(m_compression == DDAPngCompression::FAST ? DDADeflateLevel::FAST : DDADeflateLevel::MAX);
+
+	// Parts are compressed separately and joined, a match cannot use the data of the previous part
+	const size_t rowsPerPart = std::max<size_t>(COMPRESSION_PART_SIZE / scanlineSize, 1);
+	const size_t partCount = std::max<size_t>((height + rowsPerPart - 1) / rowsPerPart, 1);
+	if (m_compressedParts.size() < partCount)
+	{
+		m_compressedParts.resize(partCount);
+	}
+	WorkerPool::ParallelFor(partCount, m_jobCount, [&](size_t partIndex, size_t /*workerIndex*/)
+		{
+			const size_t firstRow = partIndex * rowsPerPart;
+			const size_t rowCount = std::min(rowsPerPart, height - firstRow);
+			filterRows(firstRow, rowCount);
+
+			std::vector<uint8_t>& compressedPart = m_compressedParts[partIndex];
+			compressedPart.clear();
+			DeflateEncoder::CompressRaw(m_scanlines.data() + firstRow * scanlineSize, rowCount * scanlineSize, level, partIndex == partCount - 1, compressedPart);
+		});
+
+	// zlib header: deflate with a 32KB window, and the compression level
+	m_compressedData.clear();
+	m_compressedData.push_back(0x78);
+	m_compressedData.push_back(level == DDADeflateLevel::MAX ? 0xDA : 0x01);
+	for (size_t partIndex = 0; partIndex < partCount; partIndex++)
+	{
+		m_compressedData.insert(m_compressedData.end(), m_compressedParts[partIndex].begin(), m_compressedParts[partIndex].end());
+	}
+	AppendUint32BigEndian(m_compressedData, DeflateEncoder::Adler32(m_scanlines.data(), m_scanlines.size()));
+
+	return true;
+}
+
+bool PngWriter::WriteFile(const std::string& filePath, size_t width, size_t height, int bitDepth, uint8_t colorType, const uint32_t* palette, size_t colorCount)
+{
+	uint8_t header[13];
+	const uint32_t headerValues[2] = { static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+	for (int i = 0; i < 2; i++)
+	{
+		header[i * 4 + 0] = static_cast<uint8_t>(headerValues[i] >> 24);
+		header[i * 4 + 1] = static_cast<uint8_t>(headerValues[i] >> 16);
+		header[i * 4 + 2] = static_cast<uint8_t>(headerValues[i] >> 8);
+		header[i * 4 + 3] = static_cast<uint8_t>(headerValues[i]);
+	}
+	header[8] = static_cast<uint8_t>(bitDepth);
+	header[9] = colorType;
+	header[10] = 0; // Deflate compression
+	header[11] = 0; // Adaptive filtering
+	header[12] = 0; // No interlace
+
+	m_fileData.clear();
+	m_fileData.insert(m_fileData.end(), PNG_SIGNATURE, PNG_SIGNATURE + sizeof(PNG_SIGNATURE));
+	AppendChunk(m_fileData, "IHDR", header, sizeof(header));
+
+	if (colorType == PNG_COLOR_TYPE_PALETTE)
+	{
+		// Palette colors are stored as RGBA bytes
+		uint8_t paletteColors[256 * 3];
+		uint8_t paletteAlphas[256];
+		size_t alphaCount = 0;
+		for (size_t colorIndex = 0; colorIndex < colorCount; colorIndex++)
+		{
+			uint8_t color[4];
+			memcpy(color, &palette[colorIndex], sizeof(color));
+			memcpy(paletteColors + colorIndex * 3, color, 3);
+			paletteAlphas[colorIndex] = color[3];
+			if (color[3] != 0xFF)
+			{
+				alphaCount = colorIndex + 1;
+			}
+		}
+
+		AppendChunk(m_fileData, "PLTE", paletteColors, colorCount * 3);
+		// Colors after the last transparent color are opaque
+		if (alphaCount != 0)
+		{
+			AppendChunk(m_fileData, "tRNS", paletteAlphas, alphaCount);
+		}
+	}
+
+	AppendChunk(m_fileData, "IDAT", m_compressedData.data(), m_compressedData.size());
+	AppendChunk(m_fileData, "IEND", nullptr, 0);
+
+	std::ofstream file(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << ("[ERROR] File not created: " + filePath + "\n") << std::flush;
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(m_fileData.data()), m_fileData.size());
+	return file.good();
+}
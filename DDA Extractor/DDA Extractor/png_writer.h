@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Compression of the png files
+enum class DDAPngCompression
+{
+	DEFAULT, // stb_image_write, same files as the previous versions
+	STORED, // No compression, for quick iterations
+	FAST, // Quick filter choice and deflate, files are a bit bigger
+	MAX, // Best filter of each row and slow deflate, for release files
+};
+
+/**
+* @brief Encode png files with the compressor chosen by DDAPngCompression
+* @brief Buffers are kept between files, so use one writer per thread
+*/
+class PngWriter
+{
+public:
+	PngWriter() = default;
+
+	/**
+	* @param jobCount Number of threads used to compress the parts of a large image (0 = one per CPU thread), not used by DEFAULT
+	*/
+	explicit PngWriter(DDAPngCompression compression, size_t jobCount = 1)
+		: m_compression(compression), m_jobCount(jobCount) {
+	}
+
+	/**
+	* @brief Write a png file of RGBA pixels
+	* @return False if the file cannot be written
+	*/
+	bool WriteRgba(const std::string& filePath, const uint8_t* pixels, size_t width, size_t height);
+
+	/**
+	* @brief Write a png file of palette indices, with a PLTE chunk and a tRNS chunk if some colors are transparent
+	* @param indices First row of indices, rows are rowStride bytes apart
+	* @param bitDepth 8, or 4 for two pixels per byte (low 4 bits first like on PS2)
+	* @param palette colorCount colors prepared with ClutExpander::PreparePalette
+	* @return False if the file cannot be written
+	*/
+	bool WriteIndexed(const std::string& filePath, const uint8_t* indices, size_t width, size_t height, size_t rowStride, int bitDepth, const uint32_t* palette, size_t colorCount);
+
+private:
+	/**
+	* @brief Filter the rows and compress them in m_compressedData (zlib format)
+	* @param bytesPerPixel 4 for RGBA, 0 for palette indices (the rows are not filtered)
+	* @param swapNibbles True for 4 bits indices, png stores the first pixel in the high 4 bits
+	*/
+	bool CompressRows(const uint8_t* rows, size_t rowSize, size_t height, size_t rowStride, size_t bytesPerPixel, bool swapNibbles);
+
+	/**
+	* @brief Write the png chunks with m_compressedData as image data
+	*/
+	bool WriteFile(const std::string& filePath, size_t width, size_t height, int bitDepth, uint8_t colorType, const uint32_t* palette, size_t colorCount);
+
+	DDAPngCompression m_compression = DDAPngCompression::DEFAULT;
+	size_t m_jobCount = 1;
+	std::vector<uint8_t> m_scanlines;
+	std::vector<std::vector<uint8_t>> m_compressedParts;
+	std::vector<uint8_t> m_compressedData;
+	std::vector<uint8_t> m_fileData;
+};
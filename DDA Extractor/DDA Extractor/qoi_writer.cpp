@@ -0,0 +1,137 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "qoi_writer.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	constexpr size_t QOI_HEADER_SIZE = 14;
+	constexpr uint8_t QOI_END_MARKER[8] = { 0, 0, 0, 0, 0, 0, 0, 1 };
+
+	constexpr uint8_t QOI_OP_INDEX = 0x00;
+	constexpr uint8_t QOI_OP_DIFF = 0x40;
+	constexpr uint8_t QOI_OP_LUMA = 0x80;
+	constexpr uint8_t QOI_OP_RUN = 0xC0;
+	constexpr uint8_t QOI_OP_RGB = 0xFE;
+	constexpr uint8_t QOI_OP_RGBA = 0xFF;
+	constexpr size_t QOI_MAX_RUN = 62;
+
+	void WriteBigEndian32(uint8_t* output, uint32_t value)
+	{
+		output[0] = static_cast<uint8_t>(value >> 24);
+		output[1] = static_cast<uint8_t>(value >> 16);
+		output[2] = static_cast<uint8_t>(value >> 8);
+		output[3] = static_cast<uint8_t>(value);
+	}
+}
+
+bool QoiWriter::WriteRgba(const std::string& filePath, const uint8_t* pixels, size_t width, size_t height)
+{
+	const size_t pixelCount = width * height;
+
+	// Worst case: one QOI_OP_RGBA (5 bytes) per pixel
+	m_fileData.resize(QOI_HEADER_SIZE + pixelCount * 5 + sizeof(QOI_END_MARKER));
+	uint8_t* output = m_fileData.data();
+
+	memcpy(output, "qoif", 4);
+	WriteBigEndian32(output + 4, static_cast<uint32_t>(width));
+	WriteBigEndian32(output + 8, static_cast<uint32_t>(height));
+	output[12] = 4; // RGBA
+	output[13] = 0; // sRGB with linear alpha
+	output += QOI_HEADER_SIZE;
+
+	// Colors are compared as 32 bits values, the bytes are in RGBA order in memory
+	uint32_t seenColors[64] = {};
+	uint8_t previous[4] = { 0, 0, 0, 255 };
+	uint32_t previousColor;
+	memcpy(&previousColor, previous, sizeof(previousColor));
+	size_t run = 0;
+
+	for (size_t pixelIndex = 0; pixelIndex < pixelCount; pixelIndex++)
+	{
+		uint32_t color;
+		memcpy(&color, pixels + pixelIndex * 4, sizeof(color));
+
+		if (color == previousColor)
+		{
+			run++;
+			if (run == QOI_MAX_RUN || pixelIndex == pixelCount - 1)
+			{
+				*output++ = static_cast<uint8_t>(QOI_OP_RUN | (run - 1));
+				run = 0;
+			}
+			continue;
+		}
+
+		if (run != 0)
+		{
+			*output++ = static_cast<uint8_t>(QOI_OP_RUN | (run - 1));
+			run = 0;
+		}
+
+		const uint8_t* pixel = pixels + pixelIndex * 4;
+		const uint8_t hash = static_cast<uint8_t>((pixel[0] * 3 + pixel[1] * 5 + pixel[2] * 7 + pixel[3] * 11) % 64);
+		if (seenColors[hash] == color)
+		{
+			*output++ = static_cast<uint8_t>(QOI_OP_INDEX | hash);
+		}
+		else
+		{
+			seenColors[hash] = color;
+			if (pixel[3] == previous[3])
+			{
+				// Differences wrap around like the decoder does
+				const int8_t diffR = static_cast<int8_t>(pixel[0] - previous[0]);
+				const int8_t diffG = static_cast<int8_t>(pixel[1] - previous[1]);
+				const int8_t diffB = static_cast<int8_t>(pixel[2] - previous[2]);
+				const int diffRG = diffR - diffG;
+				const int diffBG = diffB - diffG;
+
+				if (diffR >= -2 && diffR <= 1 && diffG >= -2 && diffG <= 1 && diffB >= -2 && diffB <= 1)
+				{
+					*output++ = static_cast<uint8_t>(QOI_OP_DIFF | (diffR + 2) << 4 | (diffG + 2) << 2 | (diffB + 2));
+				}
+				else if (diffG >= -32 && diffG <= 31 && diffRG >= -8 && diffRG <= 7 && diffBG >= -8 && diffBG <= 7)
+				{
+					*output++ = static_cast<uint8_t>(QOI_OP_LUMA | (diffG + 32));
+					*output++ = static_cast<uint8_t>((diffRG + 8) << 4 | (diffBG + 8));
+				}
+				else
+				{
+					*output++ = QOI_OP_RGB;
+					*output++ = pixel[0];
+					*output++ = pixel[1];
+					*output++ = pixel[2];
+				}
+			}
+			else
+			{
+				*output++ = QOI_OP_RGBA;
+				memcpy(output, pixel, 4);
+				output += 4;
+			}
+		}
+
+		memcpy(previous, pixel, sizeof(previous));
+		previousColor = color;
+	}
+
+	memcpy(output, QOI_END_MARKER, sizeof(QOI_END_MARKER));
+	output += sizeof(QOI_END_MARKER);
+
+	std::ofstream file(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << ("[ERROR] File not created: " + filePath + "\n") << std::flush;
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(m_fileData.data()), output - m_fileData.data());
+	return file.good();
+}
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+* @brief Encode qoi files (https://qoiformat.org), much faster to write than png files but a bit bigger
+* @brief The buffer is kept between files, so use one writer per thread
+*/
+class QoiWriter
+{
+public:
+	/**
+	* @brief Write a qoi file of RGBA pixels
+	* @return False if the file cannot be written
+	*/
+	bool WriteRgba(const std::string& filePath, const uint8_t* pixels, size_t width, size_t height);
+
+private:
+	std::vector<uint8_t> m_fileData;
+};
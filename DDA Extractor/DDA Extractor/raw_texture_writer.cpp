@@ -0,0 +1,74 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "raw_texture_writer.h"
+
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+// The header is written as it is in memory, the extractor only runs on little endian CPUs
+static_assert(sizeof(DDARawTextureHeader) == 24, "DDARawTextureHeader must not have padding");
+
+bool RawTextureWriter::WriteIndexed(const std::string& filePath, const uint8_t* indices, size_t width, size_t height, size_t rowStride, int bitsPerPixel, const uint32_t* palettes, size_t colorCount, size_t paletteCount)
+{
+	DDARawTextureHeader header;
+	header.bitsPerPixel = static_cast<uint8_t>(bitsPerPixel);
+	header.colorCount = static_cast<uint16_t>(colorCount);
+	header.paletteCount = static_cast<uint16_t>(paletteCount);
+	header.width = static_cast<uint32_t>(width);
+	header.height = static_cast<uint32_t>(height);
+	header.rowSize = static_cast<uint32_t>(bitsPerPixel == 4 ? (width + 1) / 2 : width);
+	return WriteFile(filePath, header, indices, rowStride, palettes);
+}
+
+bool RawTextureWriter::WriteRgba(const std::string& filePath, const uint8_t* pixels, size_t width, size_t height)
+{
+	DDARawTextureHeader header;
+	header.bitsPerPixel = 32;
+	header.width = static_cast<uint32_t>(width);
+	header.height = static_cast<uint32_t>(height);
+	header.rowSize = static_cast<uint32_t>(width * 4);
+	return WriteFile(filePath, header, pixels, width * 4, nullptr);
+}
+
+bool RawTextureWriter::WriteFile(const std::string& filePath, const DDARawTextureHeader& header, const uint8_t* rows, size_t rowStride, const uint32_t* palettes)
+{
+	const size_t paletteSize = static_cast<size_t>(header.colorCount) * header.paletteCount * sizeof(uint32_t);
+	const bool rowsAreContiguous = rowStride == header.rowSize;
+
+	// Rows of the game file are not contiguous (the mipmaps are next to the texture), they are gathered to write the file in one call
+	m_fileData.resize(sizeof(header) + paletteSize + (rowsAreContiguous ? 0 : header.rowSize * header.height));
+	uint8_t* output = m_fileData.data();
+	memcpy(output, &header, sizeof(header));
+	output += sizeof(header);
+	if (paletteSize != 0)
+	{
+		memcpy(output, palettes, paletteSize);
+		output += paletteSize;
+	}
+	if (!rowsAreContiguous)
+	{
+		for (size_t y = 0; y < header.height; y++)
+		{
+			memcpy(output, rows + y * rowStride, header.rowSize);
+			output += header.rowSize;
+		}
+	}
+
+	std::ofstream file(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << ("[ERROR] File not created: " + filePath + "\n") << std::flush;
+		return false;
+	}
+	file.write(reinterpret_cast<const char*>(m_fileData.data()), m_fileData.size());
+	if (rowsAreContiguous)
+	{
+		file.write(reinterpret_cast<const char*>(rows), static_cast<std::streamsize>(header.rowSize) * header.height);
+	}
+	return file.good();
+}
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#define RAW_TEXTURE_VERSION 2
+
+/**
+* @brief Header of the .ddat files, all values are little endian
+* @brief The header is followed by paletteCount palettes of colorCount RGBA colors (4 bytes each), then height rows of rowSize bytes
+*/
+struct DDARawTextureHeader
+{
+	char magic[4] = { 'D', 'D', 'A', 'T' };
+	uint8_t version = RAW_TEXTURE_VERSION;
+	uint8_t bitsPerPixel = 0; // 4 (two indices per byte, low 4 bits first like on PS2), 8 (one index per byte) or 32 (RGBA pixels without palette)
+	uint16_t colorCount = 0; // 16, 256 or 0 for RGBA pixels
+	uint16_t paletteCount = 0; // Palettes that can be used with the indices (clutCount of the texture), 0 for RGBA pixels
+	uint16_t reserved = 0;
+	uint32_t width = 0; // In pixels
+	uint32_t height = 0;
+	uint32_t rowSize = 0; // In bytes
+};
+
+/**
+* @brief Write textures as they are stored in the game files, without converting the indices or compressing the pixels
+* @brief The buffer is kept between files, so use one writer per thread
+*/
+class RawTextureWriter
+{
+public:
+	/**
+	* @brief Write a texture of palette indices
+	* @param indices First row of indices, rows are rowStride bytes apart
+	* @param bitsPerPixel 8, or 4 for two pixels per byte
+	* @param palettes paletteCount palettes of colorCount colors prepared with ClutExpander::PreparePalette
+	* @return False if the file cannot be written
+	*/
+	bool WriteIndexed(const std::string& filePath, const uint8_t* indices, size_t width, size_t height, size_t rowStride, int bitsPerPixel, const uint32_t* palettes, size_t colorCount, size_t paletteCount);
+
+	/**
+	* @brief Write a texture of RGBA pixels
+	* @return False if the file cannot be written
+	*/
+	bool WriteRgba(const std::string& filePath, const uint8_t* pixels, size_t width, size_t height);
+
+private:
+	bool WriteFile(const std::string& filePath, const DDARawTextureHeader& header, const uint8_t* rows, size_t rowStride, const uint32_t* palettes);
+
+	std::vector<uint8_t> m_fileData;
+};
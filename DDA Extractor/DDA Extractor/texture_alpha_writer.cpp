@@ -0,0 +1,45 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "texture_alpha_writer.h"
+
+#include <fstream>
+
+#include "json_utils.h"
+
+bool TextureAlphaWriter::Write(const std::vector<DDATextureAlpha>& textureAlphas, const std::string& filePath)
+{
+	std::ofstream file(filePath, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file << "{\n";
+	file << "\t\"textures\": [";
+	for (size_t i = 0; i < textureAlphas.size(); i++)
+	{
+		file << (i == 0 ? "\n" : ",\n");
+		file << "\t\t{ \"path\": \"" << JsonUtils::EscapeString(textureAlphas[i].path) << "\", \"alpha\": \"" << GetAlphaTypeName(textureAlphas[i].alphaType) << "\" }";
+	}
+	file << "\n\t]\n";
+	file << "}\n";
+
+	return file.good();
+}
+
+const char* TextureAlphaWriter::GetAlphaTypeName(DDAAlphaType alphaType)
+{
+	switch (alphaType)
+	{
+	case DDAAlphaType::ALPHA_CUTOUT:
+		return "cutout";
+	case DDAAlphaType::ALPHA_BLEND:
+		return "blend";
+	default:
+		return "opaque";
+	}
+}
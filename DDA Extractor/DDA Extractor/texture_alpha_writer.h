@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "dda_structures.h"
+
+// File in the export folder of a game file with the alpha type of each texture file
+constexpr const char* TEXTURE_ALPHA_FILE_NAME = "texture_alpha.json";
+
+// Alpha type of a texture file
+struct DDATextureAlpha
+{
+	std::string path; // Relative to the export folder
+	DDAAlphaType alphaType = DDAAlphaType::ALPHA_OPAQUE;
+};
+
+/**
+* @brief Write the alpha type of the texture files, so renderers can sort and batch the materials without reading the pixels
+*/
+class TextureAlphaWriter
+{
+public:
+	/**
+	* @return False if the file cannot be written
+	*/
+	static bool Write(const std::vector<DDATextureAlpha>& textureAlphas, const std::string& filePath);
+
+	/**
+	* @brief Get the name of an alpha type in the file: "opaque", "cutout" or "blend"
+	*/
+	static const char* GetAlphaTypeName(DDAAlphaType alphaType);
+};
@@ -0,0 +1,285 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "texture_atlas_builder.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "extraction_stats.h"
+#include "texture_dumper.h"
+#include "trace_recorder.h"
+#include "worker_pool.h"
+
+namespace
+{
+	constexpr size_t ATLAS_SIZE = 2048;
+
+	// Pixels around each texture, copied from its edges so the filtering and the mipmaps do not take the colors of the next texture
+	constexpr size_t ATLAS_PADDING = 4;
+
+	// UVs a bit outside of the texture are still in the padding
+	constexpr float UV_TOLERANCE = 0.001f;
+
+	// Row of textures in an atlas, textures are placed from left to right
+	struct Shelf
+	{
+		size_t atlasIndex = 0;
+		size_t y = 0;
+		size_t height = 0;
+		size_t usedWidth = 0;
+	};
+
+	struct Placement
+	{
+		size_t textureIndex = 0;
+		size_t atlasIndex = 0;
+		size_t x = 0; // Position of the texture without the padding
+		size_t y = 0;
+	};
+
+	/**
+	* @brief Only the first frame of an animated texture is in the atlas, the UVs of its sub meshes are already scaled to it (see DDAFileParser::ScaleAnimatedTextureUVs)
+	*/
+	size_t GetAtlasHeight(const DDATextureCopyParams& textureCopyParams)
+	{
+		return textureCopyParams.exportHeight / textureCopyParams.frameCount;
+	}
+
+	bool HasUVsInTexture(const DDASubMesh& subMesh, float maxV)
+	{
+		for (const DDAVector2& uv : subMesh.verticesUVs)
+		{
+			if (uv.x < -UV_TOLERANCE || uv.x > 1 + UV_TOLERANCE || uv.y < -UV_TOLERANCE || uv.y > maxV + UV_TOLERANCE)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	/**
+	* @brief Place the textures in atlases, first fit in rows of decreasing height
+	* @param textureIndices Textures to place, sorted by decreasing height
+	* @param atlasSizes Used size of each atlas
+	*/
+	std::vector<Placement> PlaceTextures(const std::vector<size_t>& textureIndices, const std::vector<DDATextureCopyParams>& textureCopyParamsList, std::vector<std::pair<size_t, size_t>>& atlasSizes)
+	{
+		std::vector<Placement> placements;
+		std::vector<Shelf> shelves;
+		std::vector<size_t> atlasUsedHeights;
+		for (const size_t textureIndex : textureIndices)
+		{
+			const size_t width = textureCopyParamsList[textureIndex].exportWidth + ATLAS_PADDING * 2;
+			const size_t height = GetAtlasHeight(textureCopyParamsList[textureIndex]) + ATLAS_PADDING * 2;
+
+			// Shelves are created by the highest textures first, so all shelves are high enough
+			Shelf* chosenShelf = nullptr;
+			for (Shelf& shelf : shelves)
+			{
+				if (shelf.usedWidth + width <= ATLAS_SIZE)
+				{
+					chosenShelf = &shelf;
+					break;
+				}
+			}
+
+			if (chosenShelf == nullptr)
+			{
+				size_t atlasIndex = 0;
+				while (atlasIndex < atlasUsedHeights.size() && atlasUsedHeights[atlasIndex] + height > ATLAS_SIZE)
+				{
+					atlasIndex++;
+				}
+				if (atlasIndex == atlasUsedHeights.size())
+				{
+					atlasUsedHeights.push_back(0);
+					atlasSizes.emplace_back(0, 0);
+				}
+
+				Shelf& shelf = shelves.emplace_back();
+				shelf.atlasIndex = atlasIndex;
+				shelf.y = atlasUsedHeights[atlasIndex];
+				shelf.height = height;
+				atlasUsedHeights[atlasIndex] += height;
+				chosenShelf = &shelf;
+			}
+
+			placements.push_back({ textureIndex, chosenShelf->atlasIndex, chosenShelf->usedWidth + ATLAS_PADDING, chosenShelf->y + ATLAS_PADDING });
+			chosenShelf->usedWidth += width;
+
+			std::pair<size_t, size_t>& atlasSize = atlasSizes[chosenShelf->atlasIndex];
+			atlasSize.first = std::max(atlasSize.first, chosenShelf->usedWidth);
+			atlasSize.second = std::max(atlasSize.second, chosenShelf->y + chosenShelf->height);
+		}
+		return placements;
+	}
+
+	/**
+	* @brief Copy the RGBA pixels of a texture in an atlas and fill its padding with the pixels of its edges
+	*/
+	void CopyTexture(const DDATextureCopyParams& textureCopyParams, const uint8_t* texturePixels, const Placement& placement, DDATextureCopyParams& atlas)
+	{
+		const uint32_t* pixels = reinterpret_cast<const uint32_t*>(texturePixels);
+		uint32_t* atlasPixels = reinterpret_cast<uint32_t*>(atlas.ownedTextureData.get());
+		const size_t width = textureCopyParams.exportWidth;
+		const size_t height = GetAtlasHeight(textureCopyParams);
+
+		for (size_t y = 0; y < height + ATLAS_PADDING * 2; y++)
+		{
+			const size_t sourceY = std::min(y - std::min(y, ATLAS_PADDING), height - 1);
+			const uint32_t* sourceRow = pixels + sourceY * width;
+			uint32_t* atlasRow = atlasPixels + (placement.y - ATLAS_PADDING + y) * atlas.exportWidth + placement.x - ATLAS_PADDING;
+
+			std::fill(atlasRow, atlasRow + ATLAS_PADDING, sourceRow[0]);
+			memcpy(atlasRow + ATLAS_PADDING, sourceRow, width * sizeof(uint32_t));
+			std::fill(atlasRow + ATLAS_PADDING + width, atlasRow + ATLAS_PADDING * 2 + width, sourceRow[width - 1]);
+		}
+	}
+}
+
+std::vector<DDATextureCopyParams> TextureAtlasBuilder::Build(std::vector<DDAMesh>& meshes, std::vector<DDAMaterial>& materials, const std::vector<DDATextureCopyParams>& textureCopyParamsList, const std::string& textureExtension, size_t jobCount)
+{
+	ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::TEXTURE_ATLAS);
+	TraceRecorder::ScopedEvent traceEvent("BuildTextureAtlases");
+
+	// The textures of the sub meshes that can use an atlas
+	const auto getAtlasTexture = [&](const DDASubMesh& subMesh)
+		{
+			if (subMesh.materialIndex >= materials.size())
+			{
+				return SIZE_MAX;
+			}
+			const size_t textureIndex = materials[subMesh.materialIndex].textureIndex;
+			if (textureIndex >= textureCopyParamsList.size())
+			{
+				return SIZE_MAX;
+			}
+			const DDATextureCopyParams& textureCopyParams = textureCopyParamsList[textureIndex];
+			if (!HasUVsInTexture(subMesh, 1.0f / textureCopyParams.frameCount))
+			{
+				return SIZE_MAX;
+			}
+			const size_t height = GetAtlasHeight(textureCopyParams);
+			const bool fits = textureCopyParams.exportWidth + ATLAS_PADDING * 2 <= ATLAS_SIZE && height + ATLAS_PADDING * 2 <= ATLAS_SIZE;
+			return fits && textureCopyParams.exportWidth != 0 && height != 0 ? textureIndex : SIZE_MAX;
+		};
+
+	std::vector<size_t> textureIndices;
+	std::vector<bool> isTextureUsed(textureCopyParamsList.size(), false);
+	for (const DDAMesh& mesh : meshes)
+	{
+		for (const DDASubMesh& subMesh : mesh.subMeshes)
+		{
+			const size_t textureIndex = getAtlasTexture(subMesh);
+			if (textureIndex != SIZE_MAX && !isTextureUsed[textureIndex])
+			{
+				isTextureUsed[textureIndex] = true;
+				textureIndices.push_back(textureIndex);
+			}
+		}
+	}
+	if (textureIndices.empty())
+	{
+		return {};
+	}
+
+	std::stable_sort(textureIndices.begin(), textureIndices.end(), [&](size_t left, size_t right)
+		{
+			const DDATextureCopyParams& leftParams = textureCopyParamsList[left];
+			const DDATextureCopyParams& rightParams = textureCopyParamsList[right];
+			if (GetAtlasHeight(leftParams) != GetAtlasHeight(rightParams))
+			{
+				return GetAtlasHeight(leftParams) > GetAtlasHeight(rightParams);
+			}
+			return leftParams.exportWidth > rightParams.exportWidth;
+		});
+
+	std::vector<std::pair<size_t, size_t>> atlasSizes;
+	const std::vector<Placement> placements = PlaceTextures(textureIndices, textureCopyParamsList, atlasSizes);
+
+	std::vector<DDATextureCopyParams> atlases(atlasSizes.size());
+	for (size_t atlasIndex = 0; atlasIndex < atlases.size(); atlasIndex++)
+	{
+		// Sizes are multiples of 4 for the block compressed formats
+		DDATextureCopyParams& atlas = atlases[atlasIndex];
+		atlas.exportWidth = (atlasSizes[atlasIndex].first + 3) & ~static_cast<size_t>(3);
+		atlas.exportHeight = (atlasSizes[atlasIndex].second + 3) & ~static_cast<size_t>(3);
+		atlas.outputWidth = atlas.exportWidth;
+		atlas.outputHeight = atlas.exportHeight;
+		atlas.clutType = DDAClutType::CLUT_NONE;
+		atlas.ownedTextureData = std::make_unique<uint8_t[]>(atlas.exportWidth * atlas.exportHeight * sizeof(uint32_t));
+		memset(atlas.ownedTextureData.get(), 0, atlas.exportWidth * atlas.exportHeight * sizeof(uint32_t));
+		atlas.inputTextureData = atlas.ownedTextureData.get();
+		atlas.textureName = "atlas_" + std::to_string(atlasIndex);
+	}
+
+	// Textures are converted again with their first palette in the buffer of the worker, each texture has its own part of the atlas
+	std::vector<TextureDumper> textureDumpers(WorkerPool::GetWorkerCount(placements.size(), jobCount));
+	WorkerPool::ParallelFor(placements.size(), jobCount, [&](size_t placementIndex, size_t workerIndex)
+		{
+			const Placement& placement = placements[placementIndex];
+			const DDATextureCopyParams& textureCopyParams = textureCopyParamsList[placement.textureIndex];
+			const uint8_t* pixels = textureDumpers[workerIndex].CopyTextureData(textureCopyParams);
+			CopyTexture(textureCopyParams, pixels, placement, atlases[placement.atlasIndex]);
+		});
+
+	std::vector<const Placement*> texturePlacements(textureCopyParamsList.size(), nullptr);
+	for (const Placement& placement : placements)
+	{
+		texturePlacements[placement.textureIndex] = &placement;
+	}
+
+	// An atlas is as transparent as its most transparent texture
+	std::vector<DDAAlphaType> atlasAlphaTypes(atlases.size(), DDAAlphaType::ALPHA_OPAQUE);
+	for (const DDAMaterial& material : materials)
+	{
+		if (material.textureIndex < texturePlacements.size() && texturePlacements[material.textureIndex] != nullptr)
+		{
+			DDAAlphaType& atlasAlphaType = atlasAlphaTypes[texturePlacements[material.textureIndex]->atlasIndex];
+			atlasAlphaType = std::max(atlasAlphaType, material.alphaType);
+		}
+	}
+
+	const size_t firstAtlasMaterial = materials.size();
+	for (size_t atlasIndex = 0; atlasIndex < atlases.size(); atlasIndex++)
+	{
+		const DDATextureCopyParams& atlas = atlases[atlasIndex];
+		DDAMaterial& material = materials.emplace_back();
+		material.name = atlas.textureName;
+		material.textureFileName = std::string(TEXTURE_ATLAS_FOLDER) + "/" + atlas.textureName + textureExtension;
+		material.alphaType = atlasAlphaTypes[atlasIndex];
+	}
+
+	for (DDAMesh& mesh : meshes)
+	{
+		for (DDASubMesh& subMesh : mesh.subMeshes)
+		{
+			const size_t textureIndex = getAtlasTexture(subMesh);
+			if (textureIndex == SIZE_MAX)
+			{
+				continue;
+			}
+
+			const Placement& placement = *texturePlacements[textureIndex];
+			const DDATextureCopyParams& textureCopyParams = textureCopyParamsList[textureIndex];
+			const DDATextureCopyParams& atlas = atlases[placement.atlasIndex];
+			// The UVs of an animated texture are relative to the whole sheet, they stay in its first frame
+			const float scaleX = static_cast<float>(textureCopyParams.exportWidth) / atlas.exportWidth;
+			const float scaleY = static_cast<float>(textureCopyParams.exportHeight) / atlas.exportHeight;
+			const float offsetX = static_cast<float>(placement.x) / atlas.exportWidth;
+			const float offsetY = static_cast<float>(placement.y) / atlas.exportHeight;
+			for (DDAVector2& uv : subMesh.verticesUVs)
+			{
+				uv.x = offsetX + uv.x * scaleX;
+				uv.y = offsetY + uv.y * scaleY;
+			}
+			subMesh.materialIndex = static_cast<uint32_t>(firstAtlasMaterial + placement.atlasIndex);
+		}
+	}
+
+	return atlases;
+}
@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "dda_structures.h"
+
+// Folder of the atlases in the export folder of a game file
+constexpr const char* TEXTURE_ATLAS_FOLDER = "atlases";
+
+/**
+* @brief Pack the textures used by the meshes of a file in a few big textures, so the meshes use a few materials instead of one per texture
+*/
+class TextureAtlasBuilder
+{
+public:
+	/**
+	* @brief Pack the textures of the meshes in atlases, then move the UVs and the materials of the sub meshes to the atlases
+	* @brief Sub meshes with UVs outside of their texture (tiling) keep their texture, the atlas cannot repeat it
+	* @param materials Materials of the meshes, a material is added for each atlas
+	* @param textureExtension Extension of the texture files, used by the materials of the atlases (".png")
+	* @param jobCount Threads used to copy the textures in the atlases (0 = one per CPU thread)
+	* @return The atlases, RGBA textures to dump in TEXTURE_ATLAS_FOLDER with their name ("atlas_0")
+	*/
+	static std::vector<DDATextureCopyParams> Build(std::vector<DDAMesh>& meshes, std::vector<DDAMaterial>& materials, const std::vector<DDATextureCopyParams>& textureCopyParamsList, const std::string& textureExtension, size_t jobCount);
+};
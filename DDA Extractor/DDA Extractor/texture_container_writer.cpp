@@ -0,0 +1,256 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "texture_container_writer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+
+namespace
+{
+	// DDS_HEADER flags
+	constexpr uint32_t DDSD_CAPS = 0x1;
+	constexpr uint32_t DDSD_HEIGHT = 0x2;
+	constexpr uint32_t DDSD_WIDTH = 0x4;
+	constexpr uint32_t DDSD_PITCH = 0x8;
+	constexpr uint32_t DDSD_PIXELFORMAT = 0x1000;
+	constexpr uint32_t DDSD_MIPMAPCOUNT = 0x20000;
+	constexpr uint32_t DDSD_LINEARSIZE = 0x80000;
+	constexpr uint32_t DDPF_ALPHAPIXELS = 0x1;
+	constexpr uint32_t DDPF_FOURCC = 0x4;
+	constexpr uint32_t DDPF_RGB = 0x40;
+	constexpr uint32_t DDSCAPS_COMPLEX = 0x8;
+	constexpr uint32_t DDSCAPS_TEXTURE = 0x1000;
+	constexpr uint32_t DDSCAPS_MIPMAP = 0x400000;
+	constexpr uint32_t DXGI_FORMAT_BC7_UNORM_SRGB = 99;
+	constexpr uint32_t DDS_DIMENSION_TEXTURE2D = 3;
+
+	constexpr uint8_t KTX2_IDENTIFIER[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+	constexpr uint32_t VK_FORMAT_R8G8B8A8_SRGB = 43;
+	constexpr uint32_t VK_FORMAT_BC1_RGBA_SRGB_BLOCK = 134;
+	constexpr uint32_t VK_FORMAT_BC3_SRGB_BLOCK = 138;
+	constexpr uint32_t VK_FORMAT_BC7_SRGB_BLOCK = 146;
+	constexpr size_t KTX2_HEADER_SIZE = 80;
+	constexpr size_t KTX2_LEVEL_INDEX_ENTRY_SIZE = 24;
+
+	// Data format descriptor of R8G8B8A8_SRGB (Khronos Data Format Specification, basic descriptor block with 4 samples)
+	constexpr uint32_t KTX2_RGBA_SRGB_DFD[] =
+	{
+		92, // Total size
+		0, // Khronos vendor, basic descriptor
+		2 | (88 << 16), // Version 2, block size
+		1 | (1 << 8) | (2 << 16), // RGBSDA color model, BT709 primaries, sRGB transfer, straight alpha
+		0, // 1x1x1x1 texel blocks
+		4, // 4 bytes in plane 0
+		0,
+		// Samples: bit offset, bit length - 1, channel (alpha is linear), position, lower, upper
+		0 | (7 << 16) | (0u << 24), 0, 0, 255,
+		8 | (7 << 16) | (1u << 24), 0, 0, 255,
+		16 | (7 << 16) | (2u << 24), 0, 0, 255,
+		24 | (7 << 16) | (0x1Fu << 24), 0, 0, 255,
+	};
+
+	// Data format descriptors of the block compressed formats, the samples cover the whole 4x4 block
+	constexpr uint32_t KTX2_BC1_SRGB_DFD[] =
+	{
+		44, 0, 2 | (40 << 16),
+		128 | (1 << 8) | (2 << 16), // BC1A color model
+		3 | (3 << 8), // 4x4x1x1 texel blocks
+		8, 0,
+		0 | (63 << 16) | (1u << 24), 0, 0, UINT32_MAX, // Color with 1 bit alpha
+	};
+
+	constexpr uint32_t KTX2_BC3_SRGB_DFD[] =
+	{
+		60, 0, 2 | (56 << 16),
+		130 | (1 << 8) | (2 << 16), // BC3 color model
+		3 | (3 << 8),
+		16, 0,
+		0 | (63 << 16) | (0x1Fu << 24), 0, 0, UINT32_MAX, // Alpha (linear)
+		64 | (63 << 16) | (0u << 24), 0, 0, UINT32_MAX, // Color
+	};
+
+	constexpr uint32_t KTX2_BC7_SRGB_DFD[] =
+	{
+		44, 0, 2 | (40 << 16),
+		134 | (1 << 8) | (2 << 16), // BC7 color model
+		3 | (3 << 8),
+		16, 0,
+		0 | (127 << 16) | (0u << 24), 0, 0, UINT32_MAX,
+	};
+
+	struct Ktx2Format
+	{
+		uint32_t vkFormat;
+		const uint32_t* dfd;
+		size_t dfdSize; // In bytes
+	};
+
+	Ktx2Format GetKtx2Format(DDAPixelFormat format)
+	{
+		switch (format)
+		{
+		case DDAPixelFormat::BC1:
+			return { VK_FORMAT_BC1_RGBA_SRGB_BLOCK, KTX2_BC1_SRGB_DFD, sizeof(KTX2_BC1_SRGB_DFD) };
+		case DDAPixelFormat::BC3:
+			return { VK_FORMAT_BC3_SRGB_BLOCK, KTX2_BC3_SRGB_DFD, sizeof(KTX2_BC3_SRGB_DFD) };
+		case DDAPixelFormat::BC7:
+			return { VK_FORMAT_BC7_SRGB_BLOCK, KTX2_BC7_SRGB_DFD, sizeof(KTX2_BC7_SRGB_DFD) };
+		default:
+			return { VK_FORMAT_R8G8B8A8_SRGB, KTX2_RGBA_SRGB_DFD, sizeof(KTX2_RGBA_SRGB_DFD) };
+		}
+	}
+
+	void Append32(std::vector<uint8_t>& data, uint32_t value)
+	{
+		const uint8_t bytes[4] = { static_cast<uint8_t>(value), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 24) };
+		data.insert(data.end(), bytes, bytes + 4);
+	}
+
+	void Append64(std::vector<uint8_t>& data, uint64_t value)
+	{
+		Append32(data, static_cast<uint32_t>(value));
+		Append32(data, static_cast<uint32_t>(value >> 32));
+	}
+
+	size_t GetLevelSize(const DDAMipmapLevel& level, DDAPixelFormat format)
+	{
+		return BcEncoder::GetLevelSize(level.width, level.height, format);
+	}
+}
+
+bool TextureContainerWriter::WriteDds(const std::string& filePath, const std::vector<DDAMipmapLevel>& levels, DDAPixelFormat format)
+{
+	const bool hasMipmaps = levels.size() > 1;
+	const bool isCompressed = format != DDAPixelFormat::RGBA8;
+
+	m_headerData.clear();
+	m_headerData.insert(m_headerData.end(), { 'D', 'D', 'S', ' ' });
+	Append32(m_headerData, 124);
+	Append32(m_headerData, DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | (isCompressed ? DDSD_LINEARSIZE : DDSD_PITCH) | DDSD_PIXELFORMAT | DDSD_MIPMAPCOUNT);
+	Append32(m_headerData, static_cast<uint32_t>(levels[0].height));
+	Append32(m_headerData, static_cast<uint32_t>(levels[0].width));
+	// Pitch, or size of the first level for the compressed formats
+	Append32(m_headerData, static_cast<uint32_t>(isCompressed ? GetLevelSize(levels[0], format) : levels[0].width * 4));
+	Append32(m_headerData, 0); // Depth
+	Append32(m_headerData, static_cast<uint32_t>(levels.size()));
+	m_headerData.resize(m_headerData.size() + 11 * sizeof(uint32_t), 0); // Reserved
+
+	Append32(m_headerData, 32);
+	if (isCompressed)
+	{
+		// BC7 has no FourCC, its format is in the DX10 header
+		const char* fourCC = format == DDAPixelFormat::BC1 ? "DXT1" : format == DDAPixelFormat::BC3 ? "DXT5" : "DX10";
+		Append32(m_headerData, DDPF_FOURCC);
+		m_headerData.insert(m_headerData.end(), fourCC, fourCC + 4);
+		m_headerData.resize(m_headerData.size() + 5 * sizeof(uint32_t), 0); // Bit count and masks
+	}
+	else
+	{
+		// Bytes in RGBA order
+		Append32(m_headerData, DDPF_RGB | DDPF_ALPHAPIXELS);
+		Append32(m_headerData, 0); // FourCC
+		Append32(m_headerData, 32);
+		Append32(m_headerData, 0x000000FF);
+		Append32(m_headerData, 0x0000FF00);
+		Append32(m_headerData, 0x00FF0000);
+		Append32(m_headerData, 0xFF000000);
+	}
+
+	Append32(m_headerData, DDSCAPS_TEXTURE | (hasMipmaps ? DDSCAPS_COMPLEX | DDSCAPS_MIPMAP : 0));
+	m_headerData.resize(m_headerData.size() + 4 * sizeof(uint32_t), 0); // Caps 2, 3, 4 and reserved
+
+	if (format == DDAPixelFormat::BC7)
+	{
+		Append32(m_headerData, DXGI_FORMAT_BC7_UNORM_SRGB);
+		Append32(m_headerData, DDS_DIMENSION_TEXTURE2D);
+		Append32(m_headerData, 0); // Misc flags
+		Append32(m_headerData, 1); // Array size
+		Append32(m_headerData, 0); // Alpha mode unknown
+	}
+
+	return WriteFile(filePath, levels, format, false);
+}
+
+bool TextureContainerWriter::WriteKtx2(const std::string& filePath, const std::vector<DDAMipmapLevel>& levels, DDAPixelFormat format)
+{
+	const Ktx2Format ktx2Format = GetKtx2Format(format);
+	const char writerKey[] = "KTXwriter";
+	const char writerValue[] = "DDA Extractor";
+	const size_t keyValueSize = sizeof(writerKey) + sizeof(writerValue);
+
+	const size_t dfdOffset = KTX2_HEADER_SIZE + levels.size() * KTX2_LEVEL_INDEX_ENTRY_SIZE;
+	const size_t kvdOffset = dfdOffset + ktx2Format.dfdSize;
+	const size_t kvdSize = sizeof(uint32_t) + keyValueSize;
+	// Levels start on a boundary of 4 bytes and of the block size, all level sizes keep it
+	const size_t levelAlignment = std::max<size_t>(BcEncoder::GetBlockSize(format), 4);
+	const size_t levelsOffset = (kvdOffset + kvdSize + levelAlignment - 1) / levelAlignment * levelAlignment;
+
+	m_headerData.clear();
+	m_headerData.insert(m_headerData.end(), KTX2_IDENTIFIER, KTX2_IDENTIFIER + sizeof(KTX2_IDENTIFIER));
+	Append32(m_headerData, ktx2Format.vkFormat);
+	Append32(m_headerData, 1); // Type size
+	Append32(m_headerData, static_cast<uint32_t>(levels[0].width));
+	Append32(m_headerData, static_cast<uint32_t>(levels[0].height));
+	Append32(m_headerData, 0); // Depth
+	Append32(m_headerData, 0); // Layers
+	Append32(m_headerData, 1); // Faces
+	Append32(m_headerData, static_cast<uint32_t>(levels.size()));
+	Append32(m_headerData, 0); // No supercompression
+	Append32(m_headerData, static_cast<uint32_t>(dfdOffset));
+	Append32(m_headerData, static_cast<uint32_t>(ktx2Format.dfdSize));
+	Append32(m_headerData, static_cast<uint32_t>(kvdOffset));
+	Append32(m_headerData, static_cast<uint32_t>(kvdSize));
+	Append64(m_headerData, 0); // No supercompression global data
+	Append64(m_headerData, 0);
+
+	// The level index starts with the biggest level, but the data starts with the smallest one
+	size_t levelOffset = levelsOffset;
+	std::vector<size_t> levelOffsets(levels.size());
+	for (size_t levelIndex = levels.size(); levelIndex-- > 0;)
+	{
+		levelOffsets[levelIndex] = levelOffset;
+		levelOffset += GetLevelSize(levels[levelIndex], format);
+	}
+	for (size_t levelIndex = 0; levelIndex < levels.size(); levelIndex++)
+	{
+		Append64(m_headerData, levelOffsets[levelIndex]);
+		Append64(m_headerData, GetLevelSize(levels[levelIndex], format));
+		Append64(m_headerData, GetLevelSize(levels[levelIndex], format));
+	}
+
+	for (size_t i = 0; i < ktx2Format.dfdSize / sizeof(uint32_t); i++)
+	{
+		Append32(m_headerData, ktx2Format.dfd[i]);
+	}
+
+	Append32(m_headerData, static_cast<uint32_t>(keyValueSize));
+	m_headerData.insert(m_headerData.end(), writerKey, writerKey + sizeof(writerKey));
+	m_headerData.insert(m_headerData.end(), writerValue, writerValue + sizeof(writerValue));
+	m_headerData.resize(levelsOffset, 0);
+
+	return WriteFile(filePath, levels, format, true);
+}
+
+bool TextureContainerWriter::WriteFile(const std::string& filePath, const std::vector<DDAMipmapLevel>& levels, DDAPixelFormat format, bool smallestLevelFirst)
+{
+	std::ofstream file(filePath, std::ios::out | std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << ("[ERROR] File not created: " + filePath + "\n") << std::flush;
+		return false;
+	}
+
+	file.write(reinterpret_cast<const char*>(m_headerData.data()), m_headerData.size());
+	for (size_t i = 0; i < levels.size(); i++)
+	{
+		const DDAMipmapLevel& level = levels[smallestLevelFirst ? levels.size() - 1 - i : i];
+		file.write(reinterpret_cast<const char*>(level.data), GetLevelSize(level, format));
+	}
+	return file.good();
+}
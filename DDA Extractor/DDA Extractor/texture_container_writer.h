@@ -0,0 +1,49 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "bc_encoder.h"
+
+// Pixels or blocks of a mipmap level
+struct DDAMipmapLevel
+{
+	const uint8_t* data = nullptr;
+	size_t width = 0;
+	size_t height = 0;
+};
+
+/**
+* @brief Write RGBA or block compressed textures with all their mipmaps in files that game engines can upload to the GPU without conversion
+* @brief The buffer is kept between files, so use one writer per thread
+*/
+class TextureContainerWriter
+{
+public:
+	/**
+	* @brief Write a dds file, with the RGBA masks for RGBA8, DXT1/DXT5 for BC1/BC3 and a DX10 header for BC7
+	* @param levels Mipmap levels from the biggest to the smallest
+	* @return False if the file cannot be written
+	*/
+	bool WriteDds(const std::string& filePath, const std::vector<DDAMipmapLevel>& levels, DDAPixelFormat format = DDAPixelFormat::RGBA8);
+
+	/**
+	* @brief Write a ktx2 file with the sRGB format of the pixels (R8G8B8A8_SRGB, BC1_RGBA_SRGB_BLOCK...)
+	* @param levels Mipmap levels from the biggest to the smallest
+	* @return False if the file cannot be written
+	*/
+	bool WriteKtx2(const std::string& filePath, const std::vector<DDAMipmapLevel>& levels, DDAPixelFormat format = DDAPixelFormat::RGBA8);
+
+private:
+	bool WriteFile(const std::string& filePath, const std::vector<DDAMipmapLevel>& levels, DDAPixelFormat format, bool smallestLevelFirst);
+
+	std::vector<uint8_t> m_headerData;
+};
@@ -6,74 +6,345 @@
 
 #include "texture_dumper.h"
 
+#include <algorithm>
 #include <filesystem>
 
-#define STB_IMAGE_WRITE_IMPLEMENTATION
-#include <stb_image_write.h>
+#include "bc_encoder.h"
+#include "clut_expander.h"
+#include "extraction_stats.h"
+#include "texture_name_registry.h"
+#include "trace_recorder.h"
 
 /**
-* @brief Copy raw texture using palette to a buffer
+* @brief Convert a texture to RGBA pixels with its first palette
+* @return The pixels, in a buffer of the dumper reused by the next texture
 */
-void TextureDumper::CopyTextureData(const DDATextureCopyParams& params)
+const uint8_t* TextureDumper::CopyTextureData(const DDATextureCopyParams& params)
 {
-	for (size_t y = 0; y < params.outputHeight; y++)
+	return ExpandTexture(params, params.palette.get());
+}
+
+const uint8_t* TextureDumper::ExpandTexture(const DDATextureCopyParams& params, const uint8_t* fixedPalette)
+{
+	size_t colorCount = 0;
+	if (params.clutType == DDAClutType::CLUT_256)
+	{
+		colorCount = 256;
+	}
+	else if (params.clutType == DDAClutType::CLUT_16)
+	{
+		colorCount = 16;
+	}
+	else
+	{
+		return params.inputTextureData;
+	}
+
+	// The alpha fix is applied to the palette once instead of every pixel
+	uint32_t palette[256];
+	ClutExpander::PreparePalette(fixedPalette, colorCount, palette);
+
+	// The buffer only grows, so it is allocated a few times per thread instead of once per texture
+	m_pixels.resize(params.exportWidth * params.exportHeight);
+	ExpandRegion(params, palette, params.xOffset, 0, params.outputWidth, params.outputHeight, m_pixels.data());
+	return reinterpret_cast<const uint8_t*>(m_pixels.data());
+}
+
+void TextureDumper::ExpandRegion(const DDATextureCopyParams& params, const uint32_t* palette, size_t x, size_t y, size_t width, size_t height, uint32_t* outputPixels)
+{
+	// There are two pixels per byte with 16 colors
+	const size_t outputWidth = params.clutType == DDAClutType::CLUT_16 ? width * 2 : width;
+	for (size_t row = 0; row < height; row++)
+	{
+		const uint8_t* inputRow = params.inputTextureData + x + (y + row) * params.inputWidth;
+		if (params.clutType == DDAClutType::CLUT_256)
+		{
+			ClutExpander::ExpandRow256(inputRow, width, palette, outputPixels + row * outputWidth);
+		}
+		else
+		{
+			ClutExpander::ExpandRow16(inputRow, width, palette, outputPixels + row * outputWidth);
+		}
+	}
+}
+
+std::vector<std::string> TextureDumper::GetPaletteFilePaths(const DDATextureCopyParams& textureCopyParams, const std::string& filePath, DDATextureFormat textureFormat)
+{
+	std::vector<std::string> filePaths = { filePath };
+	if (textureFormat == DDATextureFormat::RAW)
+	{
+		return filePaths;
+	}
+
+	const size_t extensionPosition = std::min(filePath.find_last_of('.'), filePath.size());
+	for (size_t paletteIndex = 1; paletteIndex <= textureCopyParams.alternatePalettes.size(); paletteIndex++)
+	{
+		filePaths.push_back(filePath.substr(0, extensionPosition) + TextureNameRegistry::GetPaletteSuffix(paletteIndex) + filePath.substr(extensionPosition));
+	}
+	return filePaths;
+}
+
+DDAAlphaType TextureDumper::GetAlphaType(const DDATextureCopyParams& textureCopyParams, const uint8_t* fixedPalette)
+{
+	ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::CLUT_DECODE);
+	if (textureCopyParams.clutType == DDAClutType::CLUT_NONE)
+	{
+		return ClutExpander::GetAlphaType(reinterpret_cast<const uint32_t*>(textureCopyParams.inputTextureData), textureCopyParams.exportWidth * textureCopyParams.exportHeight);
+	}
+
+	const bool isClut16 = textureCopyParams.clutType == DDAClutType::CLUT_16;
+	uint32_t palette[256];
+	ClutExpander::PreparePalette(fixedPalette, isClut16 ? 16 : 256, palette);
+
+	// The mipmaps use the colors of the first level, only the first level is read
+	return ClutExpander::GetUsedAlphaType(textureCopyParams.inputTextureData + textureCopyParams.xOffset, textureCopyParams.outputWidth, textureCopyParams.outputHeight,
+		textureCopyParams.inputWidth, isClut16, palette);
+}
+
+const char* TextureDumper::GetFileExtension(DDATextureFormat textureFormat)
+{
+	switch (textureFormat)
+	{
+	case DDATextureFormat::QOI:
+		return ".qoi";
+	case DDATextureFormat::RAW:
+		return ".ddat";
+	case DDATextureFormat::DDS:
+		return ".dds";
+	case DDATextureFormat::KTX2:
+		return ".ktx2";
+	default:
+		return ".png";
+	}
+}
+
+std::vector<std::string> TextureDumper::GetTextureFilePaths(const std::vector<DDATextureCopyParams>& textureCopyParamsList, const std::string& destinationFolder, DDATextureFormat textureFormat)
+{
+	const std::string fileExtension = GetFileExtension(textureFormat);
+
+	std::vector<std::string> filePaths;
+	filePaths.reserve(textureCopyParamsList.size());
+
+	TextureNameRegistry nameRegistry;
+	for (const DDATextureCopyParams& textureCopyParams : textureCopyParamsList)
+	{
+		// Raw files have all palettes in one file
+		const size_t alternatePaletteCount = textureFormat == DDATextureFormat::RAW ? 0 : textureCopyParams.alternatePalettes.size();
+		filePaths.push_back(destinationFolder + nameRegistry.Register(textureCopyParams.textureName, fileExtension, alternatePaletteCount));
+	}
+
+	return filePaths;
+}
+
+bool TextureDumper::DumpIndexedTexture(const DDATextureCopyParams& textureCopyParams, const uint8_t* fixedPalette, const std::string& filePath)
+{
+	const bool isClut16 = textureCopyParams.clutType == DDAClutType::CLUT_16;
+	const size_t colorCount = isClut16 ? 16 : 256;
+
+	uint32_t palette[256];
+	{
+		ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::CLUT_DECODE);
+		ClutExpander::PreparePalette(fixedPalette, colorCount, palette);
+	}
+
+	// The indices are read like in CopyTextureData
+	ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::PNG_ENCODE);
+	return m_pngWriter.WriteIndexed(filePath, textureCopyParams.inputTextureData + textureCopyParams.xOffset,
+		textureCopyParams.outputWidth * (isClut16 ? 2 : 1), textureCopyParams.outputHeight, textureCopyParams.inputWidth,
+		isClut16 ? 4 : 8, palette, colorCount);
+}
+
+bool TextureDumper::DumpRawTexture(const DDATextureCopyParams& textureCopyParams, const std::string& filePath)
+{
+	if (textureCopyParams.clutType == DDAClutType::CLUT_NONE)
+	{
+		ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::TEXTURE_WRITE);
+		return m_rawTextureWriter.WriteRgba(filePath, textureCopyParams.inputTextureData, textureCopyParams.exportWidth, textureCopyParams.exportHeight);
+	}
+
+	const bool isClut16 = textureCopyParams.clutType == DDAClutType::CLUT_16;
+	const size_t colorCount = isClut16 ? 16 : 256;
+	const size_t paletteCount = 1 + textureCopyParams.alternatePalettes.size();
+
+	// The palettes are written fixed, so readers of the file do not need to know the PS2 palette layout
+	{
+		ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::CLUT_DECODE);
+		m_rawPalettes.resize(colorCount * paletteCount);
+		ClutExpander::PreparePalette(textureCopyParams.palette.get(), colorCount, m_rawPalettes.data());
+		for (size_t paletteIndex = 1; paletteIndex < paletteCount; paletteIndex++)
+		{
+			ClutExpander::PreparePalette(textureCopyParams.alternatePalettes[paletteIndex - 1].get(), colorCount, m_rawPalettes.data() + paletteIndex * colorCount);
+		}
+	}
+
+	ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::TEXTURE_WRITE);
+	return m_rawTextureWriter.WriteIndexed(filePath, textureCopyParams.inputTextureData + textureCopyParams.xOffset,
+		textureCopyParams.outputWidth * (isClut16 ? 2 : 1), textureCopyParams.outputHeight, textureCopyParams.inputWidth,
+		isClut16 ? 4 : 8, m_rawPalettes.data(), colorCount, paletteCount);
+}
+
+bool TextureDumper::DumpMipmapTexture(const DDATextureCopyParams& textureCopyParams, const uint8_t* fixedPalette, const std::string& filePath)
+{
+	m_mipmapLevels.clear();
+	// Same classification as the materials and texture_alpha.json: only the colors used by the texture are read
+	DDAAlphaType alphaType = DDAAlphaType::ALPHA_OPAQUE;
+	if (m_options.blockCompression == DDABlockCompression::BC1_BC3)
+	{
+		alphaType = GetAlphaType(textureCopyParams, fixedPalette);
+	}
+
+	if (textureCopyParams.clutType == DDAClutType::CLUT_NONE)
+	{
+		m_mipmapLevels.push_back({ textureCopyParams.inputTextureData, textureCopyParams.exportWidth, textureCopyParams.exportHeight });
+	}
+	else
 	{
-		for (size_t x = 0; x < params.outputWidth; x++)
+		ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::CLUT_DECODE);
+
+		const bool isClut16 = textureCopyParams.clutType == DDAClutType::CLUT_16;
+		uint32_t palette[256];
+		ClutExpander::PreparePalette(fixedPalette, isClut16 ? 16 : 256, palette);
+
+		size_t pixelCount = 0;
+		for (size_t mipmapLevel = 0; mipmapLevel < textureCopyParams.mipmapCount; mipmapLevel++)
+		{
+			pixelCount += (textureCopyParams.exportWidth >> mipmapLevel) * (textureCopyParams.exportHeight >> mipmapLevel);
+		}
+		m_pixels.resize(pixelCount);
+
+		// Each level is converted from its own part of the entry, so the entry is read once
+		// The first level is on the top left, the next levels are under it from left to right
+		size_t mipmapX = textureCopyParams.xOffset;
+		size_t mipmapY = 0;
+		uint32_t* levelPixels = m_pixels.data();
+		for (size_t mipmapLevel = 0; mipmapLevel < textureCopyParams.mipmapCount; mipmapLevel++)
 		{
-			const size_t inputPixelIndex = (x + params.xOffset) + y * params.inputWidth;
-			const size_t outputPixelIndex = x + y * params.outputWidth;
-			// There are two pixels per byte
-			const uint8_t colorId = *(params.inputTextureData + inputPixelIndex);
-			if (params.clutType == DDAClutType::CLUT_256)
+			const size_t width = textureCopyParams.exportWidth >> mipmapLevel;
+			const size_t height = textureCopyParams.exportHeight >> mipmapLevel;
+			const size_t inputWidth = isClut16 ? width / 2 : width;
+			ExpandRegion(textureCopyParams, palette, mipmapX, mipmapY, inputWidth, height, levelPixels);
+			m_mipmapLevels.push_back({ reinterpret_cast<const uint8_t*>(levelPixels), width, height });
+
+			levelPixels += width * height;
+			if (mipmapLevel == 0)
 			{
-				// On PS2 the alpha is between 0 and 127, so we multiply by 2
-				params.outputTextureData[outputPixelIndex * 4] = params.palette[colorId * 4 + 0];
-				params.outputTextureData[outputPixelIndex * 4 + 1] = params.palette[colorId * 4 + 1];
-				params.outputTextureData[outputPixelIndex * 4 + 2] = params.palette[colorId * 4 + 2];
-				params.outputTextureData[outputPixelIndex * 4 + 3] = std::clamp(params.palette[colorId * 4 + 3] * 2, 0, 0xff);
+				mipmapY = height;
 			}
-			else if (params.clutType == DDAClutType::CLUT_16)
+			else
 			{
-				const uint8_t firstColorId = colorId & 0x0F;
-				const uint8_t secondColorId = colorId >> 4;
-
-				// On PS2 the alpha is between 0 and 127, so we multiply by 2
-				params.outputTextureData[outputPixelIndex * 8 + 0] = params.palette[firstColorId * 4 + 0];
-				params.outputTextureData[outputPixelIndex * 8 + 1] = params.palette[firstColorId * 4 + 1];
-				params.outputTextureData[outputPixelIndex * 8 + 2] = params.palette[firstColorId * 4 + 2];
-				params.outputTextureData[outputPixelIndex * 8 + 3] = std::clamp(params.palette[firstColorId * 4 + 3] * 2, 0, 0xff);
-
-				params.outputTextureData[outputPixelIndex * 8 + 4] = params.palette[secondColorId * 4 + 0];
-				params.outputTextureData[outputPixelIndex * 8 + 5] = params.palette[secondColorId * 4 + 1];
-				params.outputTextureData[outputPixelIndex * 8 + 6] = params.palette[secondColorId * 4 + 2];
-				params.outputTextureData[outputPixelIndex * 8 + 7] = std::clamp(params.palette[secondColorId * 4 + 3] * 2, 0, 0xff);
+				mipmapX += inputWidth;
 			}
 		}
 	}
+
+	DDAPixelFormat pixelFormat = DDAPixelFormat::RGBA8;
+	if (m_options.blockCompression == DDABlockCompression::BC7)
+	{
+		pixelFormat = DDAPixelFormat::BC7;
+	}
+	else if (m_options.blockCompression == DDABlockCompression::BC1_BC3)
+	{
+		// BC1 has a 1 bit alpha, enough for the cutout textures
+		pixelFormat = alphaType == DDAAlphaType::ALPHA_BLEND ? DDAPixelFormat::BC3 : DDAPixelFormat::BC1;
+	}
+
+	if (pixelFormat != DDAPixelFormat::RGBA8)
+	{
+		ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::BLOCK_ENCODE);
+
+		size_t compressedSize = 0;
+		for (const DDAMipmapLevel& level : m_mipmapLevels)
+		{
+			compressedSize += BcEncoder::GetLevelSize(level.width, level.height, pixelFormat);
+		}
+		m_compressedLevels.resize(compressedSize);
+
+		// The levels point to the compressed blocks from now
+		uint8_t* levelData = m_compressedLevels.data();
+		for (DDAMipmapLevel& level : m_mipmapLevels)
+		{
+			BcEncoder::Compress(level.data, level.width, level.height, pixelFormat, m_options.compressionJobCount, levelData);
+			level.data = levelData;
+			levelData += BcEncoder::GetLevelSize(level.width, level.height, pixelFormat);
+		}
+	}
+
+	ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::TEXTURE_WRITE);
+	if (m_options.textureFormat == DDATextureFormat::KTX2)
+	{
+		return m_textureContainerWriter.WriteKtx2(filePath, m_mipmapLevels, pixelFormat);
+	}
+	return m_textureContainerWriter.WriteDds(filePath, m_mipmapLevels, pixelFormat);
 }
 
 /**
-* @brief Dump all textures from the texture table to PNG files
+* @brief Dump a texture to a file of the format chosen in the options, and one more file for each alternate palette
+* @param filePath Path of the file, see GetTextureFilePaths
+* @return False if a file cannot be written
 */
-void TextureDumper::DumpTexture(const DDATextureCopyParams& textureCopyParams, const std::string& destinationFolder)
+bool TextureDumper::DumpTexture(const DDATextureCopyParams& textureCopyParams, const std::string& filePath)
 {
-	if (destinationFolder.empty())
+	if (filePath.empty())
 	{
-		return;
+		return false;
 	}
 
-	if (textureCopyParams.clutType != DDAClutType::CLUT_NONE)
+	TraceRecorder::ScopedEvent traceEvent("DumpTexture", textureCopyParams.textureName);
+
+	const std::vector<std::string> filePaths = GetPaletteFilePaths(textureCopyParams, filePath, m_options.textureFormat);
+	bool isWritten = true;
+	if (m_options.textureFormat == DDATextureFormat::RAW)
 	{
-		CopyTextureData(textureCopyParams);
+		isWritten = DumpRawTexture(textureCopyParams, filePath);
+	}
+	else
+	{
+		// The indices are read from the game file for each palette and converted in the buffers of the dumper, the textures have no buffer of their own
+		for (size_t paletteIndex = 0; paletteIndex < filePaths.size(); paletteIndex++)
+		{
+			const uint8_t* palette = paletteIndex == 0 ? textureCopyParams.palette.get() : textureCopyParams.alternatePalettes[paletteIndex - 1].get();
+			const std::string& paletteFilePath = filePaths[paletteIndex];
+			if (m_options.textureFormat == DDATextureFormat::DDS || m_options.textureFormat == DDATextureFormat::KTX2)
+			{
+				isWritten &= DumpMipmapTexture(textureCopyParams, palette, paletteFilePath);
+				continue;
+			}
+			if (m_options.textureFormat == DDATextureFormat::PNG && m_options.indexedColors && textureCopyParams.clutType != DDAClutType::CLUT_NONE)
+			{
+				isWritten &= DumpIndexedTexture(textureCopyParams, palette, paletteFilePath);
+				continue;
+			}
+
+			const uint8_t* pixels = textureCopyParams.inputTextureData;
+			if (textureCopyParams.clutType != DDAClutType::CLUT_NONE)
+			{
+				ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::CLUT_DECODE);
+				pixels = ExpandTexture(textureCopyParams, palette);
+			}
+
+			if (m_options.textureFormat == DDATextureFormat::QOI)
+			{
+				ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::TEXTURE_WRITE);
+				isWritten &= m_qoiWriter.WriteRgba(paletteFilePath, pixels, textureCopyParams.exportWidth, textureCopyParams.exportHeight);
+			}
+			else
+			{
+				ExtractionStats::ScopedPhaseTimer timer(DDAStatsPhase::PNG_ENCODE);
+				isWritten &= m_pngWriter.WriteRgba(paletteFilePath, pixels, textureCopyParams.exportWidth, textureCopyParams.exportHeight);
+			}
+		}
 	}
 
-	std::string path = destinationFolder + textureCopyParams.textureName + ".png";
-	size_t fileNum = 0;
-	while (std::filesystem::exists(path))
+	if (ExtractionStats::IsEnabled())
 	{
-		fileNum++;
-		path = destinationFolder + textureCopyParams.textureName + " (" + std::to_string(fileNum) + ").png";
+		ExtractionStats::AddCounter(DDAStatsCounter::TEXTURES, 1);
+		for (const std::string& writtenFilePath : filePaths)
+		{
+			std::error_code error;
+			const uintmax_t fileSize = std::filesystem::file_size(writtenFilePath, error);
+			ExtractionStats::AddCounter(DDAStatsCounter::BYTES_WRITTEN, error ? 0 : fileSize);
+		}
 	}
 
-	stbi_write_png(path.c_str(), static_cast<int>(textureCopyParams.exportWidth), static_cast<int>(textureCopyParams.exportHeight), 4, textureCopyParams.outputTextureData.get(), 0);
-}
\ No newline at end of file
+	return isWritten;
+}
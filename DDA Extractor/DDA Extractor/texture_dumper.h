@@ -7,15 +7,119 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "dda_structures.h"
+#include "png_writer.h"
+#include "qoi_writer.h"
+#include "raw_texture_writer.h"
+#include "texture_container_writer.h"
+
+// Format of the texture files
+enum class DDATextureFormat
+{
+	PNG,
+	QOI, // RGBA pixels, much faster to write than png
+	RAW, // Indices and palette as they are in the game file (.ddat), see DDARawTextureHeader
+	DDS, // RGBA pixels or compressed blocks with all mipmap levels
+	KTX2, // RGBA pixels or compressed blocks with all mipmap levels
+};
+
+// Block compression of the dds and ktx2 files
+enum class DDABlockCompression
+{
+	NONE, // RGBA pixels
+	BC1_BC3, // BC1 for the opaque and cutout textures, BC3 for the others (see TextureDumper::GetAlphaType)
+	BC7,
+};
+
+// Options of the texture files created by TextureDumper
+struct DDATextureExportOptions
+{
+	DDATextureFormat textureFormat = DDATextureFormat::PNG;
+	bool indexedColors = false; // Keep the palette of the textures (4 or 8 bits png) instead of writing RGBA pixels
+	DDAPngCompression pngCompression = DDAPngCompression::DEFAULT;
+	DDABlockCompression blockCompression = DDABlockCompression::NONE;
+	size_t compressionJobCount = 1; // Threads used to compress one large texture (png or blocks)
+};
 
 class TextureDumper
 {
 public:
-	void DumpTexture(const DDATextureCopyParams& textureCopyParams, const std::string& destinationFolder);
-	void CopyTextureData(const DDATextureCopyParams& params);
+	TextureDumper() = default;
+	explicit TextureDumper(const DDATextureExportOptions& options)
+		: m_options(options), m_pngWriter(options.pngCompression, options.compressionJobCount) {
+	}
+
+	bool DumpTexture(const DDATextureCopyParams& textureCopyParams, const std::string& filePath);
+	const uint8_t* CopyTextureData(const DDATextureCopyParams& params);
+
+	/**
+	* @brief Get the files written by DumpTexture for a texture: the file of the texture then one file per alternate palette ("name_Clut1.png")
+	* @brief Raw files have all palettes in one file
+	*/
+	static std::vector<std::string> GetPaletteFilePaths(const DDATextureCopyParams& textureCopyParams, const std::string& filePath, DDATextureFormat textureFormat);
+
+	/**
+	* @brief Get the file path of each texture, a number is added to the name if the name is already used: "name (1).png"
+	* @brief Paths are given in the texture list order, so textures can be dumped in any order and still get the same file name
+	*/
+	static std::vector<std::string> GetTextureFilePaths(const std::vector<DDATextureCopyParams>& textureCopyParamsList, const std::string& destinationFolder, DDATextureFormat textureFormat);
+
+	/**
+	* @brief Find how a texture uses the alpha with one of its palettes, only the colors used by the texture are checked
+	* @param fixedPalette Palette of the texture or one of its alternate palettes, not used by the textures without palette
+	*/
+	static DDAAlphaType GetAlphaType(const DDATextureCopyParams& textureCopyParams, const uint8_t* fixedPalette);
+
+	/**
+	* @brief Get the extension of the texture files with the dot (".png")
+	*/
+	static const char* GetFileExtension(DDATextureFormat textureFormat);
 
 private:
+	/**
+	* @brief Convert the palette indices of a texture to RGBA pixels in m_pixels
+	* @param fixedPalette Palette of the texture or one of its alternate palettes
+	* @return The pixels, inputTextureData for the textures without palette
+	*/
+	const uint8_t* ExpandTexture(const DDATextureCopyParams& params, const uint8_t* fixedPalette);
+
+	/**
+	* @brief Convert the palette indices of a part of the texture entry to RGBA pixels
+	* @param x Position in bytes of the part in the rows of the entry
+	* @param width Width in bytes of the part (two pixels per byte with 16 colors)
+	* @param palette Palette prepared with ClutExpander::PreparePalette
+	*/
+	void ExpandRegion(const DDATextureCopyParams& params, const uint32_t* palette, size_t x, size_t y, size_t width, size_t height, uint32_t* outputPixels);
+
+	/**
+	* @brief Write a texture and its mipmaps in a dds or ktx2 file, each level is converted from its part of the entry
+	* @brief The levels are compressed if blockCompression is set, the format is chosen with the alpha of the palette
+	* @return False if the file cannot be written
+	*/
+	bool DumpMipmapTexture(const DDATextureCopyParams& textureCopyParams, const uint8_t* fixedPalette, const std::string& filePath);
+
+	/**
+	* @brief Write the palette indices of a texture in a png file without converting them to RGBA
+	* @return False if the file cannot be written
+	*/
+	bool DumpIndexedTexture(const DDATextureCopyParams& textureCopyParams, const uint8_t* fixedPalette, const std::string& filePath);
+
+	/**
+	* @brief Write the palette indices of a texture and all its palettes in a .ddat file, RGBA textures are written as they are
+	* @return False if the file cannot be written
+	*/
+	bool DumpRawTexture(const DDATextureCopyParams& textureCopyParams, const std::string& filePath);
+
+	DDATextureExportOptions m_options;
+	PngWriter m_pngWriter;
+	QoiWriter m_qoiWriter;
+	RawTextureWriter m_rawTextureWriter;
+	TextureContainerWriter m_textureContainerWriter;
+	std::vector<uint32_t> m_rawPalettes;
+	std::vector<uint32_t> m_pixels; // RGBA pixels of the texture being dumped, with all its levels for dds and ktx2
+	std::vector<DDAMipmapLevel> m_mipmapLevels;
+	std::vector<uint8_t> m_compressedLevels;
 };
 
@@ -0,0 +1,56 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "texture_name_registry.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace
+{
+	std::string ToLower(std::string text)
+	{
+		std::transform(text.begin(), text.end(), text.begin(), [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+		return text;
+	}
+}
+
+std::string TextureNameRegistry::Register(const std::string& name, const std::string& extension, size_t alternatePaletteCount)
+{
+	const std::string lowerName = ToLower(name);
+	const std::string lowerExtension = ToLower(extension);
+
+	// Numbers under nextNumber were used by the previous textures with this name, they are not tried again
+	size_t& nextNumber = m_nextNumbers[lowerName + lowerExtension];
+	for (;; nextNumber++)
+	{
+		const std::string numberSuffix = nextNumber == 0 ? "" : " (" + std::to_string(nextNumber) + ")";
+		const std::string lowerFileName = lowerName + numberSuffix;
+
+		bool isFree = m_usedFileNames.count(lowerFileName + lowerExtension) == 0;
+		for (size_t paletteIndex = 1; paletteIndex <= alternatePaletteCount && isFree; paletteIndex++)
+		{
+			isFree = m_usedFileNames.count(ToLower(lowerFileName + GetPaletteSuffix(paletteIndex)) + lowerExtension) == 0;
+		}
+		if (!isFree)
+		{
+			continue;
+		}
+
+		m_usedFileNames.insert(lowerFileName + lowerExtension);
+		for (size_t paletteIndex = 1; paletteIndex <= alternatePaletteCount; paletteIndex++)
+		{
+			m_usedFileNames.insert(ToLower(lowerFileName + GetPaletteSuffix(paletteIndex)) + lowerExtension);
+		}
+		nextNumber++;
+		return name + numberSuffix + extension;
+	}
+}
+
+std::string TextureNameRegistry::GetPaletteSuffix(size_t paletteIndex)
+{
+	return "_Clut" + std::to_string(paletteIndex);
+}
@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+
+/**
+* @brief Give a unique file name to each texture of a folder, in memory, without looking at the files on the disk
+* @brief Names are not case sensitive like on Windows, a number is added to the names already used: "name (1).png"
+* @brief Use one registry per folder and register the textures in the same order to always get the same names
+*/
+class TextureNameRegistry
+{
+public:
+	/**
+	* @brief Get a file name that is not used yet, the files of the alternate palettes ("name_Clut1.png") are reserved with it
+	* @param name Name of the texture without extension
+	* @param extension Extension with the dot (".png")
+	* @param alternatePaletteCount Number of "_Clut" files written next to the texture file
+	* @return The file name with the extension
+	*/
+	std::string Register(const std::string& name, const std::string& extension, size_t alternatePaletteCount);
+
+	/**
+	* @brief Get the suffix of the file of an alternate palette ("_Clut1")
+	* @param paletteIndex Index of the palette, from 1
+	*/
+	static std::string GetPaletteSuffix(size_t paletteIndex);
+
+private:
+	std::unordered_set<std::string> m_usedFileNames; // Lower case
+	std::unordered_map<std::string, size_t> m_nextNumbers; // Number to try first for a lower case name and extension, all lower numbers are used
+};
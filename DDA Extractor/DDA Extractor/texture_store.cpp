@@ -0,0 +1,75 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "texture_store.h"
+
+#include <filesystem>
+
+bool TextureStore::Claim(uint64_t contentHash, const std::string& filePath, std::string& sourceFilePath)
+{
+	std::unique_lock<std::mutex> lock(m_mutex);
+
+	// The writer of the content is always running (it claimed it just before writing), so waiting cannot block forever
+	auto entry = m_entries.find(contentHash);
+	while (entry != m_entries.end() && !entry->second.isWritten)
+	{
+		m_writtenCondition.wait(lock);
+		entry = m_entries.find(contentHash);
+	}
+
+	if (entry != m_entries.end())
+	{
+		sourceFilePath = entry->second.filePath;
+		return false;
+	}
+
+	Entry& newEntry = m_entries[contentHash];
+	newEntry.filePath = filePath;
+	return true;
+}
+
+void TextureStore::Complete(uint64_t contentHash, bool success)
+{
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		if (success)
+		{
+			m_entries[contentHash].isWritten = true;
+		}
+		else
+		{
+			m_entries.erase(contentHash);
+		}
+	}
+	m_writtenCondition.notify_all();
+}
+
+void TextureStore::Add(uint64_t contentHash, const std::string& filePath)
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	Entry entry;
+	entry.filePath = filePath;
+	entry.isWritten = true;
+	m_entries.emplace(contentHash, entry);
+}
+
+void TextureStore::Clear()
+{
+	std::lock_guard<std::mutex> lock(m_mutex);
+	m_entries.clear();
+}
+
+bool TextureStore::CreateFileLink(const std::string& sourceFilePath, const std::string& filePath)
+{
+	std::error_code error;
+	std::filesystem::create_hard_link(sourceFilePath, filePath, error);
+	if (error)
+	{
+		error.clear();
+		std::filesystem::copy_file(sourceFilePath, filePath, std::filesystem::copy_options::overwrite_existing, error);
+	}
+	return !error;
+}
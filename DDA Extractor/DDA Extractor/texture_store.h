@@ -0,0 +1,65 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+* @brief Texture files written during an extraction or kept from a previous one, by content hash (see DDATextureCopyParams::contentHash)
+* @brief Many textures are in several game files (BRONX and BRON_2ND for example), each content is written once and the other files get a link to it
+* @brief Thread safe, shared by all game files extracted at the same time
+*/
+class TextureStore
+{
+public:
+	/**
+	* @brief Find the file of a texture content or register a new one
+	* @brief If another thread is writing the same content, wait until it's written
+	* @param filePath File that will be written by the caller if the content is new
+	* @param sourceFilePath Set to the file that already has this content
+	* @return True if the content is new: the caller writes filePath and calls Complete
+	*/
+	bool Claim(uint64_t contentHash, const std::string& filePath, std::string& sourceFilePath);
+
+	/**
+	* @brief Tell that the file of a claimed content is written
+	* @param success False if the file could not be written, the next texture with this content will be written again
+	*/
+	void Complete(uint64_t contentHash, bool success);
+
+	/**
+	* @brief Register a file written by a previous run (game file up to date), so the textures extracted in this run can be linked to it
+	* @brief Does nothing if the content already has a file
+	*/
+	void Add(uint64_t contentHash, const std::string& filePath);
+
+	/**
+	* @brief Forget all files, to call when the options of the texture files change
+	*/
+	void Clear();
+
+	/**
+	* @brief Create filePath as a hardlink of sourceFilePath, or as a copy if hardlinks are not supported (FAT32 drive, different drives...)
+	* @return False if the file cannot be created
+	*/
+	static bool CreateFileLink(const std::string& sourceFilePath, const std::string& filePath);
+
+private:
+	struct Entry
+	{
+		std::string filePath;
+		bool isWritten = false;
+	};
+
+	std::mutex m_mutex;
+	std::condition_variable m_writtenCondition;
+	std::unordered_map<uint64_t, Entry> m_entries;
+};
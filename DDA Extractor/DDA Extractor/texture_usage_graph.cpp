@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "texture_usage_graph.h"
+
+#include <algorithm>
+#include <fstream>
+
+#include "json_utils.h"
+
+TextureUsageGraph::TextureUsageGraph(const DDAExtractedData& data)
+	: m_usedTextures(data.textureCopyParamsList.size(), false), m_packetCount(data.packetAndTextureEntryList.size())
+{
+	// The first materials are the ones of the texture table entries
+	size_t entryCount = 0;
+	for (const DDATextureTable& textureTable : data.textureTables)
+	{
+		entryCount += textureTable.entries.size();
+	}
+	m_entryPackets.resize(std::min(entryCount, data.materials.size()));
+
+	for (size_t packetIndex = 0; packetIndex < data.packetAndTextureEntryList.size(); packetIndex++)
+	{
+		const size_t entryIndex = data.packetAndTextureEntryList[packetIndex].textureIndex;
+		if (entryIndex < m_entryPackets.size())
+		{
+			m_entryPackets[entryIndex].push_back(packetIndex);
+		}
+	}
+
+	// The textures of an entry are from the texture of its material to the texture of the next material
+	for (size_t entryIndex = 0; entryIndex < m_entryPackets.size(); entryIndex++)
+	{
+		const size_t firstTexture = data.materials[entryIndex].textureIndex;
+		if (m_entryPackets[entryIndex].empty() || firstTexture >= m_usedTextures.size())
+		{
+			continue;
+		}
+
+		size_t lastTexture = m_usedTextures.size();
+		if (entryIndex + 1 < data.materials.size() && data.materials[entryIndex + 1].textureIndex < lastTexture)
+		{
+			lastTexture = data.materials[entryIndex + 1].textureIndex;
+		}
+		for (size_t textureIndex = firstTexture; textureIndex < lastTexture; textureIndex++)
+		{
+			m_usedTextures[textureIndex] = true;
+		}
+	}
+
+	// The first frame textures of the animated textures are added for the meshes using them (see DDAFileParser::ScaleAnimatedTextureUVs)
+	for (const DDAMesh& mesh : data.meshes)
+	{
+		for (const DDASubMesh& subMesh : mesh.subMeshes)
+		{
+			if (subMesh.materialIndex >= m_entryPackets.size() && subMesh.materialIndex < data.materials.size() && data.materials[subMesh.materialIndex].textureIndex < m_usedTextures.size())
+			{
+				m_usedTextures[data.materials[subMesh.materialIndex].textureIndex] = true;
+			}
+		}
+	}
+}
+
+bool TextureUsageGraph::IsTextureUsed(size_t textureIndex) const
+{
+	return textureIndex < m_usedTextures.size() && m_usedTextures[textureIndex];
+}
+
+bool TextureUsageGraph::Write(const DDAExtractedData& data, const std::vector<std::string>& textureFilePaths, const std::string& exportFolder) const
+{
+	std::ofstream file(exportFolder + TEXTURE_USAGE_FILE_NAME, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		return false;
+	}
+
+	file << "{\n";
+	file << "\t\"textures\": [";
+	for (size_t entryIndex = 0; entryIndex < m_entryPackets.size(); entryIndex++)
+	{
+		const DDAMaterial& material = data.materials[entryIndex];
+		const std::vector<size_t>& packets = m_entryPackets[entryIndex];
+		file << (entryIndex == 0 ? "\n" : ",\n");
+		file << "\t\t{ \"index\": " << entryIndex << ", \"name\": \"" << JsonUtils::EscapeString(material.name) << "\"";
+		if (material.textureIndex < textureFilePaths.size())
+		{
+			file << ", \"path\": \"" << JsonUtils::EscapeString(textureFilePaths[material.textureIndex].substr(exportFolder.size())) << "\"";
+		}
+		file << ", \"references\": " << packets.size() << ", \"packets\": [";
+		for (size_t i = 0; i < packets.size(); i++)
+		{
+			file << (i == 0 ? " " : ", ") << packets[i];
+		}
+		file << " ] }";
+	}
+	file << "\n\t],\n";
+
+	file << "\t\"packets\": [";
+	for (size_t packetIndex = 0; packetIndex < data.packetAndTextureEntryList.size(); packetIndex++)
+	{
+		const DDAPacketAndTextureEntry& packet = data.packetAndTextureEntryList[packetIndex];
+		file << (packetIndex == 0 ? "\n" : ",\n");
+		file << "\t\t{ \"address\": " << packet.vifPacketListAddr << ", \"texture\": " << packet.textureIndex << " }";
+	}
+	file << "\n\t]\n";
+	file << "}\n";
+
+	return file.good();
+}
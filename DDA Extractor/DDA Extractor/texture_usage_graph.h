@@ -0,0 +1,48 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "dda_structures.h"
+
+// File in the export folder of the maps and cars with the textures used by each mesh packet
+constexpr const char* TEXTURE_USAGE_FILE_NAME = "texture_usage.json";
+
+/**
+* @brief Link the mesh packets of a file to the texture table entries they use (see DDAExtractedData::packetAndTextureEntryList)
+* @brief Only the maps and cars have mesh packets, the other files use all their textures
+*/
+class TextureUsageGraph
+{
+public:
+	explicit TextureUsageGraph(const DDAExtractedData& data);
+
+	/**
+	* @brief Check if the file has mesh packets, without them no texture is referenced
+	*/
+	bool HasPackets() const { return m_packetCount != 0; }
+
+	/**
+	* @brief Check if a texture of DDAExtractedData::textureCopyParamsList is used by a mesh packet
+	* @brief All textures of a used entry are used (the broken car skin is in the same entry as the car skin)
+	*/
+	bool IsTextureUsed(size_t textureIndex) const;
+
+	/**
+	* @brief Write the reference count and the packets of each texture table entry, then the texture of each packet
+	* @param textureFilePaths File of each texture in exportFolder, see TextureDumper::GetTextureFilePaths
+	* @return False if the file cannot be written
+	*/
+	bool Write(const DDAExtractedData& data, const std::vector<std::string>& textureFilePaths, const std::string& exportFolder) const;
+
+private:
+	std::vector<std::vector<size_t>> m_entryPackets; // Packets using each texture table entry, an entry has one material in DDAExtractedData::materials
+	std::vector<bool> m_usedTextures;
+	size_t m_packetCount = 0;
+};
@@ -0,0 +1,124 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "trace_recorder.h"
+
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <vector>
+
+#include "json_utils.h"
+
+namespace
+{
+	struct TraceEvent
+	{
+		const char* name = nullptr;
+		std::string detail;
+		int64_t startMicroseconds = 0;
+		int64_t durationMicroseconds = 0;
+	};
+
+	// Events of one thread, only this thread adds events so no lock is needed
+	struct ThreadEvents
+	{
+		uint32_t threadId = 0;
+		std::vector<TraceEvent> events;
+	};
+
+	std::chrono::steady_clock::time_point traceStartTime;
+
+	// Buffers are kept after the end of their thread until the trace is written
+	std::mutex threadEventsMutex;
+	std::list<ThreadEvents> threadEventsList;
+	thread_local ThreadEvents* currentThreadEvents = nullptr;
+
+	ThreadEvents& GetCurrentThreadEvents()
+	{
+		if (!currentThreadEvents)
+		{
+			std::lock_guard<std::mutex> lock(threadEventsMutex);
+			ThreadEvents& threadEvents = threadEventsList.emplace_back();
+			threadEvents.threadId = static_cast<uint32_t>(threadEventsList.size());
+			currentThreadEvents = &threadEvents;
+		}
+		return *currentThreadEvents;
+	}
+
+	int64_t ToMicroseconds(std::chrono::steady_clock::duration duration)
+	{
+		return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+	}
+
+}
+
+void TraceRecorder::SetEnabled(bool enabled)
+{
+	if (enabled && !s_enabled)
+	{
+		traceStartTime = std::chrono::steady_clock::now();
+	}
+	s_enabled = enabled;
+}
+
+void TraceRecorder::ScopedEvent::Start(const char* name, const std::string& detail)
+{
+	m_name = name;
+	m_detail = detail;
+	m_started = true;
+	m_startTime = std::chrono::steady_clock::now();
+}
+
+void TraceRecorder::ScopedEvent::Stop()
+{
+	const std::chrono::steady_clock::time_point endTime = std::chrono::steady_clock::now();
+
+	TraceEvent& event = GetCurrentThreadEvents().events.emplace_back();
+	event.name = m_name;
+	event.detail = std::move(m_detail);
+	event.startMicroseconds = ToMicroseconds(m_startTime - traceStartTime);
+	event.durationMicroseconds = ToMicroseconds(endTime - m_startTime);
+	m_started = false;
+}
+
+bool TraceRecorder::WriteJson(const std::string& filePath)
+{
+	std::ofstream file(filePath, std::ios::out | std::ios::trunc);
+	if (!file.is_open())
+	{
+		std::cout << "[ERROR] File not created: " + filePath << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(threadEventsMutex);
+
+	// Complete events ("X") with a name for each thread ("M")
+	file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool firstEvent = true;
+	for (const ThreadEvents& threadEvents : threadEventsList)
+	{
+		file << (firstEvent ? "" : ",\n");
+		firstEvent = false;
+		file << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << threadEvents.threadId << ",\"args\":{\"name\":\"Thread " << threadEvents.threadId << "\"}}";
+
+		for (const TraceEvent& event : threadEvents.events)
+		{
+			file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << threadEvents.threadId;
+			file << ",\"ts\":" << event.startMicroseconds << ",\"dur\":" << event.durationMicroseconds;
+			if (!event.detail.empty())
+			{
+				file << ",\"args\":{\"detail\":\"" << JsonUtils::EscapeString(event.detail) << "\"}";
+			}
+			file << "}";
+		}
+	}
+	file << "\n]}\n";
+
+	return file.good();
+}
@@ -0,0 +1,72 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <string>
+#include <chrono>
+
+/**
+* @brief Record a timeline of the extraction in the Chrome trace event format (chrome://tracing, ui.perfetto.dev)
+* @brief Disabled by default, when disabled the events only check a bool
+*/
+class TraceRecorder
+{
+public:
+	/**
+	* @brief Enable or disable the recording, must be called before the extraction starts
+	*/
+	static void SetEnabled(bool enabled);
+	static bool IsEnabled() { return s_enabled; }
+
+	/**
+	* @brief Write all recorded events in a JSON file
+	* @return False if the file cannot be created
+	*/
+	static bool WriteJson(const std::string& filePath);
+
+	/**
+	* @brief Record a span from the creation to the destruction of the object on the current thread
+	*/
+	class ScopedEvent
+	{
+	public:
+		/**
+		* @param name Name of the span, must be a string literal
+		* @param detail Shown in the span arguments (file name, texture name...), only copied when the recording is enabled
+		*/
+		explicit ScopedEvent(const char* name, const std::string& detail = std::string())
+		{
+			if (s_enabled)
+			{
+				Start(name, detail);
+			}
+		}
+
+		~ScopedEvent()
+		{
+			if (m_started)
+			{
+				Stop();
+			}
+		}
+
+		ScopedEvent(const ScopedEvent&) = delete;
+		ScopedEvent& operator=(const ScopedEvent&) = delete;
+
+	private:
+		void Start(const char* name, const std::string& detail);
+		void Stop();
+
+		const char* m_name = nullptr;
+		std::string m_detail;
+		bool m_started = false;
+		std::chrono::steady_clock::time_point m_startTime;
+	};
+
+private:
+	static inline bool s_enabled = false;
+};
@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#include "worker_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+size_t WorkerPool::GetWorkerCount(size_t itemCount, size_t workerCount)
+{
+	if (workerCount == 0)
+	{
+		workerCount = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+	}
+
+	return std::max<size_t>(std::min(workerCount, itemCount), 1);
+}
+
+void WorkerPool::ParallelFor(size_t itemCount, size_t workerCount, const std::function<void(size_t itemIndex, size_t workerIndex)>& job)
+{
+	if (itemCount == 0)
+	{
+		return;
+	}
+
+	workerCount = GetWorkerCount(itemCount, workerCount);
+
+	// No need to create threads
+	if (workerCount == 1)
+	{
+		for (size_t i = 0; i < itemCount; i++)
+		{
+			job(i, 0);
+		}
+		return;
+	}
+
+	// Items are given in order, so the caller can put the longest jobs first
+	std::atomic<size_t> nextItem = 0;
+	const auto workerLoop = [&](size_t workerIndex)
+		{
+			size_t itemIndex = nextItem.fetch_add(1);
+			while (itemIndex < itemCount)
+			{
+				job(itemIndex, workerIndex);
+				itemIndex = nextItem.fetch_add(1);
+			}
+		};
+
+	std::vector<std::thread> threads;
+	threads.reserve(workerCount - 1);
+	for (size_t workerIndex = 1; workerIndex < workerCount; workerIndex++)
+	{
+		threads.emplace_back(workerLoop, workerIndex);
+	}
+
+	// The calling thread is the worker 0
+	workerLoop(0);
+
+	for (std::thread& thread : threads)
+	{
+		thread.join();
+	}
+}
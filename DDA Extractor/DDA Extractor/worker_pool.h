@@ -0,0 +1,26 @@
+// SPDX-License-Identifier: MIT
+//
+// Copyright (c) 2025-2025 Gregory Machefer (Fewnity)
+//
+// This file is part of DDA Extractor.
+
+#pragma once
+
+#include <functional>
+
+class WorkerPool
+{
+public:
+	/**
+	* @brief Run a job for each item on a set of worker threads, each worker pulls the next item when it's free
+	* @param itemCount Number of items to process
+	* @param workerCount Number of threads to use (0 = one per hardware thread), the calling thread is used if it's 1
+	* @param job Function called with the item index and the index of the worker that runs it
+	*/
+	static void ParallelFor(size_t itemCount, size_t workerCount, const std::function<void(size_t itemIndex, size_t workerIndex)>& job);
+
+	/**
+	* @brief Get the number of workers that will really be used for a job
+	*/
+	static size_t GetWorkerCount(size_t itemCount, size_t workerCount);
+};